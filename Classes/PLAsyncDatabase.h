@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <dispatch/dispatch.h>
+
+#import "PLDatabase.h"
+
+@interface PLAsyncDatabase : NSObject {
+@private
+    /** The backing database connection. Must only be accessed from _queue. */
+    id<PLDatabase> _database;
+
+    /** The serial queue on which all database operations are performed. */
+    dispatch_queue_t _queue;
+}
+
+- (id) initWithDatabase: (id<PLDatabase>) database;
+
+- (void) performBlock: (void (^)(id<PLDatabase> db)) block;
+- (void) performBlockAndWait: (void (^)(id<PLDatabase> db)) block;
+
+- (void) executeUpdate: (NSString *) statement
+            parameters: (NSArray *) parameters
+            completion: (void (^)(BOOL success, NSError *error)) completion;
+
+- (void) executeQuery: (NSString *) statement
+           parameters: (NSArray *) parameters
+                block: (void (^)(id<PLResultSet> rs, NSError *error)) block;
+
+- (void) performTransactionWithRetryBlock: (PLDatabaseTransactionResult (^)(id<PLDatabase> db)) block
+                               completion: (void (^)(BOOL success, NSError *error)) completion;
+
+- (void) close;
+
+/** The serial dispatch queue on which all operations on the backing database are performed. */
+@property(nonatomic, readonly) dispatch_queue_t queue;
+
+@end
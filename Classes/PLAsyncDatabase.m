@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLAsyncDatabase.h"
+
+/**
+ * @internal
+ * Return an error describing a parameter binding exception raised while executing @a statement. Binding errors
+ * raise; there's no caller on the connection's queue to receive the exception, so it is reported as the operation's
+ * error instead.
+ */
+static NSError *pl_async_bind_error (NSException *e, NSString *statement) {
+    return [PlausibleDatabase errorWithCode: PLDatabaseErrorInvalidStatement
+                       localizedDescription: [e reason]
+                                queryString: statement
+                                vendorError: nil
+                          vendorErrorString: nil];
+}
+
+/**
+ * An asynchronous facade over a PLDatabase connection.
+ *
+ * All operations are serialized onto a serial dispatch queue owned by the instance, and return to the caller
+ * immediately; a calling thread may enqueue several operations without waiting on each in turn. Completion blocks
+ * are executed on the connection's queue, in the order in which their operations were enqueued, and should not
+ * perform lengthy work; dispatch such work to another queue.
+ *
+ * @par Thread Safety
+ * Thread-safe. The backing database must not be accessed other than through the PLAsyncDatabase instance.
+ */
+@implementation PLAsyncDatabase
+
+@synthesize queue = _queue;
+
+/**
+ * Initialize a new instance with an open @a database.
+ *
+ * @param database An open database connection. The connection will be retained, and must not be accessed
+ * other than through the returned instance.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLAsyncDatabase class.
+ */
+- (id) initWithDatabase: (id<PLDatabase>) database {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _database = [database retain];
+    _queue = dispatch_queue_create("com.plausiblelabs.database.async", NULL);
+
+    return self;
+}
+
+- (void) dealloc {
+    /* Every enqueued block retains the receiver; if we've reached dealloc, the queue is empty. */
+    [_database release];
+    dispatch_release(_queue);
+
+    [super dealloc];
+}
+
+/**
+ * Asynchronously execute @a block on the connection's queue.
+ *
+ * @param block The block to execute. The block is provided the backing database, which must not be retained or
+ * accessed outside of the block.
+ */
+- (void) performBlock: (void (^)(id<PLDatabase> db)) block {
+    block = [[block copy] autorelease];
+    dispatch_async(_queue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        block(_database);
+        [pool drain];
+    });
+}
+
+/**
+ * Synchronously execute @a block on the connection's queue, waiting for all previously enqueued operations to
+ * complete.
+ *
+ * @param block The block to execute. The block is provided the backing database, which must not be retained or
+ * accessed outside of the block.
+ *
+ * @warning Must not be called from a block executing on the connection's queue.
+ */
+- (void) performBlockAndWait: (void (^)(id<PLDatabase> db)) block {
+    dispatch_sync(_queue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        block(_database);
+        [pool drain];
+    });
+}
+
+/**
+ * Asynchronously execute an update.
+ *
+ * @param statement The SQL statement to execute.
+ * @param parameters The statement's parameters, bound as per PLPreparedStatement::bindParameters:, or nil.
+ * @param completion Block to be executed on the connection's queue with the result of the update, or nil. If
+ * the update fails, @a error describes the failure.
+ */
+- (void) executeUpdate: (NSString *) statement
+            parameters: (NSArray *) parameters
+            completion: (void (^)(BOOL success, NSError *error)) completion
+{
+    [self performBlock: ^(id<PLDatabase> db) {
+        NSError *error = nil;
+        BOOL success = NO;
+
+        id<PLPreparedStatement> stmt = [db prepareStatement: statement error: &error];
+        if (stmt != nil) {
+            @try {
+                if (parameters != nil)
+                    [stmt bindParameters: parameters];
+                success = [stmt executeUpdateAndReturnError: &error];
+            } @catch (NSException *e) {
+                error = pl_async_bind_error(e, statement);
+            } @finally {
+                [stmt close];
+            }
+        }
+
+        if (completion != nil)
+            completion(success, success ? nil : error);
+    }];
+}
+
+/**
+ * Asynchronously execute a query.
+ *
+ * @param statement The SQL statement to execute.
+ * @param parameters The statement's parameters, bound as per PLPreparedStatement::bindParameters:, or nil.
+ * @param block Block to be executed on the connection's queue with the query's result set. If the query could not
+ * be executed, the result set will be nil, and @a error will describe the failure. The result set is only valid
+ * within the block, and will be closed when the block returns.
+ */
+- (void) executeQuery: (NSString *) statement
+           parameters: (NSArray *) parameters
+                block: (void (^)(id<PLResultSet> rs, NSError *error)) block
+{
+    [self performBlock: ^(id<PLDatabase> db) {
+        NSError *error = nil;
+        id<PLResultSet> rs = nil;
+
+        id<PLPreparedStatement> stmt = [db prepareStatement: statement error: &error];
+
+        @try {
+            if (stmt != nil) {
+                @try {
+                    if (parameters != nil)
+                        [stmt bindParameters: parameters];
+                    rs = [stmt executeQueryAndReturnError: &error];
+                } @catch (NSException *e) {
+                    error = pl_async_bind_error(e, statement);
+                }
+            }
+
+            block(rs, rs != nil ? nil : error);
+        } @finally {
+            [rs close];
+            [stmt close];
+        }
+    }];
+}
+
+/**
+ * Asynchronously execute @a block within a transaction, as per PLDatabase::performTransactionWithRetryBlock:error:.
+ *
+ * @param block The transaction block. The block is provided the backing database, which must not be retained or
+ * accessed outside of the block. As with PLDatabase::performTransactionWithRetryBlock:error:, the block may be
+ * executed multiple times, and must be idempotent.
+ * @param completion Block to be executed on the connection's queue once the transaction has been committed or
+ * rolled back, or nil. If the transaction could not be committed or rolled back, @a error describes the failure.
+ */
+- (void) performTransactionWithRetryBlock: (PLDatabaseTransactionResult (^)(id<PLDatabase> db)) block
+                               completion: (void (^)(BOOL success, NSError *error)) completion
+{
+    [self performBlock: ^(id<PLDatabase> db) {
+        NSError *error = nil;
+        BOOL success = [db performTransactionWithRetryBlock: ^{
+            return block(db);
+        } error: &error];
+
+        if (completion != nil)
+            completion(success, success ? nil : error);
+    }];
+}
+
+/**
+ * Asynchronously close the backing database, once all previously enqueued operations have completed.
+ */
+- (void) close {
+    [self performBlock: ^(id<PLDatabase> db) {
+        [db close];
+    }];
+}
+
+@end
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PlausibleDatabase.h"
+
+@interface PLAsyncDatabaseTests : SenTestCase {
+@private
+    PLAsyncDatabase *_db;
+}
+
+@end
+
+@implementation PLAsyncDatabaseTests
+
+- (void) setUp {
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db open], @"Couldn't open the test database");
+
+    _db = [[PLAsyncDatabase alloc] initWithDatabase: db];
+}
+
+- (void) tearDown {
+    [_db close];
+    [_db release];
+}
+
+/* Operations must be executed in order, and may be pipelined without waiting */
+- (void) testExecuteUpdateAndQuery {
+    __block BOOL createSuccess = NO;
+    __block int insertCount = 0;
+    __block int rowCount = 0;
+
+    [_db executeUpdate: @"CREATE TABLE test (a integer)" parameters: nil completion: ^(BOOL success, NSError *error) {
+        createSuccess = success;
+    }];
+
+    for (int i = 0; i < 10; i++) {
+        [_db executeUpdate: @"INSERT INTO test (a) VALUES (?)" parameters: [NSArray arrayWithObject: [NSNumber numberWithInt: i]] completion: ^(BOOL success, NSError *error) {
+            if (success)
+                insertCount++;
+        }];
+    }
+
+    [_db executeQuery: @"SELECT a FROM test WHERE a >= ?" parameters: [NSArray arrayWithObject: [NSNumber numberWithInt: 5]] block: ^(id<PLResultSet> rs, NSError *error) {
+        while ([rs nextAndReturnError: NULL] == PLResultSetStatusRow)
+            rowCount++;
+    }];
+
+    /* Wait for the enqueued operations */
+    [_db performBlockAndWait: ^(id<PLDatabase> db) {}];
+
+    STAssertTrue(createSuccess, @"Create table failed");
+    STAssertEquals(10, insertCount, @"Not all inserts succeeded");
+    STAssertEquals(5, rowCount, @"Incorrect number of rows returned");
+}
+
+- (void) testErrorHandling {
+    __block NSError *updateError = nil;
+    __block NSError *queryError = nil;
+    __block BOOL queryResultSet = YES;
+
+    [_db executeUpdate: @"INSERT INTO missing (a) VALUES (1)" parameters: nil completion: ^(BOOL success, NSError *error) {
+        updateError = [error retain];
+    }];
+
+    [_db executeQuery: @"SELECT * FROM missing" parameters: nil block: ^(id<PLResultSet> rs, NSError *error) {
+        queryResultSet = (rs != nil);
+        queryError = [error retain];
+    }];
+
+    [_db performBlockAndWait: ^(id<PLDatabase> db) {}];
+
+    STAssertNotNil(updateError, @"No update error was provided");
+    STAssertNotNil(queryError, @"No query error was provided");
+    STAssertFalse(queryResultSet, @"A result set was provided for a failed query");
+
+    [updateError release];
+    [queryError release];
+}
+
+/* Parameter binding exceptions must be reported as errors, rather than raised on the connection's queue */
+- (void) testBindingErrorHandling {
+    __block NSError *updateError = nil;
+    __block NSError *queryError = nil;
+    __block BOOL queryResultSet = YES;
+
+    [_db executeUpdate: @"CREATE TABLE test (a integer, b integer)" parameters: nil completion: nil];
+
+    NSArray *tooFew = [NSArray arrayWithObject: [NSNumber numberWithInt: 1]];
+    [_db executeUpdate: @"INSERT INTO test (a, b) VALUES (?, ?)" parameters: tooFew completion: ^(BOOL success, NSError *error) {
+        updateError = [error retain];
+    }];
+
+    [_db executeQuery: @"SELECT * FROM test WHERE a = ? AND b = ?" parameters: tooFew block: ^(id<PLResultSet> rs, NSError *error) {
+        queryResultSet = (rs != nil);
+        queryError = [error retain];
+    }];
+
+    /* The statements must have been closed; the connection remains usable */
+    __block BOOL inserted = NO;
+    [_db performBlockAndWait: ^(id<PLDatabase> db) {
+        inserted = [db executeUpdate: @"INSERT INTO test (a, b) VALUES (1, 2)"];
+    }];
+
+    STAssertEquals(PLDatabaseErrorInvalidStatement, (PLDatabaseError) [updateError code], @"Incorrect update error: %@", updateError);
+    STAssertEquals(PLDatabaseErrorInvalidStatement, (PLDatabaseError) [queryError code], @"Incorrect query error: %@", queryError);
+    STAssertFalse(queryResultSet, @"A result set was provided for a failed query");
+    STAssertTrue(inserted, @"Connection was not usable after a binding error");
+
+    [updateError release];
+    [queryError release];
+}
+
+- (void) testPerformTransaction {
+    __block BOOL committed = NO;
+    __block int count = 0;
+
+    [_db executeUpdate: @"CREATE TABLE test (a integer)" parameters: nil completion: nil];
+
+    [_db performTransactionWithRetryBlock: ^(id<PLDatabase> db) {
+        [db executeUpdate: @"INSERT INTO test (a) VALUES (1)"];
+        return PLDatabaseTransactionCommit;
+    } completion: ^(BOOL success, NSError *error) {
+        committed = success;
+    }];
+
+    [_db performTransactionWithRetryBlock: ^(id<PLDatabase> db) {
+        [db executeUpdate: @"INSERT INTO test (a) VALUES (2)"];
+        return PLDatabaseTransactionRollback;
+    } completion: nil];
+
+    [_db performBlockAndWait: ^(id<PLDatabase> db) {
+        id<PLResultSet> rs = [db executeQuery: @"SELECT COUNT(*) FROM test"];
+        [rs next];
+        count = [rs intForColumnIndex: 0];
+        [rs close];
+    }];
+
+    STAssertTrue(committed, @"Transaction was not committed");
+    STAssertEquals(1, count, @"Rolled back transaction was applied");
+}
+
+@end
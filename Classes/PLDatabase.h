@@ -57,7 +57,14 @@ typedef enum {
      * other transactions cannot insert new rows with values that would fall into the range of rows read by any
      * statement in the current transaction until the current transaction complets.
      */
-    PLDatabaseIsolationLevelSerializable = 3
+    PLDatabaseIsolationLevelSerializable = 3,
+
+    /**
+     * Provides at least 'Read committed' isolation, and acquires the database write lock when the transaction begins,
+     * rather than at the first write. Write transactions that begin with this level can't deadlock on a lock upgrade
+     * midway through the transaction; any contention is encountered, and retried, before the transaction block runs.
+     */
+    PLDatabaseIsolationLevelImmediate = 4
 } PLDatabaseIsolationLevel;
 
 typedef enum {
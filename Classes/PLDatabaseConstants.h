@@ -55,6 +55,9 @@ typedef enum {
     
     /** The provided SQL statement was invalid. */
     PLDatabaseErrorInvalidStatement = 3,
+
+    /** The operation timed out while waiting for a resource, such as a pooled database connection. */
+    PLDatabaseErrorTimedOut = 4,
 } PLDatabaseError;
 
 #ifdef PL_DB_PRIVATE
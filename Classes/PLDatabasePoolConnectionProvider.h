@@ -29,9 +29,13 @@
 
 #import <Foundation/Foundation.h>
 #import <pthread.h>
+#import <dispatch/dispatch.h>
 
 #import "PLDatabaseConnectionProvider.h"
 
+/* A thread waiting on a bounded pool */
+struct pl_pool_waiter;
+
 @interface PLDatabasePoolConnectionProvider : NSObject <PLDatabaseConnectionProvider> {
 @private
     /** Lock that must be held when mutating internal state. */
@@ -45,8 +49,63 @@
 
     /** The maximum number of connections that may be cached by this pool. */
     NSUInteger _capacity;
+
+    /** The maximum number of live connections, or 0 if unbounded. */
+    NSUInteger _maxConnections;
+
+    /** The maximum time to wait for a connection when the pool is exhausted; negative to wait indefinitely. */
+    NSTimeInterval _acquireTimeout;
+
+    /** The number of live connections, including checked out, idle, and opening connections. */
+    NSUInteger _liveConnections;
+
+    /** Head and tail of the FIFO queue of threads waiting for a connection. */
+    struct pl_pool_waiter *_waitersHead;
+    struct pl_pool_waiter *_waitersTail;
+
+    /** The number of idle connections to open at construction. */
+    NSUInteger _minIdle;
+
+    /** SQL statements to be prepared on each warm-up connection, or nil. */
+    NSArray *_warmupStatements;
+
+    /** Group tracking the background warm-up. */
+    dispatch_group_t _warmupGroup;
 }
 
 - (id) initWithConnectionProvider: (id<PLDatabaseConnectionProvider>) provider capacity: (NSUInteger) capacity;
 
+- (id) initWithConnectionProvider: (id<PLDatabaseConnectionProvider>) provider
+                         capacity: (NSUInteger) capacity
+                   maxConnections: (NSUInteger) maxConnections
+                   acquireTimeout: (NSTimeInterval) acquireTimeout;
+
+- (id) initWithConnectionProvider: (id<PLDatabaseConnectionProvider>) provider
+                         capacity: (NSUInteger) capacity
+                   maxConnections: (NSUInteger) maxConnections
+                   acquireTimeout: (NSTimeInterval) acquireTimeout
+                          minIdle: (NSUInteger) minIdle
+                 warmupStatements: (NSArray *) warmupStatements;
+
+- (void) waitForWarmup;
+
+/** The maximum number of live connections, or 0 if unbounded. */
+@property(nonatomic, readonly) NSUInteger maxConnections;
+
+/** The maximum time to wait for a connection when the pool is exhausted; negative to wait indefinitely. */
+@property(nonatomic, readonly) NSTimeInterval acquireTimeout;
+
+/** The number of idle connections opened in the background at construction. */
+@property(nonatomic, readonly) NSUInteger minIdle;
+
+@end
+
+#ifdef PL_DB_PRIVATE
+
+@interface PLDatabasePoolConnectionProvider (PLDatabasePoolConnectionProviderLibraryPrivate)
+
+- (NSUInteger) waiterCount;
+
 @end
+
+#endif /* PL_DB_PRIVATE */
@@ -29,14 +29,60 @@
 
 #import "PLDatabasePoolConnectionProvider.h"
 
+#import <sys/time.h>
+#import <errno.h>
+#import <math.h>
+
+/**
+ * @internal
+ * A thread waiting on a bounded pool. Waiters are allocated on the waiting thread's stack, and linked into the
+ * pool's FIFO waiter queue.
+ */
+struct pl_pool_waiter {
+    /** Signaled when the waiter is handed a connection or a connection slot. */
+    pthread_cond_t cond;
+
+    /** A connection handed to the waiter, or nil. */
+    id<PLDatabase> connection;
+
+    /** If YES, the waiter has been handed a free connection slot, and should open a new connection. */
+    BOOL slot;
+
+    /** The next waiter in the queue, or NULL. */
+    struct pl_pool_waiter *next;
+};
+
+@interface PLDatabasePoolConnectionProvider (PrivateMethods)
+- (id<PLDatabase>) openConnectionAndReturnError: (NSError **) outError;
+- (void) releaseSlot;
+- (void) removeWaiter: (struct pl_pool_waiter *) waiter;
+- (void) warmUp;
+@end
+
 /**
  * Provides a size-constrained thread-safe database connection pool.
  *
+ * @par Bounded Pools
+ * By default, the pool will open as many connections as are requested. If a maximum number of connections is
+ * specified, the pool will never hold more than that number of live connections (checked out and idle); once the
+ * maximum is reached, requests block until a connection is returned to the pool, or until the acquisition timeout
+ * expires, in which case the request fails with #PLDatabaseErrorTimedOut. Blocked requests are served in the
+ * order in which they were made.
+ *
+ * @par Warm-up
+ * A pool may be configured to open a minimum number of idle connections in the background at construction,
+ * optionally preparing a list of statements on each, so that the cost of opening connections and parsing common
+ * statements is paid before the first request, rather than on the request path.
+ *
  * @par Thread Safety
  * Thread-safe. May be used from any thread, subject to SQLite's documented thread-safety constraints.
  */
 @implementation PLDatabasePoolConnectionProvider
 
+@synthesize maxConnections = _maxConnections;
+@synthesize acquireTimeout = _acquireTimeout;
+@synthesize minIdle = _minIdle;
+
 /**
  * Initialize a new instance with the provided connection provider and capacity.
  *
@@ -46,11 +92,73 @@
  * specified, no capacity limit will be applied.
  */
 - (id) initWithConnectionProvider: (id<PLDatabaseConnectionProvider>) provider capacity: (NSUInteger) capacity {
+    return [self initWithConnectionProvider: provider capacity: capacity maxConnections: 0 acquireTimeout: -1];
+}
+
+/**
+ * Initialize a new instance with the provided connection provider, capacity, and live connection limit.
+ *
+ * @param provider A connection provider that will be used to acquire new database connections.
+ * @param capacity The maximum number of idle database connections that the pool will cache. If a capacity of 0 is
+ * specified, no capacity limit will be applied.
+ * @param maxConnections The maximum number of live connections that the pool will open. If a maximum of 0 is
+ * specified, no limit will be applied.
+ * @param acquireTimeout The maximum time, in seconds, that getConnectionAndReturnError: will wait for a connection
+ * once @a maxConnections connections are live. If 0, requests fail immediately; if negative, requests will wait
+ * indefinitely.
+ */
+- (id) initWithConnectionProvider: (id<PLDatabaseConnectionProvider>) provider
+                         capacity: (NSUInteger) capacity
+                   maxConnections: (NSUInteger) maxConnections
+                   acquireTimeout: (NSTimeInterval) acquireTimeout
+{
+    return [self initWithConnectionProvider: provider
+                                   capacity: capacity
+                             maxConnections: maxConnections
+                             acquireTimeout: acquireTimeout
+                                    minIdle: 0
+                           warmupStatements: nil];
+}
+
+/**
+ * Initialize a new instance, and begin opening @a minIdle connections in the background.
+ *
+ * @param provider A connection provider that will be used to acquire new database connections.
+ * @param capacity The maximum number of idle database connections that the pool will cache. If a capacity of 0 is
+ * specified, no capacity limit will be applied.
+ * @param maxConnections The maximum number of live connections that the pool will open. If a maximum of 0 is
+ * specified, no limit will be applied.
+ * @param acquireTimeout The maximum time, in seconds, that getConnectionAndReturnError: will wait for a connection
+ * once @a maxConnections connections are live. If 0, requests fail immediately; if negative, requests will wait
+ * indefinitely.
+ * @param minIdle The number of connections to open in the background. The number opened is limited by
+ * @a capacity and @a maxConnections.
+ * @param warmupStatements SQL statements to be prepared on each warm-up connection, or nil. If the backing
+ * connections cache prepared statements (as PLSqliteDatabase does), the prepared statements will be reused by
+ * later requests. Statements that fail to prepare are skipped.
+ *
+ * Connections opened by the warm-up are made available as soon as each is ready; requests that arrive before
+ * the warm-up completes are not delayed by it.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLDatabasePoolConnectionProvider class.
+ */
+- (id) initWithConnectionProvider: (id<PLDatabaseConnectionProvider>) provider
+                         capacity: (NSUInteger) capacity
+                   maxConnections: (NSUInteger) maxConnections
+                   acquireTimeout: (NSTimeInterval) acquireTimeout
+                          minIdle: (NSUInteger) minIdle
+                 warmupStatements: (NSArray *) warmupStatements
+{
     if ((self = [super init]) == nil)
         return nil;
     
     _provider = [provider retain];
     _capacity = capacity;
+    _maxConnections = maxConnections;
+    _acquireTimeout = acquireTimeout;
+    _minIdle = minIdle;
+    _warmupStatements = [warmupStatements copy];
 
     if (capacity > 0) {
         _connections = [[NSMutableSet alloc] initWithCapacity: capacity];
@@ -60,38 +168,120 @@
 
     pthread_mutex_init(&_lock, NULL);
 
+    /* Open the minimum idle connections in the background; the block retains the pool until it completes. */
+    _warmupGroup = dispatch_group_create();
+    if (minIdle > 0) {
+        dispatch_group_async(_warmupGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            [self warmUp];
+            [pool drain];
+        });
+    }
+
     return self;
 }
 
 - (void) dealloc {
     [_provider release];
     [_connections release];
+    [_warmupStatements release];
+    dispatch_release(_warmupGroup);
     
     pthread_mutex_destroy(&_lock);
 
     [super dealloc];
 }
 
+/**
+ * Block until the background warm-up started at construction has completed. Returns immediately if no warm-up was
+ * configured.
+ */
+- (void) waitForWarmup {
+    dispatch_group_wait(_warmupGroup, DISPATCH_TIME_FOREVER);
+}
+
 // from PLDatabaseConnectionProvider protocol
 - (id<PLDatabase>) getConnectionAndReturnError: (NSError **) outError {
     id<PLDatabase> db;
+    struct pl_pool_waiter waiter;
+    BOOL haveSlot = NO;
     
     pthread_mutex_lock(&_lock); {
         /* Try to fetch an existing connection */
         db = [[[_connections anyObject] retain] autorelease];
-        if (db != nil)
+        if (db != nil) {
             [_connections removeObject: db];
+            pthread_mutex_unlock(&_lock);
+            return db;
+        }
+
+        /* Claim a slot for a new connection. Idle connections are handed directly to waiters, so if any thread is
+         * waiting, the pool is exhausted; queue behind it rather than barging ahead. */
+        if (_maxConnections == 0 || (_liveConnections < _maxConnections && _waitersHead == NULL)) {
+            _liveConnections++;
+            pthread_mutex_unlock(&_lock);
+            return [self openConnectionAndReturnError: outError];
+        }
+
+        /* The pool is exhausted; wait for a connection or a free slot to be handed to us */
+        if (_acquireTimeout != 0) {
+            waiter.connection = nil;
+            waiter.slot = NO;
+            waiter.next = NULL;
+            pthread_cond_init(&waiter.cond, NULL);
+
+            if (_waitersTail != NULL)
+                _waitersTail->next = &waiter;
+            else
+                _waitersHead = &waiter;
+            _waitersTail = &waiter;
+
+            if (_acquireTimeout < 0) {
+                while (waiter.connection == nil && !waiter.slot)
+                    pthread_cond_wait(&waiter.cond, &_lock);
+            } else {
+                struct timeval now;
+                struct timespec deadline;
+                gettimeofday(&now, NULL);
+
+                long nsec = (long) now.tv_usec * 1000 + (long) ((_acquireTimeout - floor(_acquireTimeout)) * 1e9);
+                deadline.tv_sec = now.tv_sec + (time_t) floor(_acquireTimeout) + nsec / 1000000000;
+                deadline.tv_nsec = nsec % 1000000000;
+
+                while (waiter.connection == nil && !waiter.slot) {
+                    if (pthread_cond_timedwait(&waiter.cond, &_lock, &deadline) == ETIMEDOUT)
+                        break;
+                }
+            }
+
+            /* A hand-off may have raced the timeout; waiters are dequeued when handed a connection or slot */
+            if (waiter.connection == nil && !waiter.slot)
+                [self removeWaiter: &waiter];
+
+            pthread_cond_destroy(&waiter.cond);
+            db = [waiter.connection autorelease];
+            haveSlot = waiter.slot;
+        }
     } pthread_mutex_unlock(&_lock);
-    
-    
-    /* No existing connection could be acquired; try to create a new connection. This may fail, and we just report the
-     * error directly. We do this outside of the synchronized block to avoid any possibility of deadlock when calling
-     * out to our backing provider. */
-    if (db == nil) {
-        db = [_provider getConnectionAndReturnError: outError];
+
+    if (db != nil)
+        return db;
+
+    /* We've been handed a free slot; open a new connection. */
+    if (haveSlot)
+        return [self openConnectionAndReturnError: outError];
+
+    if (outError != NULL) {
+        NSString *desc = [NSString stringWithFormat: NSLocalizedString(@"Timed out waiting for one of %lu pooled database connections.", @""),
+                          (unsigned long) _maxConnections];
+        *outError = [PlausibleDatabase errorWithCode: PLDatabaseErrorTimedOut
+                                localizedDescription: desc
+                                         queryString: nil
+                                         vendorError: nil
+                                   vendorErrorString: nil];
     }
 
-    return db;
+    return nil;
 }
 
 
@@ -100,12 +290,19 @@
     BOOL shouldClose = NO;
 
     pthread_mutex_lock(&_lock); {
-        /* Check if we've hit capacity */ 
-        if (_capacity > 0 && [_connections count] >= _capacity) {
+        if (![connection goodConnection]) {
+            /* Connection is invalid */
             shouldClose = YES;
 
-        } else if (![connection goodConnection]) {
-            /* Connection is invalid */
+        } else if (_waitersHead != NULL) {
+            /* Hand the connection directly to the longest waiting thread */
+            struct pl_pool_waiter *waiter = _waitersHead;
+            [self removeWaiter: waiter];
+            waiter->connection = [connection retain];
+            pthread_cond_signal(&waiter->cond);
+
+        } else if (_capacity > 0 && [_connections count] >= _capacity) {
+            /* Check if we've hit capacity */ 
             shouldClose = YES;
 
         } else {
@@ -116,8 +313,143 @@
 
     /* We do this outside of the synchronized block to avoid any possibility of deadlock when calling
      * out to our backing provider. */
-    if (shouldClose)
+    if (shouldClose) {
         [_provider closeConnection: connection];
+        [self releaseSlot];
+    }
+}
+
+@end
+
+
+/**
+ * @internal
+ * Private methods.
+ */
+@implementation PLDatabasePoolConnectionProvider (PrivateMethods)
+
+/**
+ * Open a new connection via the backing provider. The caller must have claimed a connection slot, which will be
+ * released if the connection can not be opened.
+ *
+ * We do this outside of the synchronized block to avoid any possibility of deadlock when calling out to our backing
+ * provider.
+ */
+- (id<PLDatabase>) openConnectionAndReturnError: (NSError **) outError {
+    id<PLDatabase> db = [_provider getConnectionAndReturnError: outError];
+    if (db == nil)
+        [self releaseSlot];
+
+    return db;
+}
+
+/**
+ * Release a live connection slot, handing it to the longest waiting thread, if any.
+ */
+- (void) releaseSlot {
+    pthread_mutex_lock(&_lock); {
+        if (_waitersHead != NULL) {
+            /* The slot is transferred to the waiter, and remains live */
+            struct pl_pool_waiter *waiter = _waitersHead;
+            [self removeWaiter: waiter];
+            waiter->slot = YES;
+            pthread_cond_signal(&waiter->cond);
+        } else if (_liveConnections > 0) {
+            _liveConnections--;
+        }
+    } pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Open up to _minIdle connections, preparing the warm-up statements on each, and add them to the pool.
+ */
+- (void) warmUp {
+    NSUInteger target = _minIdle;
+    if (_capacity > 0)
+        target = MIN(target, _capacity);
+
+    for (NSUInteger i = 0; i < target; i++) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+        /* Claim a slot; stop if the pool is already exhausted, or has been warmed by returned connections. */
+        BOOL claimed = NO;
+        pthread_mutex_lock(&_lock); {
+            if ((_maxConnections == 0 || _liveConnections < _maxConnections) && [_connections count] < target) {
+                _liveConnections++;
+                claimed = YES;
+            }
+        } pthread_mutex_unlock(&_lock);
+
+        if (!claimed) {
+            [pool drain];
+            break;
+        }
+
+        /* Open failures are reported to the error sink by the database driver; the connection will be opened on
+         * demand instead. */
+        id<PLDatabase> db = [self openConnectionAndReturnError: NULL];
+        if (db == nil) {
+            [pool drain];
+            break;
+        }
+
+        /* Closing a prepared statement returns it to the connection's statement cache. Failures are reported by
+         * the database driver, and otherwise ignored; the statement will simply be prepared on first use. */
+        for (NSString *statement in _warmupStatements) {
+            id<PLPreparedStatement> stmt = [db prepareStatement: statement error: NULL];
+            [stmt close];
+        }
+
+        /* Hands the connection to a waiting request, or adds it to the idle set */
+        [self closeConnection: db];
+        [pool drain];
+    }
+}
+
+/**
+ * Remove @a waiter from the waiter queue. The pool lock must be held.
+ */
+- (void) removeWaiter: (struct pl_pool_waiter *) waiter {
+    struct pl_pool_waiter **link = &_waitersHead;
+    struct pl_pool_waiter *prev = NULL;
+
+    while (*link != NULL && *link != waiter) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+
+    if (*link == NULL)
+        return;
+
+    *link = waiter->next;
+    if (_waitersTail == waiter)
+        _waitersTail = prev;
+    waiter->next = NULL;
+}
+
+@end
+
+
+/**
+ * @internal
+ *
+ * Library-private PLDatabasePoolConnectionProvider methods.
+ */
+@implementation PLDatabasePoolConnectionProvider (PLDatabasePoolConnectionProviderLibraryPrivate)
+
+/**
+ * @internal
+ * Return the number of threads currently waiting for a connection.
+ */
+- (NSUInteger) waiterCount {
+    NSUInteger count = 0;
+
+    pthread_mutex_lock(&_lock); {
+        for (struct pl_pool_waiter *waiter = _waitersHead; waiter != NULL; waiter = waiter->next)
+            count++;
+    } pthread_mutex_unlock(&_lock);
+
+    return count;
 }
 
 @end
@@ -28,9 +28,12 @@
  */
 
 #import <SenTestingKit/SenTestingKit.h>
+#import <dispatch/dispatch.h>
+#import <unistd.h>
 
 #import "PLSqliteConnectionProvider.h"
 #import "PLDatabasePoolConnectionProvider.h"
+#import "PLDatabaseFilterConnectionProvider.h"
 
 @interface PLDatabasePoolConnectionProviderTests : SenTestCase {
 @private
@@ -92,4 +95,116 @@
     STAssertFalse([con1 goodConnection], @"Cache is at capacity, but connection was not closed");
 }
 
+/**
+ * Test the live connection limit, and acquisition timeout.
+ */
+- (void) testMaxConnections {
+    NSError *error = nil;
+
+    PLSqliteConnectionProvider *provider = [[[PLSqliteConnectionProvider alloc] initWithPath: @":memory:"] autorelease];
+    PLDatabasePoolConnectionProvider *pool = [[[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: provider
+                                                                                                          capacity: 0
+                                                                                                    maxConnections: 1
+                                                                                                    acquireTimeout: 0.05] autorelease];
+
+    id<PLDatabase> con = [pool getConnectionAndReturnError: &error];
+    STAssertNotNil(con, @"Failed to fetch connection: %@", error);
+
+    /* The pool is exhausted; the request must time out */
+    STAssertNil([pool getConnectionAndReturnError: &error], @"Returned a connection beyond the maximum");
+    STAssertEquals((NSInteger) PLDatabaseErrorTimedOut, [error code], @"Unexpected error code");
+
+    /* Returning the connection makes it available again */
+    [pool closeConnection: con];
+    STAssertEquals(con, [pool getConnectionAndReturnError: &error], @"Did not return the expected connection");
+
+    /* Returning a closed connection frees its slot for a new connection */
+    [con close];
+    [pool closeConnection: con];
+
+    id<PLDatabase> replacement = [pool getConnectionAndReturnError: &error];
+    STAssertNotNil(replacement, @"Failed to fetch connection: %@", error);
+    STAssertTrue([replacement goodConnection], @"Returned a closed connection");
+}
+
+/**
+ * Test that blocked requests are served in FIFO order as connections are returned.
+ */
+- (void) testBlockingAcquisition {
+    NSError *error = nil;
+
+    PLSqliteConnectionProvider *provider = [[[PLSqliteConnectionProvider alloc] initWithPath: @":memory:"] autorelease];
+    PLDatabasePoolConnectionProvider *pool = [[[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: provider
+                                                                                                          capacity: 0
+                                                                                                    maxConnections: 1
+                                                                                                    acquireTimeout: -1] autorelease];
+
+    id<PLDatabase> con = [pool getConnectionAndReturnError: &error];
+    STAssertNotNil(con, @"Failed to fetch connection: %@", error);
+
+    /* Queue up waiters in a known order */
+    NSMutableArray *order = [NSMutableArray array];
+    NSLock *orderLock = [[[NSLock alloc] init] autorelease];
+    dispatch_group_t group = dispatch_group_create();
+
+    for (int i = 0; i < 3; i++) {
+        dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            id<PLDatabase> waiterCon = [pool getConnectionAndReturnError: NULL];
+
+            [orderLock lock];
+            [order addObject: [NSNumber numberWithInt: i]];
+            [orderLock unlock];
+
+            [pool closeConnection: waiterCon];
+        });
+
+        /* Wait for the waiter to block before starting the next */
+        NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow: 10.0];
+        while ([pool waiterCount] < (NSUInteger) i + 1 && [deadline timeIntervalSinceNow] > 0)
+            usleep(1000);
+        STAssertEquals((NSUInteger) i + 1, [pool waiterCount], @"Waiter %d did not block", i);
+    }
+
+    /* Release the connection to the waiters */
+    [pool closeConnection: con];
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    dispatch_release(group);
+
+    NSArray *expected = [NSArray arrayWithObjects: [NSNumber numberWithInt: 0], [NSNumber numberWithInt: 1], [NSNumber numberWithInt: 2], nil];
+    STAssertEqualObjects(expected, order, @"Waiters were not served in FIFO order");
+}
+
+/**
+ * Test background warm-up of the minimum idle connections.
+ */
+- (void) testWarmup {
+    NSError *error = nil;
+    __block int32_t opened = 0;
+
+    PLSqliteConnectionProvider *sqlite = [[[PLSqliteConnectionProvider alloc] initWithPath: @":memory:"] autorelease];
+    PLDatabaseFilterConnectionProvider *provider = [[[PLDatabaseFilterConnectionProvider alloc] initWithConnectionProvider: sqlite filterBlock: ^(id<PLDatabase> db) {
+        __sync_fetch_and_add(&opened, 1);
+    }] autorelease];
+
+    PLDatabasePoolConnectionProvider *pool = [[[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: provider
+                                                                                                          capacity: 4
+                                                                                                    maxConnections: 0
+                                                                                                    acquireTimeout: -1
+                                                                                                           minIdle: 2
+                                                                                                  warmupStatements: [NSArray arrayWithObject: @"SELECT 1"]] autorelease];
+    [pool waitForWarmup];
+    STAssertEquals(2, opened, @"Incorrect number of connections opened by the warm-up");
+
+    /* The warmed connections must be served without opening new connections */
+    id<PLDatabase> con1 = [pool getConnectionAndReturnError: &error];
+    id<PLDatabase> con2 = [pool getConnectionAndReturnError: &error];
+    STAssertNotNil(con1, @"Failed to fetch connection: %@", error);
+    STAssertNotNil(con2, @"Failed to fetch connection: %@", error);
+    STAssertEquals(2, opened, @"Opened a new connection while warm connections were idle");
+
+    id<PLDatabase> con3 = [pool getConnectionAndReturnError: &error];
+    STAssertNotNil(con3, @"Failed to fetch connection: %@", error);
+    STAssertEquals(3, opened, @"Did not open a new connection once the warm connections were checked out");
+}
+
 @end
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+
+#import "PLSqliteDatabase.h"
+
+@interface PLGroupCommitWriter : NSObject {
+@private
+    /** The backing database connection. Must only be accessed from the writer thread. */
+    PLSqliteDatabase *_database;
+
+    /** Maximum number of writes applied in a single transaction. */
+    NSUInteger _maxBatchSize;
+
+    /** Maximum time a write may wait for its batch to fill before the batch is committed. */
+    NSTimeInterval _maxLatency;
+
+    /** Lock protecting all fields below. */
+    pthread_mutex_t _lock;
+
+    /** Signaled when a write is enqueued, or the writer is closed. */
+    pthread_cond_t _cond;
+
+    /** Pending writes, in the order in which they were enqueued. */
+    NSMutableArray *_pending;
+
+    /** If YES, no further writes will be accepted. */
+    BOOL _closed;
+
+    /** The writer thread. */
+    pthread_t _thread;
+
+    /** Number of transactions committed by the writer thread. */
+    volatile uint64_t _commitCount;
+}
+
+- (id) initWithDatabase: (PLSqliteDatabase *) database
+           maxBatchSize: (NSUInteger) maxBatchSize
+             maxLatency: (NSTimeInterval) maxLatency;
+
+- (void) executeUpdate: (NSString *) statement
+            parameters: (NSArray *) parameters
+            completion: (void (^)(BOOL success, NSError *error)) completion;
+
+- (BOOL) executeUpdate: (NSString *) statement parameters: (NSArray *) parameters error: (NSError **) outError;
+
+- (void) close;
+
+/** The maximum number of writes applied in a single transaction. */
+@property(nonatomic, readonly) NSUInteger maxBatchSize;
+
+/** The maximum time a write may wait for its batch to fill before the batch is committed. */
+@property(nonatomic, readonly) NSTimeInterval maxLatency;
+
+/** The number of transactions committed by the writer since it was created. */
+@property(nonatomic, readonly) uint64_t commitCount;
+
+@end
@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLGroupCommitWriter.h"
+
+#import <dispatch/dispatch.h>
+#import <sys/time.h>
+#import <errno.h>
+#import <math.h>
+
+/**
+ * @internal
+ * A single write pending in a PLGroupCommitWriter queue.
+ */
+@interface PLGroupCommitWrite : NSObject {
+@public
+    /** The SQL statement to execute. */
+    NSString *_statement;
+
+    /** The statement's parameters, or nil. */
+    NSArray *_parameters;
+
+    /** Completion block, or nil. */
+    void (^_completion)(BOOL success, NSError *error);
+
+    /** Absolute time by which the write's batch must be committed. */
+    struct timespec _deadline;
+
+    /** The result of the write; only valid once its batch has been applied. */
+    BOOL _success;
+
+    /** If the write failed, the cause of the failure. */
+    NSError *_error;
+}
+
+- (id) initWithStatement: (NSString *) statement
+              parameters: (NSArray *) parameters
+              completion: (void (^)(BOOL success, NSError *error)) completion
+                deadline: (struct timespec) deadline;
+
+- (void) failWithError: (NSError *) error;
+
+@end
+
+@implementation PLGroupCommitWrite
+
+- (id) initWithStatement: (NSString *) statement
+              parameters: (NSArray *) parameters
+              completion: (void (^)(BOOL success, NSError *error)) completion
+                deadline: (struct timespec) deadline
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _statement = [statement copy];
+    _parameters = [parameters copy];
+    _completion = [completion copy];
+    _deadline = deadline;
+
+    return self;
+}
+
+- (void) dealloc {
+    [_statement release];
+    [_parameters release];
+    [_completion release];
+    [_error release];
+
+    [super dealloc];
+}
+
+/**
+ * Mark the write as failed with @a error, replacing any previous result.
+ */
+- (void) failWithError: (NSError *) error {
+    _success = NO;
+
+    [error retain];
+    [_error release];
+    _error = error;
+}
+
+@end
+
+
+@interface PLGroupCommitWriter (PrivateMethods)
+- (void) runWriter;
+- (void) applyBatch: (NSArray *) batch;
+- (BOOL) applyWrite: (PLGroupCommitWrite *) write error: (NSError **) outError;
+- (void) failSucceededWrites: (NSArray *) batch inRange: (NSRange) range error: (NSError *) error;
+@end
+
+/**
+ * @internal
+ * Return the absolute wall clock time @a interval seconds from now, as required by pthread_cond_timedwait().
+ */
+static struct timespec pl_group_commit_deadline (NSTimeInterval interval) {
+    struct timeval now;
+    struct timespec deadline;
+
+    gettimeofday(&now, NULL);
+
+    long nsec = (long) now.tv_usec * 1000 + (long) ((interval - floor(interval)) * 1e9);
+    deadline.tv_sec = now.tv_sec + (time_t) floor(interval) + nsec / 1000000000;
+    deadline.tv_nsec = nsec % 1000000000;
+
+    return deadline;
+}
+
+/**
+ * @internal
+ * Writer thread entry point. Releases the reference to the writer acquired by the writer's initializer.
+ */
+static void *pl_group_commit_writer_main (void *arg) {
+    PLGroupCommitWriter *writer = arg;
+    [writer runWriter];
+    [writer release];
+    return NULL;
+}
+
+/**
+ * Serializes writes from any number of threads onto a single writer connection, committing them in groups.
+ *
+ * Each SQLite write transaction incurs a fixed cost at commit, which is dominated by the journal and database
+ * sync. When many threads each commit their own write, most of that time is spent waiting on the database lock and
+ * on the disk; the writer instead applies all writes that arrive within a short flush window in a single
+ * <tt>BEGIN IMMEDIATE</tt> ... <tt>COMMIT</tt> transaction, amortizing the commit across the group.
+ *
+ * A flush window opens when a write is enqueued on an idle writer, and closes once @a maxBatchSize writes are
+ * pending, or once the first of them has waited @a maxLatency seconds, whichever comes first.
+ *
+ * @par Per-Write Results
+ * Each write is reported its own result. A write that fails (for example, due to a constraint violation) is
+ * reported as failed without affecting the other writes in its group, as SQLite rolls back only the failing
+ * statement. If the transaction itself is rolled back, or the commit fails, every write that had been applied within
+ * the transaction is reported as failed with the cause.
+ *
+ * Completion blocks are executed on the writer thread once the write's transaction has committed (or failed), in
+ * the order in which the writes were enqueued. They should not perform lengthy work, and must not wait on the
+ * writer.
+ *
+ * @par Closing
+ * The writer thread retains the writer until it is closed, so a completion block may safely release the last
+ * external reference. The writer must be closed via close once it is no longer needed.
+ *
+ * @par Thread Safety
+ * Thread-safe. The backing database must not be accessed other than through the PLGroupCommitWriter instance.
+ */
+@implementation PLGroupCommitWriter
+
+@synthesize maxBatchSize = _maxBatchSize;
+@synthesize maxLatency = _maxLatency;
+
+/**
+ * Initialize a new writer with an open @a database, and start its writer thread.
+ *
+ * @param database An open database connection. The connection will be retained, and must not be accessed
+ * other than through the returned instance.
+ * @param maxBatchSize The maximum number of writes to apply within a single transaction. Must be greater than zero.
+ * @param maxLatency The maximum time, in seconds, that a write will be held waiting for its group to fill before
+ * the group is committed. A latency of 0 commits all writes pending at the time the writer becomes idle.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLGroupCommitWriter class.
+ */
+- (id) initWithDatabase: (PLSqliteDatabase *) database
+           maxBatchSize: (NSUInteger) maxBatchSize
+             maxLatency: (NSTimeInterval) maxLatency
+{
+    if (maxBatchSize == 0)
+        [NSException raise: PLDatabaseException format: @"A group commit writer's maximum batch size must be greater than zero"];
+
+    if (maxLatency < 0)
+        [NSException raise: PLDatabaseException format: @"A group commit writer's maximum latency must not be negative"];
+
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _database = [database retain];
+    _maxBatchSize = maxBatchSize;
+    _maxLatency = maxLatency;
+    _pending = [[NSMutableArray alloc] init];
+
+    pthread_mutex_init(&_lock, NULL);
+    pthread_cond_init(&_cond, NULL);
+
+    /* The writer thread holds a reference until it exits. A completion block may release the last external
+     * reference; the writer must not then be deallocated on its own thread, which it could not join. */
+    [self retain];
+    if (pthread_create(&_thread, NULL, pl_group_commit_writer_main, self) != 0) {
+        /* There's no thread to join, or to release its reference */
+        _closed = YES;
+        [self release];
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void) dealloc {
+    /* The writer thread's reference ensures that we can only be deallocated once the writer has been closed, and
+     * its thread has exited. */
+    [_database release];
+    [_pending release];
+
+    pthread_cond_destroy(&_cond);
+    pthread_mutex_destroy(&_lock);
+
+    [super dealloc];
+}
+
+/**
+ * Enqueue an update to be applied in the next group commit. Returns immediately.
+ *
+ * @param statement The SQL statement to execute.
+ * @param parameters The statement's parameters, bound as per PLPreparedStatement::bindParameters:, or nil.
+ * @param completion Block to be executed on the writer thread once the update's transaction has committed or
+ * failed, or nil. If the update failed, @a error describes the failure.
+ *
+ * @warning Raises PLDatabaseException if the writer has been closed.
+ */
+- (void) executeUpdate: (NSString *) statement
+            parameters: (NSArray *) parameters
+            completion: (void (^)(BOOL success, NSError *error)) completion
+{
+    PLGroupCommitWrite *write = [[PLGroupCommitWrite alloc] initWithStatement: statement
+                                                                   parameters: parameters
+                                                                   completion: completion
+                                                                     deadline: pl_group_commit_deadline(_maxLatency)];
+
+    pthread_mutex_lock(&_lock); {
+        if (_closed) {
+            pthread_mutex_unlock(&_lock);
+            [write release];
+            [NSException raise: PLDatabaseException format: @"Attempted to enqueue an update on a closed group commit writer"];
+        }
+
+        [_pending addObject: write];
+
+        /* Wake the writer when a new flush window opens, or when the current window fills */
+        NSUInteger count = [_pending count];
+        if (count == 1 || count == _maxBatchSize)
+            pthread_cond_signal(&_cond);
+    } pthread_mutex_unlock(&_lock);
+
+    [write release];
+}
+
+/**
+ * Enqueue an update to be applied in the next group commit, and wait for its transaction to commit or fail.
+ *
+ * @param statement The SQL statement to execute.
+ * @param parameters The statement's parameters, bound as per PLPreparedStatement::bindParameters:, or nil.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the update failed. If no error
+ * occurs, this parameter will be left unmodified. You may specify nil for this parameter,
+ * and no error information will be provided.
+ * @return YES if the update was applied and committed, NO otherwise.
+ *
+ * @warning Must not be called from a completion block; the writer would wait on itself.
+ */
+- (BOOL) executeUpdate: (NSString *) statement parameters: (NSArray *) parameters error: (NSError **) outError {
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    __block BOOL result = NO;
+    __block NSError *error = nil;
+
+    [self executeUpdate: statement parameters: parameters completion: ^(BOOL success, NSError *writeError) {
+        result = success;
+        error = [writeError retain];
+        dispatch_semaphore_signal(done);
+    }];
+
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    dispatch_release(done);
+
+    [error autorelease];
+    if (!result && outError != NULL)
+        *outError = error;
+
+    return result;
+}
+
+/**
+ * Stop accepting new writes, apply and commit all pending writes, and wait for the writer thread to exit.
+ *
+ * Subsequent calls have no effect. The writer thread retains the writer until it exits; every writer must be
+ * closed, or it will never be deallocated.
+ *
+ * @warning Must not be called from a completion block.
+ */
+- (void) close {
+    pthread_mutex_lock(&_lock); {
+        if (_closed) {
+            pthread_mutex_unlock(&_lock);
+            return;
+        }
+
+        _closed = YES;
+        pthread_cond_signal(&_cond);
+    } pthread_mutex_unlock(&_lock);
+
+    pthread_join(_thread, NULL);
+}
+
+/* Read without the lock; the count is only advisory. */
+- (uint64_t) commitCount {
+    return __sync_fetch_and_add(&_commitCount, 0);
+}
+
+@end
+
+
+/**
+ * @internal
+ * Writer thread implementation.
+ */
+@implementation PLGroupCommitWriter (PrivateMethods)
+
+/**
+ * Writer thread main loop. Returns once the writer has been closed and all pending writes have been applied.
+ */
+- (void) runWriter {
+    pthread_mutex_lock(&_lock);
+    while (YES) {
+        /* Wait for the first write of a new group */
+        while ([_pending count] == 0 && !_closed)
+            pthread_cond_wait(&_cond, &_lock);
+
+        /* Closed and drained */
+        if ([_pending count] == 0)
+            break;
+
+        /* Hold the flush window open until it fills, the oldest write's deadline passes, or the writer is closed */
+        struct timespec deadline = ((PLGroupCommitWrite *) [_pending objectAtIndex: 0])->_deadline;
+        while ([_pending count] < _maxBatchSize && !_closed) {
+            if (pthread_cond_timedwait(&_cond, &_lock, &deadline) == ETIMEDOUT)
+                break;
+        }
+
+        NSRange range = NSMakeRange(0, MIN([_pending count], _maxBatchSize));
+        NSArray *batch = [[_pending subarrayWithRange: range] retain];
+        [_pending removeObjectsInRange: range];
+
+        /* Writes enqueued while the batch is applied will open the next window */
+        pthread_mutex_unlock(&_lock); {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            [self applyBatch: batch];
+            [pool drain];
+            [batch release];
+        } pthread_mutex_lock(&_lock);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Apply all writes in @a batch within a single transaction, and then report each write's result.
+ */
+- (void) applyBatch: (NSArray *) batch {
+    sqlite3 *sqlite = [_database sqliteHandle];
+    NSUInteger count = [batch count];
+    NSUInteger first = 0;
+    BOOL inTransaction = NO;
+    NSError *error = nil;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        PLGroupCommitWrite *write = [batch objectAtIndex: i];
+
+        /* Open the group's transaction; IMMEDIATE acquires the write lock up front, rather than on the first write */
+        if (!inTransaction) {
+            if (![_database beginTransactionWithIsolationLevel: PLDatabaseIsolationLevelImmediate error: &error]) {
+                for (NSUInteger j = i; j < count; j++)
+                    [[batch objectAtIndex: j] failWithError: error];
+                break;
+            }
+
+            inTransaction = YES;
+            first = i;
+        }
+
+        write->_success = [self applyWrite: write error: &error];
+        if (write->_success)
+            continue;
+
+        [write failWithError: error];
+
+        /* SQLite reverts only the failing statement, unless the error (eg, SQLITE_FULL, SQLITE_IOERR, or an
+         * ON CONFLICT ROLLBACK constraint) rolled back the entire transaction. In that case, the earlier writes
+         * in the transaction were lost, and the remainder of the group is applied in a new transaction. */
+        if (sqlite3_get_autocommit(sqlite)) {
+            [self failSucceededWrites: batch inRange: NSMakeRange(first, i - first) error: error];
+            inTransaction = NO;
+        }
+    }
+
+    if (inTransaction) {
+        if ([_database executeUpdateAndReturnError: &error statement: @"COMMIT"]) {
+            __sync_fetch_and_add(&_commitCount, 1);
+        } else {
+            /* A failed COMMIT may leave the transaction open */
+            if (!sqlite3_get_autocommit(sqlite))
+                [_database executeUpdate: @"ROLLBACK"];
+
+            [self failSucceededWrites: batch inRange: NSMakeRange(first, count - first) error: error];
+        }
+    }
+
+    /* Report results in enqueue order */
+    for (PLGroupCommitWrite *write in batch) {
+        if (write->_completion != nil)
+            write->_completion(write->_success, write->_success ? nil : write->_error);
+    }
+}
+
+/**
+ * Apply a single write within the current transaction.
+ */
+- (BOOL) applyWrite: (PLGroupCommitWrite *) write error: (NSError **) outError {
+    id<PLPreparedStatement> stmt = [_database prepareStatement: write->_statement error: outError];
+    if (stmt == nil)
+        return NO;
+
+    BOOL success = NO;
+    @try {
+        if (write->_parameters != nil)
+            [stmt bindParameters: write->_parameters];
+
+        success = [stmt executeUpdateAndReturnError: outError];
+    } @catch (NSException *e) {
+        /* Binding errors raise; there's no caller on this thread to receive the exception, so report it as the
+         * write's result instead. */
+        if (outError != NULL) {
+            *outError = [PlausibleDatabase errorWithCode: PLDatabaseErrorInvalidStatement
+                                    localizedDescription: [e reason]
+                                             queryString: write->_statement
+                                             vendorError: nil
+                                       vendorErrorString: nil];
+        }
+    } @finally {
+        [stmt close];
+    }
+
+    return success;
+}
+
+/**
+ * Mark all writes within @a range of @a batch that had succeeded as failed with @a error; used when their
+ * transaction did not commit.
+ */
+- (void) failSucceededWrites: (NSArray *) batch inRange: (NSRange) range error: (NSError *) error {
+    for (NSUInteger i = range.location; i < NSMaxRange(range); i++) {
+        PLGroupCommitWrite *write = [batch objectAtIndex: i];
+        if (write->_success)
+            [write failWithError: error];
+    }
+}
+
+@end
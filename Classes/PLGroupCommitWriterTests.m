@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PlausibleDatabase.h"
+
+@interface PLGroupCommitWriterTests : SenTestCase {
+@private
+    PLSqliteDatabase *_db;
+}
+
+@end
+
+@implementation PLGroupCommitWriterTests
+
+- (void) setUp {
+    _db = [[PLSqliteDatabase alloc] initWithPath: @":memory:"];
+    STAssertTrue([_db open], @"Couldn't open the test database");
+}
+
+- (void) tearDown {
+    [_db release];
+}
+
+/* Return the number of rows in the test table. Only valid once the writer has been closed. */
+- (int) rowCount {
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM test"];
+    STAssertTrue([rs next], @"No count returned");
+    int count = [rs intForColumnIndex: 0];
+    [rs close];
+
+    return count;
+}
+
+/* Writes from several threads must all be applied, in fewer transactions than writes */
+- (void) testGroupCommit {
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer)"], @"Create table failed");
+
+    PLGroupCommitWriter *writer = [[[PLGroupCommitWriter alloc] initWithDatabase: _db maxBatchSize: 10 maxLatency: 0.05] autorelease];
+    __block int32_t succeeded = 0;
+
+    dispatch_apply(100, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [writer executeUpdate: @"INSERT INTO test (a) VALUES (?)" parameters: [NSArray arrayWithObject: [NSNumber numberWithInt: (int) i]] completion: ^(BOOL success, NSError *error) {
+            if (success)
+                __sync_fetch_and_add(&succeeded, 1);
+        }];
+    });
+
+    /* Closing applies all pending writes */
+    [writer close];
+
+    STAssertEquals(100, succeeded, @"Not all writes succeeded");
+    STAssertEquals(100, [self rowCount], @"Not all writes were applied");
+    STAssertTrue([writer commitCount] >= 10, @"Batches exceeded the maximum batch size");
+    STAssertTrue([writer commitCount] < 100, @"Writes were not grouped");
+}
+
+/* A failing statement must not affect the other writes in its group */
+- (void) testPerWriteFailure {
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer UNIQUE)"], @"Create table failed");
+
+    PLGroupCommitWriter *writer = [[[PLGroupCommitWriter alloc] initWithDatabase: _db maxBatchSize: 3 maxLatency: 10.0] autorelease];
+    BOOL results[3] = { NO, NO, NO };
+    BOOL *resultsPtr = results;
+    __block NSError *duplicateError = nil;
+    int values[3] = { 1, 1, 2 };
+
+    for (int i = 0; i < 3; i++) {
+        [writer executeUpdate: @"INSERT INTO test (a) VALUES (?)" parameters: [NSArray arrayWithObject: [NSNumber numberWithInt: values[i]]] completion: ^(BOOL success, NSError *error) {
+            resultsPtr[i] = success;
+            if (i == 1)
+                duplicateError = [error retain];
+        }];
+    }
+    [writer close];
+
+    STAssertTrue(results[0], @"First write failed");
+    STAssertFalse(results[1], @"Duplicate write succeeded");
+    STAssertTrue(results[2], @"Write following a failed write failed");
+    STAssertNotNil(duplicateError, @"No error provided for the failed write");
+    STAssertEquals(2, [self rowCount], @"Incorrect number of rows applied");
+    STAssertEquals((uint64_t) 1, [writer commitCount], @"Writes were not applied in a single transaction");
+
+    [duplicateError release];
+}
+
+/* If a failure rolls back the transaction, the earlier writes in the transaction must also be reported as failed */
+- (void) testRolledBackTransaction {
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer UNIQUE ON CONFLICT ROLLBACK)"], @"Create table failed");
+
+    PLGroupCommitWriter *writer = [[[PLGroupCommitWriter alloc] initWithDatabase: _db maxBatchSize: 3 maxLatency: 10.0] autorelease];
+    BOOL results[3] = { YES, YES, NO };
+    BOOL *resultsPtr = results;
+    int values[3] = { 1, 1, 2 };
+
+    for (int i = 0; i < 3; i++) {
+        [writer executeUpdate: @"INSERT INTO test (a) VALUES (?)" parameters: [NSArray arrayWithObject: [NSNumber numberWithInt: values[i]]] completion: ^(BOOL success, NSError *error) {
+            resultsPtr[i] = success;
+        }];
+    }
+    [writer close];
+
+    STAssertFalse(results[0], @"Rolled back write was reported as successful");
+    STAssertFalse(results[1], @"Duplicate write succeeded");
+    STAssertTrue(results[2], @"Write following the rollback was not applied");
+    STAssertEquals(1, [self rowCount], @"Incorrect number of rows applied");
+}
+
+- (void) testSynchronousUpdate {
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer)"], @"Create table failed");
+
+    PLGroupCommitWriter *writer = [[[PLGroupCommitWriter alloc] initWithDatabase: _db maxBatchSize: 10 maxLatency: 0.01] autorelease];
+    NSError *error = nil;
+
+    STAssertTrue([writer executeUpdate: @"INSERT INTO test (a) VALUES (?)" parameters: [NSArray arrayWithObject: [NSNumber numberWithInt: 1]] error: &error], @"Update failed: %@", error);
+    STAssertFalse([writer executeUpdate: @"INSERT INTO missing (a) VALUES (1)" parameters: nil error: &error], @"Update of a missing table succeeded");
+    STAssertNotNil(error, @"No error was provided");
+
+    /* Binding errors are reported as the write's result */
+    error = nil;
+    STAssertFalse([writer executeUpdate: @"INSERT INTO test (a) VALUES (?)" parameters: [NSArray array] error: &error], @"Update with missing parameters succeeded");
+    STAssertNotNil(error, @"No error was provided");
+
+    [writer close];
+    STAssertEquals(1, [self rowCount], @"Incorrect number of rows applied");
+}
+
+- (void) testClosedWriter {
+    PLGroupCommitWriter *writer = [[[PLGroupCommitWriter alloc] initWithDatabase: _db maxBatchSize: 10 maxLatency: 0.01] autorelease];
+    [writer close];
+
+    STAssertThrows([writer executeUpdate: @"CREATE TABLE test (a integer)" parameters: nil completion: nil], @"Closed writer accepted a write");
+}
+
+@end
@@ -32,6 +32,20 @@
 #import "PLDatabaseConstants.h"
 #import "PLResultSet.h"
 
+/**
+ * Parameter binding modes for string and blob values.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** String and blob values are copied by the database at bind time. */
+    PLPreparedStatementBindingModeCopy = 0,
+
+    /** String and blob values are borrowed, rather than copied, by the database. Bound buffers must remain valid
+     * and unmodified until the parameter is re-bound or the statement is closed. */
+    PLPreparedStatementBindingModeBorrow = 1
+} PLPreparedStatementBindingMode;
+
 /**
  * An object that represents a pre-compiled statement, and any parameters
  * bound to that statement.
@@ -83,6 +97,109 @@
  */
 - (void) bindParameterDictionary: (NSDictionary *) parameters;
 
+/**
+ * Returns the zero-based index of the named parameter @a name, for use with the typed binding methods.
+ *
+ * Parameter names are resolved once per prepared query. Resolving the indexes of a statement's named parameters
+ * once, and binding by index thereafter, avoids constructing an NSDictionary for every execution:
+ *
+ * @code
+ * id<PLPreparedStatement> stmt = [db prepareStatement: @"INSERT INTO example (name, price) VALUES (:name, :price)"];
+ * int nameIndex = [stmt parameterIndexForName: @"name"];
+ * int priceIndex = [stmt parameterIndexForName: @"price"];
+ *
+ * for (...) {
+ *     [stmt bindUTF8: name length: -1 atIndex: nameIndex];
+ *     [stmt bindDouble: price atIndex: priceIndex];
+ *     [stmt executeUpdate];
+ * }
+ * @endcode
+ *
+ * Will throw NSException if the statement has no parameter named @a name.
+ *
+ * @param name The parameter name, without its ':' prefix.
+ */
+- (int) parameterIndexForName: (NSString *) name;
+
+/**
+ * Set the binding mode used for string and blob values bound by subsequent calls to the binding methods. Defaults
+ * to #PLPreparedStatementBindingModeCopy.
+ *
+ * In #PLPreparedStatementBindingModeBorrow mode, NSData and NSString values bound via PLPreparedStatement::bindParameters:
+ * or PLPreparedStatement::bindParameterDictionary: are retained by the statement until they are re-bound or the
+ * statement is closed, and their contents are not copied (strings are copied if no UTF-8 representation is directly
+ * available). Buffers bound via PLPreparedStatement::bindUTF8:length:atIndex: and
+ * PLPreparedStatement::bindBlob:length:atIndex: are not retained; the caller must ensure that they remain valid and
+ * unmodified until they are re-bound or the statement is closed.
+ *
+ * Borrowing avoids a copy of every bound string and blob value, which may be significant for large values.
+ *
+ * @param bindingMode The binding mode.
+ */
+- (void) setBindingMode: (PLPreparedStatementBindingMode) bindingMode;
+
+/**
+ * Returns the binding mode used for string and blob values.
+ */
+- (PLPreparedStatementBindingMode) bindingMode;
+
+/**
+ * Bind a 64-bit integer value to the parameter at @a parameterIndex.
+ *
+ * The typed binding methods bind a single parameter without boxing the value in an Objective-C object, and may be
+ * mixed freely with one another. Parameters are indexed from zero, in the same order as the values provided to
+ * PLPreparedStatement::bindParameters:. Bound values are retained by the statement until they are replaced.
+ *
+ * Will throw NSException if @a parameterIndex is out of range.
+ *
+ * @param value The value to bind.
+ * @param parameterIndex The zero-based parameter index.
+ */
+- (void) bindInt64: (int64_t) value atIndex: (int) parameterIndex;
+
+/**
+ * Bind a double value to the parameter at @a parameterIndex.
+ *
+ * Will throw NSException if @a parameterIndex is out of range.
+ *
+ * @param value The value to bind.
+ * @param parameterIndex The zero-based parameter index.
+ */
+- (void) bindDouble: (double) value atIndex: (int) parameterIndex;
+
+/**
+ * Bind UTF-8 encoded text to the parameter at @a parameterIndex. The text is copied, unless the statement's
+ * binding mode is #PLPreparedStatementBindingModeBorrow.
+ *
+ * Will throw NSException if @a parameterIndex is out of range.
+ *
+ * @param text The UTF-8 text to bind. If NULL, the parameter will be bound to NULL.
+ * @param length The length of @a text in bytes, or -1 if @a text is NUL terminated.
+ * @param parameterIndex The zero-based parameter index.
+ */
+- (void) bindUTF8: (const char *) text length: (int) length atIndex: (int) parameterIndex;
+
+/**
+ * Bind a blob value to the parameter at @a parameterIndex. The bytes are copied, unless the statement's
+ * binding mode is #PLPreparedStatementBindingModeBorrow.
+ *
+ * Will throw NSException if @a parameterIndex is out of range.
+ *
+ * @param bytes The bytes to bind. If NULL, the parameter will be bound to NULL.
+ * @param length The length of @a bytes.
+ * @param parameterIndex The zero-based parameter index.
+ */
+- (void) bindBlob: (const void *) bytes length: (int) length atIndex: (int) parameterIndex;
+
+/**
+ * Bind NULL to the parameter at @a parameterIndex.
+ *
+ * Will throw NSException if @a parameterIndex is out of range.
+ *
+ * @param parameterIndex The zero-based parameter index.
+ */
+- (void) bindNullAtIndex: (int) parameterIndex;
+
 /**
  * Execute an update, returning YES on success, NO on failure.
  */
@@ -119,6 +236,48 @@
  */
 - (id<PLResultSet>) executeQueryAndReturnError: (NSError **) outError;
 
+/**
+ * Execute the statement once for each row of parameters in @a rows, returning YES if all rows were
+ * executed successfully.
+ *
+ * This is equivalent to calling PLPreparedStatement::executeBatch:inTransaction:failedRowIndexes:error:
+ * without a wrapping transaction.
+ *
+ * @param rows The parameters to be bound for each execution of the statement. Each row must be either
+ * an NSArray, bound as per PLPreparedStatement::bindParameters:, or an NSDictionary, bound as per
+ * PLPreparedStatement::bindParameterDictionary:.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object describing the first row that could not be executed.
+ * If no error occurs, this parameter will be left unmodified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ */
+- (BOOL) executeBatch: (id<NSFastEnumeration>) rows error: (NSError **) outError;
+
+/**
+ * Execute the statement once for each row of parameters in @a rows, returning YES if all rows were
+ * executed successfully.
+ *
+ * Execution continues after a row fails, allowing all failed rows to be reported. If the row's failure causes the
+ * database to roll back the wrapping transaction, execution stops at that row.
+ *
+ * @param rows The parameters to be bound for each execution of the statement. Each row must be either
+ * an NSArray, bound as per PLPreparedStatement::bindParameters:, or an NSDictionary, bound as per
+ * PLPreparedStatement::bindParameterDictionary:.
+ * @param inTransaction If YES, the batch will be executed within a new transaction, nested within the caller's
+ * transaction if one is active. The transaction is committed if all rows are executed successfully, and otherwise
+ * rolled back.
+ * @param failedRowIndexes If non-NULL, will be set to the indexes (in enumeration order) of the rows that could
+ * not be executed. If the wrapping transaction could not be started or committed, this will be empty.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object describing the first row that could not be executed.
+ * If no error occurs, this parameter will be left unmodified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ */
+- (BOOL) executeBatch: (id<NSFastEnumeration>) rows
+        inTransaction: (BOOL) inTransaction
+     failedRowIndexes: (NSIndexSet **) failedRowIndexes
+                error: (NSError **) outError;
+
 /**
  * Close the prepared statement, and return any held database resources. After calling,
  * no further PLPreparedStatement methods may be called on the instance.
@@ -29,6 +29,8 @@
 
 
 #import <Foundation/Foundation.h>
+
+#import "PLRowMapping.h"
 #import "PLDatabaseConstants.h"
 
 /**
@@ -47,6 +49,49 @@ typedef enum {
     PLResultSetStatusError = 2
 } PLResultSetStatus;
 
+/**
+ * Value types supported by PLResultSetColumnBuffer.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** Values are fetched as int64_t. NULL values are fetched as 0. */
+    PLResultSetColumnBufferTypeInt64 = 0,
+
+    /** Values are fetched as double. NULL values are fetched as 0.0. */
+    PLResultSetColumnBufferTypeDouble = 1
+} PLResultSetColumnBufferType;
+
+/**
+ * A caller-supplied destination for a single column's values, as used by
+ * PLResultSet::fetchColumns:intoBuffers:columnCount:maxRows:rowsFetched:error:.
+ */
+typedef struct PLResultSetColumnBuffer {
+    /** The type of the values to be written to the buffer. */
+    PLResultSetColumnBufferType type;
+
+    /** Contiguous value array, with room for at least maxRows values of the given type. The value for the n-th
+     * fetched row will be written to the n-th element. */
+    void *values;
+
+    /** Optional null bitmap, with room for at least (maxRows + 7) / 8 bytes, or NULL. If non-NULL, the n-th bit
+     * (bit n % 8 of byte n / 8) will be set if the value of the n-th fetched row is NULL, and cleared otherwise.
+     * See PLResultSetColumnBufferIsNull(). */
+    uint8_t *nulls;
+} PLResultSetColumnBuffer;
+
+/**
+ * Returns YES if the null bitmap @a nulls marks the value of @a row as NULL.
+ *
+ * @param nulls A null bitmap populated by PLResultSet::fetchColumns:intoBuffers:columnCount:maxRows:rowsFetched:error:.
+ * @param row The index of the fetched row.
+ *
+ * @ingroup functions
+ */
+static inline BOOL PLResultSetColumnBufferIsNull (const uint8_t *nulls, NSUInteger row) {
+    return (nulls[row / 8] & (1 << (row % 8))) != 0;
+}
+
 /**
  * Represents a set of results returned by an SQL query.
  *
@@ -86,6 +131,38 @@ typedef enum {
  */
 - (BOOL) enumerateAndReturnError: (NSError **) outError block: (void (^)(id<PLResultSet> rs, BOOL *stop)) block;
 
+/**
+ * Iterate over all rows in the result set in batches of up to @a batchSize rows, decoding each batch into an array
+ * of C structs as per PLResultSet::decodeRowsWithMapping:into:stride:maxRows:rowsDecoded:error:, and calling the
+ * provided block for each batch.
+ *
+ * A single batch buffer of @a batchSize rows is allocated and re-used for every batch. Rows are only fetched
+ * when the block returns, so a slow consumer will throttle the query rather than cause the result set to be
+ * buffered in memory.
+ *
+ * Will throw NSException if any of the mapping's column names are unknown, or if any mapped field extends past @a stride.
+ *
+ * @param batchSize The maximum number of rows per batch.
+ * @param mapping The row mapping used to decode each row.
+ * @param stride The size of each decoded row, in bytes; generally, sizeof() the destination struct.
+ * @param outError A pointer to an NSError object variable. If an error occurs, iteration will stop and
+ * this pointer will contain an error object indicating why the statement could not be executed.
+ * If no error occurs, this parameter's value will not be modified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ * @param block Block to execute for each batch. The @a rows buffer contains @a count decoded rows, and is only
+ * valid until the block returns. Set the provided stop argument's value to YES to stop iteration of the result set.
+ *
+ * @return Returns YES if the result set was successfully iterated, or NO if a database error occurs.
+ *
+ * @invariant If all rows are enumerated and iteration is not explicitly stopped by setting the provided stop argument, the result set will be implicitly closed.
+ * @invariant If an error occurs during enumeration and NO is returned by this method, the result set will be implicitly closed.
+ */
+- (BOOL) enumerateBatchesOfSize: (NSUInteger) batchSize
+                        mapping: (PLRowMapping *) mapping
+                         stride: (size_t) stride
+                          error: (NSError **) outError
+                          block: (void (^)(const void *rows, NSUInteger count, BOOL *stop)) block;
+
 /**
  * Move the result cursor to the next available row. If no further rows
  * are available or an error occurs, returns NO.
@@ -294,6 +371,73 @@ typedef enum {
  */
 - (NSData *) dataForColumnIndex: (int) columnIndex;
 
+/**
+ * Returns a borrowed pointer to the UTF-8 encoded text value of the given column index from the current result row,
+ * without copying or transcoding the value.
+ *
+ * The returned bytes are NUL terminated, and remain valid only until the result set is advanced or closed.
+ *
+ * If the column value is NULL, NULL will be returned.
+ *
+ * Will throw NSException if the column index is out of range.
+ *
+ * @param columnIndex Index of the column value to return.
+ * @param length If non-NULL, on return will contain the length of the value in bytes, excluding the NUL terminator.
+ */
+- (const char *) UTF8StringForColumnIndex: (int) columnIndex length: (size_t *) length;
+
+/**
+ * Returns the string value of the given column index from the current result row, borrowing the result row's UTF-8
+ * encoded text rather than copying it where the platform permits.
+ *
+ * @warning The returned string is only valid until the result set is advanced or closed. Send -copy to the
+ * string if it must be retained beyond the current row.
+ *
+ * If the column value is NULL, nil will be returned.
+ *
+ * Will throw NSException if the column index is out of range.
+ */
+- (NSString *) borrowedStringForColumnIndex: (int) columnIndex;
+
+/**
+ * Returns the string value of the named column from the current result row, borrowing the result row's UTF-8
+ * encoded text rather than copying it where the platform permits.
+ *
+ * @warning The returned string is only valid until the result set is advanced or closed. Send -copy to the
+ * string if it must be retained beyond the current row.
+ *
+ * If the column value is NULL, nil will be returned.
+ *
+ * Will throw NSException if the column name is unknown.
+ */
+- (NSString *) borrowedStringForColumn: (NSString *) columnName;
+
+/**
+ * Returns an NSData instance referencing, rather than copying, the value of the given column index from the current
+ * result row.
+ *
+ * @warning The returned data is only valid until the result set is advanced or closed. Send -copy to the
+ * data if it must be retained beyond the current row.
+ *
+ * If the column value is NULL, nil will be returned.
+ *
+ * Will throw NSException if the column index is out of range.
+ */
+- (NSData *) borrowedDataForColumnIndex: (int) columnIndex;
+
+/**
+ * Returns an NSData instance referencing, rather than copying, the value of the named column from the current
+ * result row.
+ *
+ * @warning The returned data is only valid until the result set is advanced or closed. Send -copy to the
+ * data if it must be retained beyond the current row.
+ *
+ * If the column value is NULL, nil will be returned.
+ *
+ * Will throw NSException if the column name is unknown.
+ */
+- (NSData *) borrowedDataForColumn: (NSString *) columnName;
+
 /**
  * Return the value of the named column as a Foundation Objective-C object, using the database driver's built-in
  * SQL and Foundation data-type mappings.
@@ -352,7 +496,95 @@ typedef enum {
  */
 - (id) objectAtIndexedSubscript: (NSUInteger) index;
 
+/**
+ * Fetch the values of the given columns for up to @a maxRows rows into contiguous, caller-supplied buffers,
+ * advancing the cursor past each row fetched. Rows are fetched starting with the row following the current row;
+ * this method may be used in place of, or interleaved with, PLResultSet::nextAndReturnError:.
+ *
+ * Column indexes are validated once per call, rather than once per value, allowing large result sets to be
+ * efficiently read in fixed size chunks:
+ *
+ * @code
+ * int64_t ids[1024];
+ * double values[1024];
+ * uint8_t nulls[1024 / 8];
+ * int columns[] = { 0, 1 };
+ * PLResultSetColumnBuffer buffers[] = {
+ *     { PLResultSetColumnBufferTypeInt64, ids, NULL },
+ *     { PLResultSetColumnBufferTypeDouble, values, nulls }
+ * };
+ *
+ * NSUInteger count;
+ * PLResultSetStatus status;
+ * do {
+ *     status = [rs fetchColumns: columns intoBuffers: buffers columnCount: 2 maxRows: 1024 rowsFetched: &count error: &error];
+ *     // process count rows
+ * } while (status == PLResultSetStatusRow);
+ * @endcode
+ *
+ * Will throw NSException if any column index is out of range.
+ *
+ * @param columnIndexes The indexes of the columns to be fetched.
+ * @param buffers The destination buffers, one for each of the @a columnIndexes.
+ * @param columnCount The number of column indexes and buffers.
+ * @param maxRows The maximum number of rows to fetch. Must be greater than zero.
+ * @param rowsFetched On return, the number of rows fetched.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the rows could not be fetched.
+ * If no error occurs, this parameter's value will not be modified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ *
+ * @return Returns #PLResultSetStatusRow if @a maxRows rows were fetched and further rows may be available, or
+ * #PLResultSetStatusDone if no further rows are available. If an error occurs, #PLResultSetStatusError will be
+ * returned; the rows fetched prior to the error remain valid.
+ */
+- (PLResultSetStatus) fetchColumns: (const int *) columnIndexes
+                       intoBuffers: (PLResultSetColumnBuffer *) buffers
+                       columnCount: (int) columnCount
+                           maxRows: (NSUInteger) maxRows
+                       rowsFetched: (NSUInteger *) rowsFetched
+                             error: (NSError **) outError;
 
+/**
+ * Decode up to @a maxRows rows into an array of C structs, as described by @a mapping, advancing the cursor past
+ * each row decoded. Rows are decoded starting with the row following the current row; this method may be used in
+ * place of, or interleaved with, PLResultSet::nextAndReturnError:.
+ *
+ * The mapping's column names are resolved once per result set, and no Objective-C objects are allocated per row
+ * or per value:
+ *
+ * @code
+ * Example rows[256];
+ * NSUInteger count;
+ * PLResultSetStatus status;
+ * do {
+ *     status = [rs decodeRowsWithMapping: mapping into: rows stride: sizeof(Example) maxRows: 256 rowsDecoded: &count error: &error];
+ *     // process count rows
+ * } while (status == PLResultSetStatusRow);
+ * @endcode
+ *
+ * Will throw NSException if any of the mapping's column names are unknown, or if any mapped field extends past @a stride.
+ *
+ * @param mapping The row mapping.
+ * @param rows The destination array, with room for at least @a maxRows elements.
+ * @param stride The size of each array element, in bytes; generally, sizeof() the destination struct.
+ * @param maxRows The maximum number of rows to decode. Must be greater than zero.
+ * @param rowsDecoded On return, the number of rows decoded.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the rows could not be decoded.
+ * If no error occurs, this parameter's value will not be modified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ *
+ * @return Returns #PLResultSetStatusRow if @a maxRows rows were decoded and further rows may be available, or
+ * #PLResultSetStatusDone if no further rows are available. If an error occurs, #PLResultSetStatusError will be
+ * returned; the rows decoded prior to the error remain valid.
+ */
+- (PLResultSetStatus) decodeRowsWithMapping: (PLRowMapping *) mapping
+                                       into: (void *) rows
+                                     stride: (size_t) stride
+                                    maxRows: (NSUInteger) maxRows
+                                rowsDecoded: (NSUInteger *) rowsDecoded
+                                      error: (NSError **) outError;
 
 @end
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Destination field types supported by PLRowMapping.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** BOOL. NULL values are decoded as NO. */
+    PLRowMappingFieldTypeBool = 0,
+
+    /** int32_t. NULL values are decoded as 0. */
+    PLRowMappingFieldTypeInt32 = 1,
+
+    /** int64_t. NULL values are decoded as 0. */
+    PLRowMappingFieldTypeInt64 = 2,
+
+    /** float. NULL values are decoded as 0.0. */
+    PLRowMappingFieldTypeFloat = 3,
+
+    /** double. NULL values are decoded as 0.0. */
+    PLRowMappingFieldTypeDouble = 4,
+
+    /** A fixed size char array of PLRowMappingField::size bytes. The UTF-8 text value is copied into the array and
+     * NUL terminated, truncating it if necessary. NULL values are decoded as the empty string. */
+    PLRowMappingFieldTypeUTF8Buffer = 5,
+
+    /** BOOL, set to YES if the column value is NULL, NO otherwise. */
+    PLRowMappingFieldTypeIsNull = 6
+} PLRowMappingFieldType;
+
+/**
+ * Describes a single struct field populated by a PLRowMapping.
+ */
+typedef struct PLRowMappingField {
+    /** The name of the result column to be decoded. Column names are matched case-insensitively. */
+    const char *columnName;
+
+    /** The type of the destination field. */
+    PLRowMappingFieldType type;
+
+    /** The offset of the destination field within the struct, as returned by offsetof(). */
+    size_t offset;
+
+    /** The size of the destination field, in bytes. Only used by #PLRowMappingFieldTypeUTF8Buffer, for which it
+     * must be at least 1; ignored for all other types. */
+    size_t size;
+} PLRowMappingField;
+
+@interface PLRowMapping : NSObject {
+@private
+    /** The field descriptions, including our copies of their column names. */
+    PLRowMappingField *_fields;
+
+    /** The number of fields. */
+    NSUInteger _fieldCount;
+
+    /** The column names, as NSStrings, in field order. */
+    NSArray *_columnNames;
+}
+
++ (id) mappingWithFields: (const PLRowMappingField *) fields count: (NSUInteger) count;
+
+- (id) initWithFields: (const PLRowMappingField *) fields count: (NSUInteger) count;
+
+/** The number of fields in the mapping. */
+@property(nonatomic, readonly) NSUInteger fieldCount;
+
+/** The mapping's field descriptions, in field order. */
+@property(nonatomic, readonly) const PLRowMappingField *fields;
+
+/** The names of the result columns decoded by the mapping, in field order. */
+@property(nonatomic, readonly) NSArray *columnNames;
+
+@end
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLRowMapping.h"
+#import "PLDatabaseConstants.h"
+
+/**
+ * An immutable description of how result rows are decoded into C structs, for use with
+ * PLResultSet::decodeRowsWithMapping:into:stride:maxRows:rowsDecoded:error:.
+ *
+ * A mapping is typically created once, from a static field table:
+ *
+ * @code
+ * typedef struct Example {
+ *     int64_t id;
+ *     double price;
+ *     char name[32];
+ * } Example;
+ *
+ * static const PLRowMappingField ExampleFields[] = {
+ *     { "id",    PLRowMappingFieldTypeInt64,      offsetof(Example, id),    0 },
+ *     { "price", PLRowMappingFieldTypeDouble,     offsetof(Example, price), 0 },
+ *     { "name",  PLRowMappingFieldTypeUTF8Buffer, offsetof(Example, name),  sizeof(((Example *) 0)->name) }
+ * };
+ *
+ * PLRowMapping *mapping = [PLRowMapping mappingWithFields: ExampleFields count: 3];
+ * @endcode
+ *
+ * The mapping's column names are resolved to column indexes once per result set, when the first rows are decoded.
+ *
+ * @par Thread Safety
+ * Immutable and thread-safe.
+ */
+@implementation PLRowMapping
+
+@synthesize fieldCount = _fieldCount;
+@synthesize fields = _fields;
+@synthesize columnNames = _columnNames;
+
+/**
+ * Return a new mapping with the given field descriptions.
+ *
+ * @param fields The field descriptions. The descriptions and their column names are copied.
+ * @param count The number of field descriptions.
+ */
++ (id) mappingWithFields: (const PLRowMappingField *) fields count: (NSUInteger) count {
+    return [[[self alloc] initWithFields: fields count: count] autorelease];
+}
+
+/**
+ * Initialize a new mapping with the given field descriptions.
+ *
+ * Will throw NSException if a field type is unknown, or a #PLRowMappingFieldTypeUTF8Buffer field has a size of 0.
+ *
+ * @param fields The field descriptions. The descriptions and their column names are copied.
+ * @param count The number of field descriptions.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLRowMapping class.
+ */
+- (id) initWithFields: (const PLRowMappingField *) fields count: (NSUInteger) count {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    /* Validate the field descriptions */
+    for (NSUInteger i = 0; i < count; i++) {
+        if (fields[i].type < PLRowMappingFieldTypeBool || fields[i].type > PLRowMappingFieldTypeIsNull) {
+            [self release];
+            [NSException raise: PLDatabaseException format: @"Unknown row mapping field type %d", fields[i].type];
+        }
+
+        if (fields[i].type == PLRowMappingFieldTypeUTF8Buffer && fields[i].size == 0) {
+            [self release];
+            [NSException raise: PLDatabaseException format: @"Row mapping field '%s' has a zero-length buffer", fields[i].columnName];
+        }
+    }
+
+    /* Copy the descriptions and their column names */
+    _fieldCount = count;
+    _fields = malloc(sizeof(PLRowMappingField) * (count > 0 ? count : 1));
+
+    NSMutableArray *columnNames = [NSMutableArray arrayWithCapacity: count];
+    for (NSUInteger i = 0; i < count; i++) {
+        _fields[i] = fields[i];
+        _fields[i].columnName = strdup(fields[i].columnName);
+        [columnNames addObject: [NSString stringWithUTF8String: fields[i].columnName]];
+    }
+    _columnNames = [columnNames copy];
+
+    return self;
+}
+
+- (void) dealloc {
+    for (NSUInteger i = 0; i < _fieldCount; i++)
+        free((char *) _fields[i].columnName);
+    free(_fields);
+    [_columnNames release];
+
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PLRowMapping.h"
+
+@interface PLRowMappingTests : SenTestCase {
+@private
+}
+
+@end
+
+typedef struct PLRowMappingTestRow {
+    int64_t a;
+    char b[8];
+} PLRowMappingTestRow;
+
+@implementation PLRowMappingTests
+
+- (void) testInit {
+    PLRowMappingField fields[] = {
+        { "a", PLRowMappingFieldTypeInt64, offsetof(PLRowMappingTestRow, a), 0 },
+        { "b", PLRowMappingFieldTypeUTF8Buffer, offsetof(PLRowMappingTestRow, b), sizeof(((PLRowMappingTestRow *) 0)->b) }
+    };
+    PLRowMapping *mapping = [PLRowMapping mappingWithFields: fields count: 2];
+
+    STAssertEquals((NSUInteger) 2, mapping.fieldCount, @"Incorrect field count");
+    STAssertEqualObjects(([NSArray arrayWithObjects: @"a", @"b", nil]), mapping.columnNames, @"Incorrect column names");
+
+    /* The field descriptions must be copied */
+    fields[1].columnName = "c";
+    STAssertTrue(strcmp("b", mapping.fields[1].columnName) == 0, @"Column name was not copied");
+    STAssertEquals((size_t) 8, mapping.fields[1].size, @"Incorrect field size");
+}
+
+- (void) testInvalidFields {
+    PLRowMappingField emptyBuffer[] = {
+        { "b", PLRowMappingFieldTypeUTF8Buffer, 0, 0 }
+    };
+    STAssertThrows([PLRowMapping mappingWithFields: emptyBuffer count: 1], @"Zero-length buffer was accepted");
+
+    PLRowMappingField badType[] = {
+        { "a", (PLRowMappingFieldType) 42, 0, 0 }
+    };
+    STAssertThrows([PLRowMapping mappingWithFields: badType count: 1], @"Unknown field type was accepted");
+}
+
+@end
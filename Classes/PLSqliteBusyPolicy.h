@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class PLSqliteDatabase;
+
+/**
+ * Busy wait metrics, as recorded by a PLSqliteDatabase connection.
+ */
+typedef struct PLSqliteBusyMetrics {
+    /** The number of times a statement found the database locked, and waited. */
+    uint64_t waitCount;
+
+    /** The number of times a statement gave up on a locked database, either at the deadline, or at the request of
+     * the wait block. This includes statements that gave up without waiting. */
+    uint64_t timeoutCount;
+
+    /** The total time spent waiting, in seconds. */
+    NSTimeInterval totalWaitTime;
+
+    /** The longest single wait, in seconds. */
+    NSTimeInterval maxWaitTime;
+} PLSqliteBusyMetrics;
+
+/**
+ * A block called each time a statement is about to wait on a locked database.
+ *
+ * @param database The waiting connection. The block must not use the connection.
+ * @param attempt The number of times the statement has already waited on this lock, starting at 0.
+ * @param waited The time, in seconds, that the statement has waited on this lock so far.
+ * @return YES to continue waiting, or NO to fail the statement immediately with SQLITE_BUSY.
+ */
+typedef BOOL (^PLSqliteBusyWaitBlock)(PLSqliteDatabase *database, NSUInteger attempt, NSTimeInterval waited);
+
+@interface PLSqliteBusyPolicy : NSObject <NSCopying> {
+@private
+    /** Maximum time a statement will wait on a locked database. */
+    NSTimeInterval _timeout;
+
+    /** Initial sleep interval. */
+    NSTimeInterval _initialSleep;
+
+    /** Maximum sleep interval. */
+    NSTimeInterval _maxSleep;
+
+    /** Factor by which the sleep interval grows with each attempt. */
+    double _sleepMultiplier;
+
+    /** Wait block, or nil. */
+    PLSqliteBusyWaitBlock _waitBlock;
+}
+
++ (id) defaultPolicy;
+
+- (NSTimeInterval) sleepIntervalForAttempt: (NSUInteger) attempt;
+
+/** The maximum time, in seconds, that a statement will wait on a locked database before failing with SQLITE_BUSY.
+ * If 0, statements fail immediately. Defaults to 600 (10 minutes). */
+@property(nonatomic, assign) NSTimeInterval timeout;
+
+/** The first sleep interval, in seconds. Defaults to 0.001. */
+@property(nonatomic, assign) NSTimeInterval initialSleep;
+
+/** The maximum sleep interval, in seconds. Defaults to 0.1. */
+@property(nonatomic, assign) NSTimeInterval maxSleep;
+
+/** The factor by which the sleep interval grows with each attempt. Defaults to 2.0. */
+@property(nonatomic, assign) double sleepMultiplier;
+
+/** A block called before each wait, which may report the wait time and end the wait early, or nil. Defaults
+ * to nil. */
+@property(nonatomic, copy) PLSqliteBusyWaitBlock waitBlock;
+
+@end
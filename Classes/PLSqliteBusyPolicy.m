@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteBusyPolicy.h"
+
+#import <math.h>
+
+/** Default busy timeout, in seconds. */
+#define PL_SQLITE_DEFAULT_BUSY_TIMEOUT (10 * 60)
+
+/**
+ * Policy for waiting on a locked SQLite database.
+ *
+ * When a statement finds the database locked by another connection, the connection sleeps and retries the lock,
+ * starting with initialSleep and multiplying the interval by sleepMultiplier with each attempt, up to maxSleep, until
+ * the lock is acquired or the timeout elapses. The optional wait block is called before each sleep with the time waited
+ * so far; it may record the wait, or return NO to give up early (for example, to shed load rather than queue behind
+ * a stuck writer).
+ *
+ * Each connection records its waits; see PLSqliteDatabase::busyMetrics.
+ *
+ * @par Thread Safety
+ * PLSqliteBusyPolicy instances implement no locking and must not be mutated while shared between threads.
+ */
+@implementation PLSqliteBusyPolicy
+
+@synthesize timeout = _timeout;
+@synthesize initialSleep = _initialSleep;
+@synthesize maxSleep = _maxSleep;
+@synthesize sleepMultiplier = _sleepMultiplier;
+@synthesize waitBlock = _waitBlock;
+
+/**
+ * Return a new policy with the default values: wait for up to 10 minutes, sleeping from 1ms up to 100ms.
+ */
++ (id) defaultPolicy {
+    return [[[self alloc] init] autorelease];
+}
+
+/**
+ * Initialize a new policy with the default values.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteBusyPolicy class.
+ */
+- (id) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _timeout = PL_SQLITE_DEFAULT_BUSY_TIMEOUT;
+    _initialSleep = 0.001;
+    _maxSleep = 0.1;
+    _sleepMultiplier = 2.0;
+
+    return self;
+}
+
+- (void) dealloc {
+    [_waitBlock release];
+
+    [super dealloc];
+}
+
+/**
+ * Return the interval, in seconds, to sleep before the given attempt to acquire the lock.
+ *
+ * @param attempt The number of times the statement has already waited on the lock, starting at 0.
+ */
+- (NSTimeInterval) sleepIntervalForAttempt: (NSUInteger) attempt {
+    NSTimeInterval interval = _initialSleep * pow(_sleepMultiplier, (double) attempt);
+    if (interval > _maxSleep)
+        interval = _maxSleep;
+
+    return interval;
+}
+
+// from NSCopying protocol
+- (id) copyWithZone: (NSZone *) zone {
+    PLSqliteBusyPolicy *copy = [[[self class] allocWithZone: zone] init];
+
+    copy->_timeout = _timeout;
+    copy->_initialSleep = _initialSleep;
+    copy->_maxSleep = _maxSleep;
+    copy->_sleepMultiplier = _sleepMultiplier;
+    copy->_waitBlock = [_waitBlock copy];
+
+    return copy;
+}
+
+@end
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PlausibleDatabase.h"
+
+@interface PLSqliteBusyPolicyTests : SenTestCase {
+@private
+    NSString *_dbPath;
+
+    /** Connection holding the write lock */
+    PLSqliteDatabase *_holder;
+}
+
+- (PLSqliteDatabase *) waiterWithPolicy: (PLSqliteBusyPolicy *) policy;
+
+@end
+
+@implementation PLSqliteBusyPolicyTests
+
+- (void) setUp {
+    /* Create a temporary file for the database. Secure -- user owns enclosing directory. */
+    _dbPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+
+    /* Create the table, and hold the write lock */
+    _holder = [[PLSqliteDatabase alloc] initWithPath: _dbPath];
+    STAssertTrue([_holder open], @"Could not open database");
+    STAssertTrue([_holder executeUpdate: @"CREATE TABLE test (a INTEGER)"], @"Could not create table");
+    STAssertTrue([_holder executeUpdate: @"BEGIN EXCLUSIVE"], @"Could not acquire the write lock");
+}
+
+- (void) tearDown {
+    [_holder executeUpdate: @"ROLLBACK"];
+    [_holder close];
+    [_holder release];
+
+    /* Remove the temporary database file */
+    if ([[NSFileManager defaultManager] fileExistsAtPath: _dbPath])
+        STAssertTrue([[NSFileManager defaultManager] removeItemAtPath: _dbPath error: NULL], @"Could not clean up database %@", _dbPath);
+
+    [_dbPath release];
+}
+
+/* Return a new, open connection to the test database using the given busy policy */
+- (PLSqliteDatabase *) waiterWithPolicy: (PLSqliteBusyPolicy *) policy {
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.busyPolicy = policy;
+
+    PLSqliteDatabase *db = [[[PLSqliteDatabase alloc] initWithPath: _dbPath options: options] autorelease];
+    STAssertTrue([db open], @"Could not open database");
+
+    return db;
+}
+
+- (void) testDefaults {
+    PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+
+    STAssertEquals((NSTimeInterval) 600, [policy timeout], @"Default policy should wait for 10 minutes");
+    STAssertNil([policy waitBlock], @"Default policy should not have a wait block");
+}
+
+- (void) testSleepCurve {
+    PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+    policy.initialSleep = 0.001;
+    policy.maxSleep = 0.004;
+    policy.sleepMultiplier = 2.0;
+
+    STAssertEqualsWithAccuracy(0.001, [policy sleepIntervalForAttempt: 0], 1e-9, @"Incorrect initial sleep");
+    STAssertEqualsWithAccuracy(0.002, [policy sleepIntervalForAttempt: 1], 1e-9, @"Sleep did not grow");
+    STAssertEqualsWithAccuracy(0.004, [policy sleepIntervalForAttempt: 2], 1e-9, @"Sleep did not grow");
+    STAssertEqualsWithAccuracy(0.004, [policy sleepIntervalForAttempt: 10], 1e-9, @"Sleep exceeded the maximum");
+}
+
+- (void) testCopy {
+    PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+    policy.timeout = 1.5;
+    policy.initialSleep = 0.01;
+    policy.maxSleep = 0.5;
+    policy.sleepMultiplier = 3.0;
+    policy.waitBlock = ^(PLSqliteDatabase *database, NSUInteger attempt, NSTimeInterval waited) { return YES; };
+
+    PLSqliteBusyPolicy *copy = [[policy copy] autorelease];
+    STAssertEquals(1.5, [copy timeout], @"Timeout not copied");
+    STAssertEquals(0.01, [copy initialSleep], @"Initial sleep not copied");
+    STAssertEquals(0.5, [copy maxSleep], @"Max sleep not copied");
+    STAssertEquals(3.0, [copy sleepMultiplier], @"Multiplier not copied");
+    STAssertNotNil([copy waitBlock], @"Wait block not copied");
+}
+
+- (void) testTimeout {
+    PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+    policy.timeout = 0.1;
+
+    PLSqliteDatabase *db = [self waiterWithPolicy: policy];
+    NSError *error;
+
+    NSDate *start = [NSDate date];
+    STAssertFalse([db executeUpdateAndReturnError: &error statement: @"INSERT INTO test (a) VALUES (1)"], @"Insert should fail while locked");
+    NSTimeInterval elapsed = -[start timeIntervalSinceNow];
+
+    STAssertEquals(SQLITE_BUSY, [[[error userInfo] objectForKey: PLDatabaseErrorVendorErrorKey] intValue], @"Expected SQLITE_BUSY");
+    STAssertTrue(elapsed >= 0.09 && elapsed < 5.0, @"Wait of %f did not honor the timeout", elapsed);
+
+    /* Verify the metrics */
+    PLSqliteBusyMetrics metrics = [db busyMetrics];
+    STAssertEquals((uint64_t) 1, metrics.waitCount, @"Wait not recorded");
+    STAssertEquals((uint64_t) 1, metrics.timeoutCount, @"Timeout not recorded");
+    STAssertTrue(metrics.totalWaitTime >= 0.09, @"Wait time %f not recorded", metrics.totalWaitTime);
+    STAssertTrue(metrics.maxWaitTime >= 0.09, @"Max wait time %f not recorded", metrics.maxWaitTime);
+
+    [db resetBusyMetrics];
+    STAssertEquals((uint64_t) 0, [db busyMetrics].waitCount, @"Metrics not reset");
+
+    /* Once the lock is released, the insert should succeed without waiting */
+    STAssertTrue([_holder executeUpdate: @"COMMIT"], @"Could not release the write lock");
+    STAssertTrue([db executeUpdate: @"INSERT INTO test (a) VALUES (1)"], @"Insert failed");
+    STAssertEquals((uint64_t) 0, [db busyMetrics].waitCount, @"Unexpected wait");
+    [db close];
+}
+
+/* A zero timeout gives up without waiting; only the timeout is counted */
+- (void) testZeroTimeout {
+    PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+    policy.timeout = 0;
+
+    PLSqliteDatabase *db = [self waiterWithPolicy: policy];
+    STAssertFalse([db executeUpdateAndReturnError: NULL statement: @"INSERT INTO test (a) VALUES (1)"], @"Insert should fail while locked");
+
+    PLSqliteBusyMetrics metrics = [db busyMetrics];
+    STAssertEquals((uint64_t) 0, metrics.waitCount, @"A wait was recorded without sleeping");
+    STAssertEquals((uint64_t) 1, metrics.timeoutCount, @"Timeout not recorded");
+    STAssertEquals((NSTimeInterval) 0, metrics.totalWaitTime, @"Wait time recorded without sleeping");
+    [db close];
+}
+
+- (void) testWaitBlock {
+    PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+    __block NSUInteger calls = 0;
+    __block NSTimeInterval lastWaited = 0;
+
+    /* Shed load after three attempts */
+    policy.waitBlock = ^(PLSqliteDatabase *database, NSUInteger attempt, NSTimeInterval waited) {
+        STAssertEquals(calls, attempt, @"Unexpected attempt number");
+        STAssertTrue(waited >= lastWaited, @"Wait time decreased");
+        lastWaited = waited;
+        calls++;
+        return (BOOL) (attempt < 3);
+    };
+
+    PLSqliteDatabase *db = [self waiterWithPolicy: policy];
+    STAssertFalse([db executeUpdateAndReturnError: NULL statement: @"INSERT INTO test (a) VALUES (1)"], @"Insert should fail while locked");
+    STAssertEquals((NSUInteger) 4, calls, @"Wait block not called for each attempt");
+    STAssertTrue(lastWaited > 0, @"Wait time not reported");
+    STAssertEquals((uint64_t) 1, [db busyMetrics].timeoutCount, @"Timeout not recorded");
+    [db close];
+}
+
+@end
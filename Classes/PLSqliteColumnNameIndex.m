@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteColumnNameIndex.h"
+
+/** Maximum length of a column name that will be converted to UTF-8 on the stack, including the NUL terminator. */
+#define PL_COLUMN_NAME_BUFFER_SIZE 256
+
+/* Case-insensitive (ASCII only, matching SQLite's identifier rules) FNV-1a hash of a NUL terminated UTF-8 string. */
+static uint32_t column_name_hash (const char *name) {
+    uint32_t hash = 2166136261U;
+    for (const unsigned char *c = (const unsigned char *) name; *c != '\0'; c++) {
+        unsigned char folded = (*c >= 'A' && *c <= 'Z') ? (unsigned char) (*c + ('a' - 'A')) : *c;
+        hash = (hash ^ folded) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * @internal
+ *
+ * An immutable, case-insensitive mapping of result column names to column indexes for a prepared statement.
+ *
+ * The index is built once per prepared query, and may be shared by all statements prepared from the same query
+ * string; lookups perform no allocation for column names of less than PL_COLUMN_NAME_BUFFER_SIZE bytes. As with
+ * SQLite itself, only ASCII characters are compared case-insensitively.
+ *
+ * @par Thread Safety
+ * Immutable and thread-safe.
+ */
+@implementation PLSqliteColumnNameIndex
+
+/**
+ * Initialize the index with the result column names of @a stmt.
+ *
+ * If multiple columns share the same name, the last such column will be returned by lookups.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteColumnNameIndex class.
+ */
+- (id) initWithStatement: (sqlite3_stmt *) stmt {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _columnCount = sqlite3_column_count(stmt);
+    _names = calloc(_columnCount > 0 ? _columnCount : 1, sizeof(char *));
+
+    /* Size the table to a power of two with a load factor of at most 0.5 */
+    uint32_t tableSize = 8;
+    while (tableSize < (uint32_t) _columnCount * 2)
+        tableSize *= 2;
+    _tableMask = tableSize - 1;
+    _table = calloc(tableSize, sizeof(int));
+
+    for (int columnIndex = 0; columnIndex < _columnCount; columnIndex++) {
+        const char *name = sqlite3_column_name(stmt, columnIndex);
+        _names[columnIndex] = strdup(name != NULL ? name : "");
+
+        /* Insert, replacing any earlier column of the same name */
+        uint32_t slot = column_name_hash(_names[columnIndex]) & _tableMask;
+        while (_table[slot] != 0 && sqlite3_stricmp(_names[_table[slot] - 1], _names[columnIndex]) != 0)
+            slot = (slot + 1) & _tableMask;
+        _table[slot] = columnIndex + 1;
+    }
+
+    return self;
+}
+
+- (void) dealloc {
+    for (int i = 0; i < _columnCount; i++)
+        free(_names[i]);
+    free(_names);
+    free(_table);
+
+    [super dealloc];
+}
+
+/**
+ * Return the index of the column named @a name, or -1 if no such column exists or @a name is nil.
+ *
+ * SQLite may transparently re-prepare a statement following a schema change, altering its result columns; the
+ * index is verified against @a stmt, falling back on a scan of the statement's current column names if it is
+ * found to be stale.
+ *
+ * @param name The column name to look up.
+ * @param stmt The statement that will be used to access the column.
+ */
+- (int) indexOfColumnName: (NSString *) name statement: (sqlite3_stmt *) stmt {
+    char buffer[PL_COLUMN_NAME_BUFFER_SIZE];
+
+    /* A nil name matches no column */
+    if (name == nil)
+        return -1;
+
+    /* Fetch the UTF-8 representation without allocating, if possible */
+    const char *cname = CFStringGetCStringPtr((CFStringRef) name, kCFStringEncodingUTF8);
+    if (cname == NULL) {
+        if (CFStringGetCString((CFStringRef) name, buffer, sizeof(buffer), kCFStringEncodingUTF8))
+            cname = buffer;
+        else
+            cname = [name UTF8String];
+    }
+
+    /* Probe the table */
+    int columnCount = sqlite3_column_count(stmt);
+    uint32_t slot = column_name_hash(cname) & _tableMask;
+    while (_table[slot] != 0) {
+        int columnIndex = _table[slot] - 1;
+        if (sqlite3_stricmp(_names[columnIndex], cname) == 0) {
+            /* Verify that the statement's columns have not changed */
+            if (columnIndex < columnCount && sqlite3_stricmp(sqlite3_column_name(stmt, columnIndex), cname) == 0)
+                return columnIndex;
+            break;
+        }
+        slot = (slot + 1) & _tableMask;
+    }
+
+    /* Not found in the index; the statement may have been re-prepared with differing columns, so fall back on
+     * a scan of its current column names. As in the index, the last matching column wins. */
+    for (int i = columnCount - 1; i >= 0; i--) {
+        if (sqlite3_stricmp(sqlite3_column_name(stmt, i), cname) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+@end
@@ -31,6 +31,7 @@
 #import <Foundation/Foundation.h>
 
 #import "PLDatabaseConnectionProvider.h"
+#import "PLSqliteDatabaseOptions.h"
 
 @interface PLSqliteConnectionProvider : NSObject <PLDatabaseConnectionProvider> {
 @private
@@ -42,9 +43,15 @@
 
     /** If NO, ignore _flags and allow the database driver to set the default flags. */
     BOOL _useFlags;
+
+    /** Options for new connections, or nil to use the database driver's default options. */
+    PLSqliteDatabaseOptions *_options;
 }
 
 - (id) initWithPath: (NSString *) dbPath;
 - (id) initWithPath: (NSString *) dbPath flags: (int) flags;
 
+- (id) initWithPath: (NSString *) dbPath options: (PLSqliteDatabaseOptions *) options;
+- (id) initWithPath: (NSString *) dbPath flags: (int) flags options: (PLSqliteDatabaseOptions *) options;
+
 @end
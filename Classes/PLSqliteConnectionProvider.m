@@ -47,8 +47,9 @@
  * @param flags The SQLite-defined flags that will be passed directly to sqlite3_open_v2() or an equivalent API.
  * @return YES if the database was successfully opened, NO on failure.
  * @param useFlags If NO, the @a flags argument will be ignored.
+ * @param options The connection options, or nil to use the default options.
  */
-- (id) initWithPath: (NSString *) dbPath flags: (int) flags useFlags: (BOOL) useFlags {
+- (id) initWithPath: (NSString *) dbPath flags: (int) flags useFlags: (BOOL) useFlags options: (PLSqliteDatabaseOptions *) options {
     if ((self = [super init]) == nil)
         return nil;
     
@@ -56,6 +57,7 @@
     _dbPath = [dbPath retain];
     _flags = flags;
     _useFlags = useFlags;
+    _options = [options copy];
     
     return self;
 }
@@ -67,7 +69,7 @@
  * @param dbPath Path to the sqlite database file.
  */
 - (id) initWithPath: (NSString *) dbPath {
-    return [self initWithPath: dbPath flags: 0 useFlags: NO];
+    return [self initWithPath: dbPath flags: 0 useFlags: NO options: nil];
 }
 
 /**
@@ -83,13 +85,41 @@
  * http://www.sqlite.org/c3ref/open.html
  */
 - (id) initWithPath: (NSString *) dbPath flags: (int) flags {
-    return [self initWithPath: dbPath flags: flags useFlags: YES];
+    return [self initWithPath: dbPath flags: flags useFlags: YES options: nil];
+}
+
+/**
+ * Initialize the database connection delegate with the provided
+ * file path and connection options.
+ *
+ * @param dbPath Path to the sqlite database file.
+ * @param options The options to be used for all new connections. The options will be copied.
+ */
+- (id) initWithPath: (NSString *) dbPath options: (PLSqliteDatabaseOptions *) options {
+    return [self initWithPath: dbPath flags: 0 useFlags: NO options: options];
+}
+
+/**
+ * Initialize the database connection delegate with the provided
+ * file path, flags, and connection options.
+ *
+ * @param dbPath Path to the sqlite database file.
+ * @param flags The SQLite-defined flags that will be passed directly to sqlite3_open_v2() or an equivalent API.
+ * @param options The options to be used for all new connections. The options will be copied.
+ *
+ * @par Supported Flags
+ * The flags supported by SQLite are defined in the SQLite C API Documentation:
+ * http://www.sqlite.org/c3ref/open.html
+ */
+- (id) initWithPath: (NSString *) dbPath flags: (int) flags options: (PLSqliteDatabaseOptions *) options {
+    return [self initWithPath: dbPath flags: flags useFlags: YES options: options];
 }
 
 
 
 - (void) dealloc {
     [_dbPath release];
+    [_options release];
     
     [super dealloc];
 }
@@ -99,7 +129,7 @@
     PLSqliteDatabase *database;
 
     /* Create and attempt to open */
-    database = [[[PLSqliteDatabase alloc] initWithPath: _dbPath] autorelease];
+    database = [[[PLSqliteDatabase alloc] initWithPath: _dbPath options: _options] autorelease];
 
     /* Open with the correct flags (or the default flags) */
     BOOL ret;
@@ -96,4 +96,24 @@
     STAssertFalse([db goodConnection], @"Connection should be closed");
 }
 
+- (void) testInitWithOptions {
+    PLSqliteConnectionProvider *provider;
+    PLSqliteDatabase *db;
+
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.statementCacheCapacity = 5;
+
+    /* Create our delegate and request a connection */
+    provider = [[[PLSqliteConnectionProvider alloc] initWithPath: _dbPath options: options] autorelease];
+    db = (PLSqliteDatabase *) [provider getConnectionAndReturnError: NULL];
+
+    /* Test the connection */
+    STAssertNotNil(db, @"Delegate returned nil.");
+    STAssertTrue([db goodConnection], @"Database connection claims to be bad.");
+    STAssertEquals((NSUInteger) 5, [[db options] statementCacheCapacity], @"Options were not applied");
+
+    /* Try to be polite */
+    [provider closeConnection: db];
+}
+
 @end
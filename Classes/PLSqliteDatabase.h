@@ -37,7 +37,9 @@
 #endif
 
 #import "PLDatabase.h"
+#import "PLSqliteDatabaseOptions.h"
 #import "PLSqliteStatementCache.h"
+#import "PLSqliteStatementHandle.h"
 
 extern NSString *PLSqliteException;
 
@@ -45,14 +47,34 @@ extern NSString *PLSqliteException;
 @private
     /** Path to the database file. */
     NSString *_path;
+
+    /** Connection options. */
+    PLSqliteDatabaseOptions *_options;
     
     /** Underlying sqlite database reference. */
     sqlite3 *_sqlite;
 
-    /** If YES, a transaction monitored for SQLITE_BUSY is currently active. In the future, we may replace this with a
-     * stack to automatically support nested transactions via save points. */
+    /** If YES, a transaction monitored for SQLITE_BUSY is currently active. */
     BOOL _monitorTx;
 
+    /** The number of nested transactions (save points) currently active within the monitored transaction. */
+    NSUInteger _savepointDepth;
+
+    /** The number of retries performed by the most recent transaction. */
+    NSUInteger _lastTransactionRetryCount;
+
+    /** The total number of transaction retries performed. */
+    uint64_t _totalTransactionRetryCount;
+
+    /** The total number of transactions that failed after exhausting the retry policy. */
+    uint64_t _totalTransactionRetryFailures;
+
+    /** The monotonic time, in seconds, at which the current busy wait began. */
+    double _busyWaitStart;
+
+    /** Busy wait metrics. */
+    PLSqliteBusyMetrics _busyMetrics;
+
     /** If YES, SQLITE_BUSY was returned from a monitored transaction. */
     BOOL _txBusy;
 
@@ -61,8 +83,10 @@ extern NSString *PLSqliteException;
 }
 
 + (id) databaseWithPath: (NSString *) dbPath;
++ (id) databaseWithPath: (NSString *) dbPath options: (PLSqliteDatabaseOptions *) options;
 
 - (id) initWithPath: (NSString*) dbPath;
+- (id) initWithPath: (NSString*) dbPath options: (PLSqliteDatabaseOptions *) options;
 
 - (BOOL) open;
 - (BOOL) openAndReturnError: (NSError **) error;
@@ -73,6 +97,30 @@ extern NSString *PLSqliteException;
 - (sqlite3 *) sqliteHandle;
 - (int64_t) lastInsertRowId;
 
+- (PLSqliteBusyMetrics) busyMetrics;
+- (void) resetBusyMetrics;
+
+- (PLSqliteTuningProfile *) tuningProfileAndReturnError: (NSError **) outError;
+
+- (PLSqliteStatementHandle *) statementHandleForSQL: (NSString *) statement;
+- (id<PLPreparedStatement>) prepareStatementWithHandle: (PLSqliteStatementHandle *) handle;
+- (id<PLPreparedStatement>) prepareStatementWithHandle: (PLSqliteStatementHandle *) handle error: (NSError **) outError;
+
+/** The options with which the database was initialized. */
+@property(nonatomic, readonly) PLSqliteDatabaseOptions *options;
+
+/** The path with which the database was initialized. */
+@property(nonatomic, readonly) NSString *path;
+
+/** The number of times the most recent performTransaction call retried its transaction due to lock contention. */
+@property(nonatomic, readonly) NSUInteger lastTransactionRetryCount;
+
+/** The total number of transaction retries performed by this connection. */
+@property(nonatomic, readonly) uint64_t totalTransactionRetryCount;
+
+/** The total number of transactions that failed with #PLDatabaseErrorTimedOut after exhausting the retry policy. */
+@property(nonatomic, readonly) uint64_t totalTransactionRetryFailures;
+
 @end
 
 #ifdef PL_DB_PRIVATE
@@ -85,6 +133,8 @@ extern NSString *PLSqliteException;
 - (void) resetTxBusy;
 - (void) setTxBusy;
 
+- (sqlite3_stmt *) createStatement: (NSString *) statement cacheEntry: (PLSqliteStatementCacheEntry **) cacheEntry error: (NSError **) error;
+
 #ifdef PL_SQLITE_LEGACY_STMT_PREPARE
 // This method is only exposed for the purpose of supporting implementations missing sqlite3_prepare_v2()
 - (sqlite3_stmt *) createStatement: (NSString *) statement error: (NSError **) error;
@@ -33,8 +33,37 @@
 #import "PLSqliteResultSet.h"
 #import "PLSqliteUnlockNotify.h"
 
-/* Keep trying for up to 10 minutes. We do not modify the busy timeout handler. */
-#define PL_SQLITE_BUSY_TIMEOUT 10 * 60 * 1000
+#import <time.h>
+
+#ifdef __APPLE__
+#import <mach/mach_time.h>
+#endif
+
+/**
+ * @internal
+ * Return the current monotonic time, in seconds. Unlike the wall clock, the monotonic clock is not stepped, and
+ * is suitable for measuring deadlines and elapsed time.
+ */
+static double pl_sqlite_now (void) {
+#ifdef __APPLE__
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return ((double) mach_absolute_time() * timebase.numer / timebase.denom) / 1e9;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+#endif
+}
+
+/**
+ * @internal
+ * Return YES if the SQLite library supports the mmap_size pragma, which was introduced in SQLite 3.7.17. Earlier
+ * versions silently ignore the pragma.
+ */
+static BOOL pl_sqlite_supports_mmap (void) {
+    return sqlite3_libversion_number() >= 3007017;
+}
 
 
 /** A generic SQLite exception. */
@@ -44,10 +73,26 @@ NSString *PLSqliteException = @"PLSqliteException";
 @interface PLSqliteDatabase (PLSqliteDatabasePrivate)
 
 - (id<PLPreparedStatement>) prepareStatement: (NSString *) statement error: (NSError **) outError closeAtCheckin: (BOOL) closeAtCheckin;
+- (sqlite3_stmt *) prepareAndRegisterStatement: (NSString *) statement error: (NSError **) error;
+- (BOOL) performNestedTransactionWithBlock: (PLDatabaseTransactionResult (^)(void)) block error: (NSError **) outError;
+- (int) waitOnBusyLock: (int) count;
+- (NSString *) executePragma: (NSString *) pragma error: (NSError **) outError;
+- (BOOL) setPragma: (NSString *) name value: (NSString *) value verify: (BOOL) verify error: (NSError **) outError;
+- (BOOL) applyTuningProfile: (PLSqliteTuningProfile *) profile error: (NSError **) outError;
+- (BOOL) prepareTransactionRetry: (NSUInteger) retry policy: (PLSqliteRetryPolicy *) policy startTime: (double) startTime error: (NSError **) outError;
 
 @end
 
 
+/**
+ * @internal
+ * SQLite busy handler; dispatches to the PLSqliteDatabase instance passed as the handler's context.
+ */
+static int pl_sqlite_busy_handler (void *context, int count) {
+    return [(PLSqliteDatabase *) context waitOnBusyLock: count];
+}
+
+
 /**
  * An SQLite PLDatabase driver.
  *
@@ -76,21 +121,54 @@ NSString *PLSqliteException = @"PLSqliteException";
     return [[[self alloc] initWithPath: dbPath] autorelease];
 }
 
+/**
+ * Creates and returns an SQLite database with the provided
+ * file path and options.
+ */
++ (id) databaseWithPath: (NSString *) dbPath options: (PLSqliteDatabaseOptions *) options {
+    return [[[self alloc] initWithPath: dbPath options: options] autorelease];
+}
+
 /**
  * Initialize the SQLite database with the provided
- * file path.
+ * file path and the default options.
+ *
+ * @param dbPath Path to the sqlite database file.
+ */
+- (id) initWithPath: (NSString*) dbPath {
+    return [self initWithPath: dbPath options: nil];
+}
+
+/**
+ * Initialize the SQLite database with the provided
+ * file path and options.
  *
  * @param dbPath Path to the sqlite database file.
+ * @param options The connection options. The options will be copied. If nil, the default options will be used.
  *
  * @par Designated Initializer
  * This method is the designated initializer for the PLSqliteDatabase class.
  */
-- (id) initWithPath: (NSString*) dbPath {
+- (id) initWithPath: (NSString*) dbPath options: (PLSqliteDatabaseOptions *) options {
     if ((self = [super init]) == nil)
         return nil;
 
     _path = [dbPath retain];
-    _statementCache = [[PLSqliteStatementCache alloc] initWithCapacity: 100 /* TODO: configurable? */];
+
+    if (options != nil) {
+        _options = [options copy];
+    } else {
+        _options = [[PLSqliteDatabaseOptions alloc] init];
+    }
+
+    /* A zero capacity cache finalizes all statements at check-in */
+    NSUInteger cacheCapacity = 0;
+    if ([_options isStatementCacheEnabled])
+        cacheCapacity = [_options statementCacheCapacity];
+
+    _statementCache = [[PLSqliteStatementCache alloc] initWithCapacity: cacheCapacity
+                                                        evictionPolicy: [_options statementCacheEvictionPolicy]
+                                                 maxStatementsPerQuery: [_options maxCachedStatementsPerQuery]];
     
     return self;
 }
@@ -101,8 +179,9 @@ NSString *PLSqliteException = @"PLSqliteException";
     /* Drop the statement cache */
     [_statementCache release];
 
-    /* Release our backing path */
+    /* Release our backing path and options */
     [_path release];
+    [_options release];
 
     [super dealloc];
 }
@@ -184,16 +263,24 @@ NSString *PLSqliteException = @"PLSqliteException";
         return NO;
     }
     
-    /* Set a busy timeout */
-    err = sqlite3_busy_timeout(_sqlite, PL_SQLITE_BUSY_TIMEOUT);
+    /* Install the busy handler. The handler is owned by the sqlite3 connection, which never outlives us. */
+    err = sqlite3_busy_handler(_sqlite, pl_sqlite_busy_handler, self);
     if (err != SQLITE_OK) {
         /* This should never happen. */
         [self populateError: error
               withErrorCode: PLDatabaseErrorUnknown
-                description: NSLocalizedString(@"The SQLite database busy timeout could not be set due to an internal error.", @"")
+                description: NSLocalizedString(@"The SQLite database busy handler could not be set due to an internal error.", @"")
                 queryString: nil];
         return NO;
     }
+
+    /* Apply the tuning profile. Persistent settings are applied last, so that a failed open leaves the database
+     * file unchanged. */
+    PLSqliteTuningProfile *profile = [_options tuningProfile];
+    if (profile != nil && ![self applyTuningProfile: profile error: error]) {
+        [self close];
+        return NO;
+    }
     
     /* Success */
     return YES;
@@ -208,6 +295,84 @@ NSString *PLSqliteException = @"PLSqliteException";
     return YES;
 }
 
+@synthesize path = _path;
+@synthesize lastTransactionRetryCount = _lastTransactionRetryCount;
+@synthesize totalTransactionRetryCount = _totalTransactionRetryCount;
+@synthesize totalTransactionRetryFailures = _totalTransactionRetryFailures;
+
+/**
+ * Returns a copy of the options with which the database was initialized.
+ */
+- (PLSqliteDatabaseOptions *) options {
+    return [[_options copy] autorelease];
+}
+
+/**
+ * Returns the busy wait metrics recorded by this connection.
+ *
+ * Each time a statement finds the database locked by another connection, the wait is recorded according to the
+ * connection's PLSqliteDatabaseOptions::busyPolicy. These metrics may be used to monitor lock latency, or to shed load
+ * when waits grow too long.
+ *
+ * @par Thread Safety
+ * The metrics are updated without locking by the thread executing a statement; if read concurrently from another
+ * thread, the values may be momentarily inconsistent.
+ */
+- (PLSqliteBusyMetrics) busyMetrics {
+    return _busyMetrics;
+}
+
+/**
+ * Reset all busy wait metrics to zero.
+ */
+- (void) resetBusyMetrics {
+    memset(&_busyMetrics, 0, sizeof(_busyMetrics));
+}
+
+/**
+ * Read back the tuning settings in effect on this connection.
+ *
+ * Every setting of the returned profile is populated with its current value, whether or not it was set by the
+ * connection's PLSqliteDatabaseOptions::tuningProfile. If the SQLite library does not support memory-mapped I/O,
+ * the mmap size is nil.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the settings could not be read. If no error occurs, this
+ * parameter will be left unmodified. You may specify NULL for this parameter, and no error information will be
+ * provided.
+ * @return The current settings, or nil on failure.
+ */
+- (PLSqliteTuningProfile *) tuningProfileAndReturnError: (NSError **) outError {
+    NSString *values[8];
+    NSString *names[8] = { @"journal_mode", @"synchronous", @"mmap_size", @"cache_size", @"temp_store", @"page_size",
+        @"wal_autocheckpoint", @"locking_mode" };
+
+    for (int i = 0; i < 8; i++) {
+        /* Unsupported pragmas return no value */
+        if (i == 2 && !pl_sqlite_supports_mmap()) {
+            values[i] = nil;
+            continue;
+        }
+
+        values[i] = [self executePragma: [NSString stringWithFormat: @"PRAGMA %@", names[i]] error: outError];
+        if (values[i] == nil)
+            return nil;
+    }
+
+    PLSqliteTuningProfile *profile = [PLSqliteTuningProfile profile];
+    profile.journalMode = PLSqliteJournalModeForName(values[0]);
+    profile.synchronousMode = (PLSqliteSynchronousMode) [values[1] intValue];
+    if (values[2] != nil)
+        profile.mmapSize = [NSNumber numberWithLongLong: [values[2] longLongValue]];
+    profile.cacheSize = [NSNumber numberWithLongLong: [values[3] longLongValue]];
+    profile.tempStore = (PLSqliteTempStore) [values[4] intValue];
+    profile.pageSize = [NSNumber numberWithLongLong: [values[5] longLongValue]];
+    profile.walAutocheckpoint = [NSNumber numberWithInt: [values[6] intValue]];
+    profile.lockingMode = PLSqliteLockingModeForName(values[7]);
+
+    return profile;
+}
+
 /**
  * Returns a borrowed reference to the underlying SQLite3 database handle.
  * If the database has not yet been opened, this method will return NULL.
@@ -254,6 +419,82 @@ NSString *PLSqliteException = @"PLSqliteException";
     return [self prepareStatement: statement error: outError closeAtCheckin: NO];
 }
 
+/**
+ * Return a statement handle for @a statement. The handle may be used to prepare the statement via
+ * prepareStatementWithHandle:, without the cost of looking up the query string in the prepared statement
+ * cache.
+ *
+ * The statement is not parsed until first prepared; any syntax error will be reported by prepareStatementWithHandle:error:.
+ *
+ * @param statement SQL statement.
+ * @return A statement handle that may only be used with the receiver.
+ */
+- (PLSqliteStatementHandle *) statementHandleForSQL: (NSString *) statement {
+    PLSqliteStatementCacheEntry *entry = [_statementCache cacheEntryForQueryString: statement];
+
+    return [[[PLSqliteStatementHandle alloc] initWithQueryString: statement statementCache: _statementCache cacheEntry: entry] autorelease];
+}
+
+/**
+ * Prepare and return a new PLPreparedStatement for the statement referenced by @a handle.
+ *
+ * @param handle A statement handle returned by statementHandleForSQL:.
+ * @return The prepared statement, or nil if it could not be prepared.
+ */
+- (id<PLPreparedStatement>) prepareStatementWithHandle: (PLSqliteStatementHandle *) handle {
+    return [self prepareStatementWithHandle: handle error: NULL];
+}
+
+/**
+ * Prepare and return a new PLPreparedStatement for the statement referenced by @a handle.
+ *
+ * @param handle A statement handle returned by statementHandleForSQL:. If the handle was not returned by
+ * the receiver, a PLSqliteException will be raised.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the statement could not be prepared.
+ * If no error occurs, this parameter will be left unmodified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ * @return The prepared statement, or nil if it could not be prepared.
+ */
+- (id<PLPreparedStatement>) prepareStatementWithHandle: (PLSqliteStatementHandle *) handle error: (NSError **) outError {
+    NSString *statement = [handle queryString];
+    sqlite3_stmt *sqlite_stmt = NULL;
+
+    /* The handle's cache entry is only valid for our statement cache */
+    if ([handle statementCache] != _statementCache)
+        [NSException raise: PLSqliteException format: @"Statement handle for query '%@' was not vended by this database", statement];
+
+    /* Try fetching from the cache. */
+    PLSqliteStatementCacheEntry *entry = [handle cacheEntry];
+    if (entry != nil) {
+        sqlite_stmt = [_statementCache checkoutStatementForCacheEntry: entry];
+
+        /* If the handle's entry has been evicted, fetch its replacement */
+        if (sqlite_stmt == NULL && [entry isEvicted]) {
+            sqlite_stmt = [_statementCache checkoutStatementForQueryString: statement cacheEntry: &entry];
+            [handle setCacheEntry: entry];
+            [entry release];
+        }
+    }
+
+    /* Prepare a new statement */
+    if (sqlite_stmt == NULL) {
+        sqlite_stmt = [self prepareAndRegisterStatement: statement error: outError];
+        if (sqlite_stmt == NULL)
+            return nil;
+    }
+
+    /* MEMORY OWNERSHIP WARNING:
+     * We pass our sqlite3_stmt reference to the PLSqlitePreparedStatement, which now must assume authority for releasing
+     * that statement using sqlite3_finalize(). */
+    return [[[PLSqlitePreparedStatement alloc] initWithDatabase: self
+                                                 statementCache: _statementCache
+                                            statementCacheEntry: entry
+                                                     sqliteStmt: sqlite_stmt
+                                                    queryString: statement
+                                                 closeAtCheckin: NO] autorelease];
+}
+
 /**
  * @internal
  * Utility method to convert an va_list of objects to an NSArray
@@ -381,20 +622,44 @@ NSString *PLSqliteException = @"PLSqliteException";
                                                 error: outError];
 }
 
-/* from PLDatabase. */
+/**
+ * Perform a transaction, as per PLDatabase::performTransactionWithIsolationLevel:retryBlock:error:.
+ *
+ * @par Nested Transactions
+ * If called from within another transaction block, the nested transaction is implemented with an SQLite save point,
+ * and is committed only when the outermost transaction commits; composed work thus incurs a single commit. A nested
+ * transaction inherits the isolation level of the outermost transaction, and is never retried on its own: if
+ * SQLITE_BUSY is encountered, the nested block's changes are rolled back, and the busy condition is propagated to the
+ * enclosing block, which may return PLDatabaseTransactionRollback to retry the transaction as a whole.
+ */
 - (BOOL) performTransactionWithIsolationLevel: (PLDatabaseIsolationLevel) isolationLevel
                                    retryBlock: (PLDatabaseTransactionResult (^)(void)) block
                                         error: (NSError **) outError
 {
-    /* */
-    NSAssert(_monitorTx == NO, @"Nested transactions are not currently supported");
+    /* Nested within a monitored transaction; use a save point */
+    if (_monitorTx)
+        return [self performNestedTransactionWithBlock: block error: outError];
+
     _monitorTx = YES;
+
+    /* Retry state, as per the configured retry policy */
+    PLSqliteRetryPolicy *retryPolicy = [_options retryPolicy];
+    double startTime = pl_sqlite_now();
+    NSUInteger retries = 0;
+    _lastTransactionRetryCount = 0;
     
     /* Execute the transaction loop, rolling back and retrying if a deadlock occurs (_txBusy == YES). */
     BOOL ret = YES;
     while (1) {        
-        /* Start the transaction */
+        /* Start the transaction. BEGIN IMMEDIATE and BEGIN EXCLUSIVE acquire their locks up front, and may fail with
+         * SQLITE_BUSY; as nothing has been done, the transaction may simply be retried. */
+        _txBusy = NO;
         if (![self beginTransactionWithIsolationLevel: isolationLevel error: outError]) {
+            if (_txBusy && sqlite3_get_autocommit(_sqlite) != 0) {
+                if ([self prepareTransactionRetry: ++retries policy: retryPolicy startTime: startTime error: outError])
+                    continue;
+            }
+
             ret = NO;
             break;
         }
@@ -434,9 +699,13 @@ NSString *PLSqliteException = @"PLSqliteException";
         /* We may no longer be in a transaction -- SQLite may automatically roll back a transaction. */
         if (sqlite3_get_autocommit(_sqlite) != 0) {
             /* If we need to retry and the transaction has already been rolled back, there's nothing left to do but
-             * retry the entire transaction immediately. */
+             * retry the entire transaction, subject to the retry policy. */
             if (retry) {
-                continue;
+                if ([self prepareTransactionRetry: ++retries policy: retryPolicy startTime: startTime error: outError])
+                    continue;
+
+                ret = NO;
+                break;
             }
             
             /* Otherwise, if the block has requested COMMIT, it has done so in error -- SQLite will only roll back
@@ -475,6 +744,12 @@ NSString *PLSqliteException = @"PLSqliteException";
         /* No retry was requested. Terminate immediately. */
         if (!retry)
             break;
+
+        /* Retry, subject to the retry policy */
+        if (![self prepareTransactionRetry: ++retries policy: retryPolicy startTime: startTime error: outError]) {
+            ret = NO;
+            break;
+        }
     };
     
     /* Disabling monitoring of SQLITE_BUSY and return */
@@ -483,6 +758,301 @@ NSString *PLSqliteException = @"PLSqliteException";
     return ret;
 }
 
+/**
+ * @internal
+ *
+ * Execute @a block within a save point of the current monitored transaction, releasing the save point if the block
+ * returns PLDatabaseTransactionCommit, and rolling back to it otherwise.
+ *
+ * If the block is rolled back due to SQLITE_BUSY, NO is returned, so that the enclosing block may roll back in
+ * turn; the outermost transaction is then retried.
+ *
+ * @param block The transaction block.
+ * @param outError If an error occurs, upon return contains an error object in the PLDatabaseErrorDomain that
+ * describes the problem. Pass NULL if you do not want error information.
+ * @return YES if the save point is successfully released, or rolled back at the block's request, or NO on failure.
+ */
+- (BOOL) performNestedTransactionWithBlock: (PLDatabaseTransactionResult (^)(void)) block error: (NSError **) outError {
+    /* Save point names need only be unique within the stack; the depth suffices */
+    _savepointDepth++;
+    NSString *savepoint = [NSString stringWithFormat: @"pl_savepoint_%lu", (unsigned long) _savepointDepth];
+
+    BOOL ret;
+    @try {
+        ret = [self executeUpdateAndReturnError: outError statement: [@"SAVEPOINT " stringByAppendingString: savepoint]];
+        if (!ret)
+            return NO;
+
+        _txBusy = NO;
+        PLDatabaseTransactionResult txResult = block();
+        BOOL busy = _txBusy;
+
+        if (sqlite3_get_autocommit(_sqlite) != 0 && txResult != PLDatabaseTransactionCommit) {
+            /* SQLite rolled back the entire transaction, and the save point along with it; as with the outermost
+             * transaction, there's nothing left to roll back. A requested COMMIT is attempted below, and reports
+             * the error. */
+        } else if (txResult == PLDatabaseTransactionCommit) {
+            /* Merge the save point's changes into the enclosing transaction */
+            ret = [self executeUpdateAndReturnError: outError statement: [@"RELEASE SAVEPOINT " stringByAppendingString: savepoint]];
+        } else {
+            /* ROLLBACK TO leaves the save point on the stack; it must also be released */
+            ret = [self executeUpdateAndReturnError: outError statement: [@"ROLLBACK TO SAVEPOINT " stringByAppendingString: savepoint]];
+            if (ret)
+                ret = [self executeUpdateAndReturnError: outError statement: [@"RELEASE SAVEPOINT " stringByAppendingString: savepoint]];
+        }
+
+        /* The enclosing transaction is responsible for any retry; preserve the block's busy state across the save
+         * point statements, and inform the enclosing block that the nested work was discarded. */
+        if (busy && txResult == PLDatabaseTransactionRollback) {
+            _txBusy = YES;
+
+            if (ret && outError != NULL) {
+                *outError = [PlausibleDatabase errorWithCode: PLDatabaseErrorQueryFailed
+                                        localizedDescription: NSLocalizedString(@"The nested transaction was rolled back because the database is locked.", @"")
+                                                 queryString: nil
+                                                 vendorError: [NSNumber numberWithInt: SQLITE_BUSY]
+                                           vendorErrorString: @"database is locked"];
+            }
+            ret = NO;
+        }
+    } @finally {
+        _savepointDepth--;
+    }
+
+    return ret;
+}
+
+/**
+ * @internal
+ *
+ * Execute a pragma statement directly, bypassing the statement cache.
+ *
+ * @param pragma The pragma statement.
+ * @param outError If an error occurs, upon return contains an error object in the PLDatabaseErrorDomain
+ * that describes the problem. Pass NULL if you do not want error information.
+ * @return The first column of the first result row, an empty string if there is no result, or nil on failure.
+ */
+- (NSString *) executePragma: (NSString *) pragma error: (NSError **) outError {
+    sqlite3_stmt *stmt = NULL;
+    NSString *result = @"";
+    int err;
+
+    err = sqlite3_prepare_v2(_sqlite, [pragma UTF8String], -1, &stmt, NULL);
+    if (err == SQLITE_OK) {
+        err = sqlite3_step(stmt);
+        if (err == SQLITE_ROW) {
+            const unsigned char *text = sqlite3_column_text(stmt, 0);
+            if (text != NULL)
+                result = [NSString stringWithUTF8String: (const char *) text];
+            err = SQLITE_OK;
+        } else if (err == SQLITE_DONE) {
+            err = SQLITE_OK;
+        }
+    }
+
+    if (err != SQLITE_OK) {
+        [self populateError: outError
+              withErrorCode: PLDatabaseErrorQueryFailed
+                description: NSLocalizedString(@"The SQLite database pragma could not be executed.", @"")
+                queryString: pragma];
+        result = nil;
+    }
+
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+/**
+ * @internal
+ *
+ * Set a pragma, and optionally read it back to verify that SQLite honored the new value.
+ *
+ * @param name The pragma name.
+ * @param value The new value, as returned by SQLite when the pragma is read.
+ * @param verify If YES, the pragma will be read back and compared with @a value.
+ * @param outError If an error occurs, upon return contains an error object in the PLDatabaseErrorDomain
+ * that describes the problem. Pass NULL if you do not want error information.
+ * @return YES on success, NO on failure.
+ */
+- (BOOL) setPragma: (NSString *) name value: (NSString *) value verify: (BOOL) verify error: (NSError **) outError {
+    NSString *pragma = [NSString stringWithFormat: @"PRAGMA %@ = %@", name, value];
+    if ([self executePragma: pragma error: outError] == nil)
+        return NO;
+
+    if (!verify)
+        return YES;
+
+    NSString *current = [self executePragma: [NSString stringWithFormat: @"PRAGMA %@", name] error: outError];
+    if (current == nil)
+        return NO;
+
+    if ([current caseInsensitiveCompare: value] != NSOrderedSame) {
+        NSString *desc = [NSString stringWithFormat: NSLocalizedString(@"The SQLite database did not accept the setting '%@ = %@' (the current value is '%@').", @""),
+                          name, value, current];
+        [self populateError: outError withErrorCode: PLDatabaseErrorQueryFailed description: desc queryString: pragma];
+        return NO;
+    }
+
+    return YES;
+}
+
+/**
+ * @internal
+ *
+ * Apply the settings of @a profile to the connection, verifying each setting that SQLite reports back
+ * exactly.
+ *
+ * The settings local to the connection are applied first. The page size and journal mode are written to the database
+ * file, and are applied last: the page size is only recorded on the first write to a new database, and the journal
+ * mode is applied after every other setting has been verified, so that a failure leaves the database file unchanged.
+ * The page size must also be set before the journal mode, as it can not be changed once the database is in WAL mode,
+ * and the locking mode is applied before the journal mode, so that an exclusive WAL database does not require shared
+ * memory.
+ *
+ * @param profile The profile to apply.
+ * @param outError If an error occurs, upon return contains an error object in the PLDatabaseErrorDomain
+ * that describes the problem. Pass NULL if you do not want error information.
+ * @return YES on success, NO on failure.
+ */
+- (BOOL) applyTuningProfile: (PLSqliteTuningProfile *) profile error: (NSError **) outError {
+    if ([profile lockingMode] != PLSqliteLockingModeDefault &&
+        ![self setPragma: @"locking_mode" value: PLSqliteLockingModeName([profile lockingMode]) verify: YES error: outError])
+        return NO;
+
+    if ([profile synchronousMode] != PLSqliteSynchronousModeDefault &&
+        ![self setPragma: @"synchronous" value: [NSString stringWithFormat: @"%d", (int) [profile synchronousMode]] verify: YES error: outError])
+        return NO;
+
+    if ([profile walAutocheckpoint] != nil && ![self setPragma: @"wal_autocheckpoint" value: [[profile walAutocheckpoint] stringValue] verify: YES error: outError])
+        return NO;
+
+    if ([profile cacheSize] != nil && ![self setPragma: @"cache_size" value: [[profile cacheSize] stringValue] verify: YES error: outError])
+        return NO;
+
+    /* SQLite silently clamps the mmap size to its compile-time maximum, so it is not verified. Versions without
+     * memory-mapped I/O would silently ignore the pragma, and it is skipped. */
+    if ([profile mmapSize] != nil && pl_sqlite_supports_mmap() &&
+        ![self setPragma: @"mmap_size" value: [[profile mmapSize] stringValue] verify: NO error: outError])
+        return NO;
+
+    if ([profile tempStore] != PLSqliteTempStoreDefault &&
+        ![self setPragma: @"temp_store" value: [NSString stringWithFormat: @"%d", (int) [profile tempStore]] verify: YES error: outError])
+        return NO;
+
+    /* Page size only applies to new databases, and is not verified */
+    if ([profile pageSize] != nil && ![self setPragma: @"page_size" value: [[profile pageSize] stringValue] verify: NO error: outError])
+        return NO;
+
+    if ([profile journalMode] != PLSqliteJournalModeDefault &&
+        ![self setPragma: @"journal_mode" value: PLSqliteJournalModeName([profile journalMode]) verify: YES error: outError])
+        return NO;
+
+    return YES;
+}
+
+/**
+ * @internal
+ *
+ * Called by SQLite when a statement finds the database locked. Sleeps according to the busy policy, and
+ * records the wait in the busy metrics.
+ *
+ * @param count The number of times the handler has already been called for this lock.
+ * @return Non-zero if SQLite should retry the lock, or 0 if the statement should fail with SQLITE_BUSY.
+ */
+- (int) waitOnBusyLock: (int) count {
+    PLSqliteBusyPolicy *policy = [_options busyPolicy];
+    PLSqliteBusyWaitBlock waitBlock = [policy waitBlock];
+    NSTimeInterval timeout = [policy timeout];
+    double now = pl_sqlite_now();
+
+    /* A new lock */
+    if (count == 0)
+        _busyWaitStart = now;
+
+    /* Give up at the deadline, or if the wait block asks us to */
+    NSTimeInterval waited = now - _busyWaitStart;
+    if (waited >= timeout || (waitBlock != nil && !waitBlock(self, (NSUInteger) count, waited))) {
+        _busyMetrics.timeoutCount++;
+        return 0;
+    }
+
+    /* Sleep, without passing the deadline */
+    NSTimeInterval interval = [policy sleepIntervalForAttempt: (NSUInteger) count];
+    if (interval > timeout - waited)
+        interval = timeout - waited;
+
+    /* Only locks on which we actually sleep are counted as waits */
+    if (count == 0)
+        _busyMetrics.waitCount++;
+
+    struct timespec ts;
+    ts.tv_sec = (time_t) interval;
+    ts.tv_nsec = (long) ((interval - (double) ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+
+    /* Record the wait */
+    double end = pl_sqlite_now();
+    _busyMetrics.totalWaitTime += end - now;
+    if (end - _busyWaitStart > _busyMetrics.maxWaitTime)
+        _busyMetrics.maxWaitTime = end - _busyWaitStart;
+
+    return 1;
+}
+
+/**
+ * @internal
+ *
+ * Determine whether a transaction may be retried under @a policy, and if so, wait for the policy's backoff delay
+ * and record the retry.
+ *
+ * @param retry The retry number, starting at 1 for the first retry.
+ * @param policy The retry policy.
+ * @param startTime The time at which the transaction's first attempt began, as returned by pl_sqlite_now().
+ * @param outError If the retry policy has been exhausted, upon return contains an error object in the
+ * PLDatabaseErrorDomain that describes the problem. Pass NULL if you do not want error information.
+ * @return YES if the transaction should be retried, NO if the retry policy has been exhausted.
+ */
+- (BOOL) prepareTransactionRetry: (NSUInteger) retry policy: (PLSqliteRetryPolicy *) policy startTime: (double) startTime error: (NSError **) outError {
+    NSTimeInterval delay = [policy backoffForRetry: retry];
+    NSUInteger maxAttempts = [policy maxAttempts];
+    NSTimeInterval timeBudget = [policy timeBudget];
+
+    /* Attempts are counted including the first; retry N is attempt N + 1 */
+    BOOL exhausted = (maxAttempts > 0 && retry >= maxAttempts);
+    if (!exhausted && timeBudget > 0 && (pl_sqlite_now() - startTime) + delay > timeBudget)
+        exhausted = YES;
+
+    if (exhausted) {
+        _totalTransactionRetryFailures++;
+
+        PLSqliteErrorReport report;
+        report.errorCode = PLDatabaseErrorTimedOut;
+        report.localizedDescription = [NSString stringWithFormat: NSLocalizedString(@"The transaction could not acquire the database lock after %lu attempts.", @""),
+                                       (unsigned long) retry];
+        report.queryString = nil;
+        report.vendorErrorCode = SQLITE_BUSY;
+        report.vendorErrorMessage = "database is locked";
+
+        [[_options errorSink] database: self reportError: &report];
+        if (outError != NULL)
+            *outError = PLSqliteErrorFromReport(&report);
+
+        return NO;
+    }
+
+    if (delay > 0) {
+        struct timespec ts;
+        ts.tv_sec = (time_t) delay;
+        ts.tv_nsec = (long) ((delay - (double) ts.tv_sec) * 1e9);
+        nanosleep(&ts, NULL);
+    }
+
+    _lastTransactionRetryCount = retry;
+    _totalTransactionRetryCount++;
+
+    return YES;
+}
+
 /* from PLDatabase. */
 - (BOOL) beginTransaction {
     return [self beginTransactionAndReturnError: NULL];
@@ -507,6 +1077,11 @@ NSString *PLSqliteException = @"PLSqliteException";
         case PLDatabaseIsolationLevelSerializable:
             txStmt = @"BEGIN EXCLUSIVE";
             break;
+
+        case PLDatabaseIsolationLevelImmediate:
+            /* Acquire the write lock up front, rather than upgrading a read lock at the first write */
+            txStmt = @"BEGIN IMMEDIATE";
+            break;
     }
 
     return [self executeUpdateAndReturnError: outError statement: txStmt];
@@ -620,9 +1195,10 @@ NSString *PLSqliteException = @"PLSqliteException";
 /**
  * @internal
  *
- * Populate an NSError (if not nil) and log it, filling in the last database error code and message.
+ * Report an error to the configured error sink, and populate an NSError (if not nil), filling in the last database
+ * error code and message. The NSError is only constructed if requested.
  *
- * @param error Pointer to NSError instance to populate. If nil, the error message will be logged instead.
+ * @param error Pointer to NSError instance to populate. If nil, the error will only be reported to the error sink.
  * @param errorCode A PLDatabaseError error code.
  * @param description A localized description of the error message.
  * @param queryString The optional SQL query which caused the error.
@@ -630,26 +1206,18 @@ NSString *PLSqliteException = @"PLSqliteException";
 - (void) populateError: (NSError **) error withErrorCode: (PLDatabaseError) errorCode
            description: (NSString *) localizedDescription queryString: (NSString *) queryString
 {
-    NSString *vendorString = [self lastErrorMessage];
-    NSNumber *vendorError = [NSNumber numberWithInt: [self lastErrorCode]];
-    NSError *result;
-    
-    /* Create the error */
-    result = [PlausibleDatabase errorWithCode: errorCode
-                         localizedDescription: localizedDescription
-                                  queryString: queryString
-                                  vendorError: vendorError
-                            vendorErrorString: vendorString];    
+    PLSqliteErrorReport report;
+    report.errorCode = errorCode;
+    report.localizedDescription = localizedDescription;
+    report.queryString = queryString;
+    report.vendorErrorCode = sqlite3_errcode(_sqlite);
+    report.vendorErrorMessage = sqlite3_errmsg(_sqlite);
+
+    /* Report it and optionally return it */
+    [[_options errorSink] database: self reportError: &report];
 
-    if (queryString == nil)
-        queryString = @"<none>";
-    
-    /* Log it and optionally return it */
-    NSLog(@"A SQLite database error occurred on database '%@': %@ (SQLite #%@: %@) (query: '%@')", 
-          _path, result, vendorError, vendorString, queryString);
-    
     if (error != NULL)
-        *error = result;
+        *error = PLSqliteErrorFromReport(&report);
 }
 
 /**
@@ -670,46 +1238,44 @@ NSString *PLSqliteException = @"PLSqliteException";
  * You may specify nil for this parameter, and no error information will be provided.
  */
 - (sqlite3_stmt *) createStatement: (NSString *) statement error: (NSError **) error {
+    return [self createStatement: statement cacheEntry: NULL error: error];
+}
+
+/**
+ * @internal
+ *
+ * Create an SQLite statement, returning NULL on error.
+ *
+ * @warning MEMORY OWNERSHIP WARNING: The returned statement is owned by the caller, and MUST be free'd using sqlite3_finalize()
+ * or checked in to the statement cache via PLSqliteStatementCache::checkinStatement:forCacheEntry:.
+ *
+ * @param statement SQLite statement string
+ * @param cacheEntry If non-NULL, will be set to the statement cache entry for @a statement, or nil if statement caching
+ * is disabled. The caller is responsible for releasing the returned entry. If an error occurs, this parameter will be left
+ * unmodified.
+ * @param error A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the statement could
+ * not be created. If no error occurs, this parameter will be left unmodified.
+ * You may specify nil for this parameter, and no error information will be provided.
+ */
+- (sqlite3_stmt *) createStatement: (NSString *) statement cacheEntry: (PLSqliteStatementCacheEntry **) cacheEntry error: (NSError **) error {
+    PLSqliteStatementCacheEntry *entry = nil;
     sqlite3_stmt *sqlite_stmt;
-    const char *unused;
-    int ret;
     
     /* Try fetching from the cache. */
-    sqlite_stmt = [_statementCache checkoutStatementForQueryString: statement];
-    if (sqlite_stmt != NULL)
-        return sqlite_stmt;
-
-    /* Prepare. */
-    ret = pl_sqlite3_blocking_prepare_v2(_sqlite, [statement UTF8String], -1, &sqlite_stmt, &unused);
-    
-    /* Prepare failed */
-    if (ret != SQLITE_OK) {
-        /* Report deadlock status */
-        if (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
-            [self setTxBusy];
-        } else {
-            [self resetTxBusy];
+    sqlite_stmt = [_statementCache checkoutStatementForQueryString: statement cacheEntry: cacheEntry != NULL ? &entry : NULL];
+
+    /* Otherwise, prepare a new statement */
+    if (sqlite_stmt == NULL) {
+        sqlite_stmt = [self prepareAndRegisterStatement: statement error: error];
+        if (sqlite_stmt == NULL) {
+            [entry release];
+            return NULL;
         }
-
-        [self populateError: error
-              withErrorCode: PLDatabaseErrorInvalidStatement
-                description: NSLocalizedString(@"An error occured parsing the provided SQL statement.", @"")
-                queryString: statement];
-        return NULL;
     }
-    
-    /* Multiple statements were provided */
-    if (*unused != '\0') {
-        sqlite3_finalize(sqlite_stmt);
-        [self populateError: error
-              withErrorCode: PLDatabaseErrorInvalidStatement
-                description: NSLocalizedString(@"Multiple SQL statements were provided for a single query.", @"")
-                queryString: statement];
-        return NULL;
-    }
-    
-    /* Register the statement */
-    [_statementCache registerStatement: sqlite_stmt];
+
+    if (cacheEntry != NULL)
+        *cacheEntry = entry;
 
     return sqlite_stmt;
 }
@@ -736,10 +1302,11 @@ NSString *PLSqliteException = @"PLSqliteException";
  * is not available and can not otherwise be explicitly closed.
  */
 - (id<PLPreparedStatement>) prepareStatement: (NSString *) statement error: (NSError **) outError closeAtCheckin: (BOOL) closeAtCheckin {
+    PLSqliteStatementCacheEntry *cacheEntry;
     sqlite3_stmt *sqlite_stmt;
     
     /* Prepare our statement */
-    sqlite_stmt = [self createStatement: statement error: outError];
+    sqlite_stmt = [self createStatement: statement cacheEntry: &cacheEntry error: outError];
     if (sqlite_stmt == NULL)
         return nil;
     
@@ -748,11 +1315,70 @@ NSString *PLSqliteException = @"PLSqliteException";
      * MEMORY OWNERSHIP WARNING:
      * We pass our sqlite3_stmt reference to the PLSqlitePreparedStatement, which now must assume authority for releasing
      * that statement using sqlite3_finalize(). */
-    return [[[PLSqlitePreparedStatement alloc] initWithDatabase: self
-                                                 statementCache: _statementCache
-                                                     sqliteStmt: sqlite_stmt
-                                                    queryString: statement 
-                                                 closeAtCheckin: closeAtCheckin] autorelease];
+    PLSqlitePreparedStatement *stmt = [[PLSqlitePreparedStatement alloc] initWithDatabase: self
+                                                                           statementCache: _statementCache
+                                                                      statementCacheEntry: cacheEntry
+                                                                               sqliteStmt: sqlite_stmt
+                                                                              queryString: statement 
+                                                                           closeAtCheckin: closeAtCheckin];
+    [cacheEntry release];
+
+    return [stmt autorelease];
+}
+
+/**
+ * @internal
+ *
+ * Prepare and register a new SQLite statement with the statement cache, returning NULL on error. The statement
+ * cache is not consulted.
+ *
+ * @warning MEMORY OWNERSHIP WARNING: The returned statement is owned by the caller, and MUST be free'd using sqlite3_finalize()
+ * or checked in to the statement cache.
+ *
+ * @param statement SQLite statement string
+ * @param error A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the statement could
+ * not be created. If no error occurs, this parameter will be left unmodified.
+ * You may specify nil for this parameter, and no error information will be provided.
+ */
+- (sqlite3_stmt *) prepareAndRegisterStatement: (NSString *) statement error: (NSError **) error {
+    sqlite3_stmt *sqlite_stmt;
+    const char *unused;
+    int ret;
+
+    /* Prepare. */
+    ret = pl_sqlite3_blocking_prepare_v2(_sqlite, [statement UTF8String], -1, &sqlite_stmt, &unused);
+    
+    /* Prepare failed */
+    if (ret != SQLITE_OK) {
+        /* Report deadlock status */
+        if (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+            [self setTxBusy];
+        } else {
+            [self resetTxBusy];
+        }
+
+        [self populateError: error
+              withErrorCode: PLDatabaseErrorInvalidStatement
+                description: NSLocalizedString(@"An error occured parsing the provided SQL statement.", @"")
+                queryString: statement];
+        return NULL;
+    }
+    
+    /* Multiple statements were provided */
+    if (*unused != '\0') {
+        sqlite3_finalize(sqlite_stmt);
+        [self populateError: error
+              withErrorCode: PLDatabaseErrorInvalidStatement
+                description: NSLocalizedString(@"Multiple SQL statements were provided for a single query.", @"")
+                queryString: statement];
+        return NULL;
+    }
+    
+    /* Register the statement */
+    [_statementCache registerStatement: sqlite_stmt];
+
+    return sqlite_stmt;
 }
 
 @end
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "PLSqliteBusyPolicy.h"
+#import "PLSqliteErrorSink.h"
+#import "PLSqliteRetryPolicy.h"
+#import "PLSqliteTuningProfile.h"
+
+/**
+ * Prepared statement cache eviction policies.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** When the cache exceeds its capacity, the statements belonging to the least recently used queries are
+     * finalized. */
+    PLSqliteStatementCacheEvictionPolicyLRU = 0,
+
+    /** When the cache exceeds its capacity, all cached statements are finalized. */
+    PLSqliteStatementCacheEvictionPolicyFlush = 1
+} PLSqliteStatementCacheEvictionPolicy;
+
+@interface PLSqliteDatabaseOptions : NSObject <NSCopying> {
+@private
+    /** If NO, prepared statements are finalized when closed rather than cached. */
+    BOOL _statementCacheEnabled;
+
+    /** Maximum number of cached prepared statements. */
+    NSUInteger _statementCacheCapacity;
+
+    /** Cache eviction policy. */
+    PLSqliteStatementCacheEvictionPolicy _statementCacheEvictionPolicy;
+
+    /** Maximum number of cached statements per query string, or 0 if unlimited. */
+    NSUInteger _maxCachedStatementsPerQuery;
+
+    /** Error sink, or nil. */
+    id<PLSqliteErrorSink> _errorSink;
+
+    /** Transaction retry policy. */
+    PLSqliteRetryPolicy *_retryPolicy;
+
+    /** Busy wait policy. */
+    PLSqliteBusyPolicy *_busyPolicy;
+
+    /** Tuning profile, or nil. */
+    PLSqliteTuningProfile *_tuningProfile;
+}
+
++ (id) defaultOptions;
+
+/** If NO, prepared statements will be finalized when closed, rather than cached for re-use. Defaults to YES. */
+@property(nonatomic, assign, getter=isStatementCacheEnabled) BOOL statementCacheEnabled;
+
+/** The maximum number of idle prepared statements that will be cached. Defaults to 100. */
+@property(nonatomic, assign) NSUInteger statementCacheCapacity;
+
+/** The policy used to evict statements when the statement cache exceeds its capacity. Defaults to
+ * PLSqliteStatementCacheEvictionPolicyLRU. */
+@property(nonatomic, assign) PLSqliteStatementCacheEvictionPolicy statementCacheEvictionPolicy;
+
+/** The maximum number of idle statements that will be cached for any single query string, or 0 if only
+ * the total cache capacity should apply. Defaults to 0. */
+@property(nonatomic, assign) NSUInteger maxCachedStatementsPerQuery;
+
+/** The sink to which all database errors are reported, or nil to disable error reporting. Defaults to
+ * the rate-limited PLSqliteLogErrorSink::defaultSink. */
+@property(nonatomic, retain) id<PLSqliteErrorSink> errorSink;
+
+/** The policy used to retry transactions that fail due to lock contention. The policy will be copied. Defaults
+ * to PLSqliteRetryPolicy::defaultPolicy, which retries immediately and without limit. */
+@property(nonatomic, copy) PLSqliteRetryPolicy *retryPolicy;
+
+/** The policy used to wait on a database that is locked by another connection. The policy will be copied. Defaults
+ * to PLSqliteBusyPolicy::defaultPolicy, which waits for up to 10 minutes. */
+@property(nonatomic, copy) PLSqliteBusyPolicy *busyPolicy;
+
+/** The tuning profile applied when the database is opened, or nil to leave SQLite's defaults in place. The profile
+ * will be copied. Defaults to nil. */
+@property(nonatomic, copy) PLSqliteTuningProfile *tuningProfile;
+
+@end
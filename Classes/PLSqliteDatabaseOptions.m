@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteDatabaseOptions.h"
+
+/** Default prepared statement cache capacity. */
+#define PL_SQLITE_DEFAULT_STATEMENT_CACHE_CAPACITY 100
+
+/**
+ * Configuration options for a PLSqliteDatabase connection.
+ *
+ * Options are copied by PLSqliteDatabase and PLSqliteConnectionProvider at initialization; later modification of an
+ * options instance will not affect connections that have already been initialized.
+ *
+ * @par Thread Safety
+ * PLSqliteDatabaseOptions instances implement no locking and must not be mutated while shared between threads.
+ */
+@implementation PLSqliteDatabaseOptions
+
+@synthesize statementCacheEnabled = _statementCacheEnabled;
+@synthesize statementCacheCapacity = _statementCacheCapacity;
+@synthesize statementCacheEvictionPolicy = _statementCacheEvictionPolicy;
+@synthesize maxCachedStatementsPerQuery = _maxCachedStatementsPerQuery;
+@synthesize errorSink = _errorSink;
+@synthesize retryPolicy = _retryPolicy;
+@synthesize busyPolicy = _busyPolicy;
+@synthesize tuningProfile = _tuningProfile;
+
+/**
+ * Return a new options instance populated with the default values.
+ */
++ (id) defaultOptions {
+    return [[[self alloc] init] autorelease];
+}
+
+/**
+ * Initialize a new options instance with the default values.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteDatabaseOptions class.
+ */
+- (id) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _statementCacheEnabled = YES;
+    _statementCacheCapacity = PL_SQLITE_DEFAULT_STATEMENT_CACHE_CAPACITY;
+    _statementCacheEvictionPolicy = PLSqliteStatementCacheEvictionPolicyLRU;
+    _maxCachedStatementsPerQuery = 0;
+    _errorSink = [[PLSqliteLogErrorSink defaultSink] retain];
+    _retryPolicy = [[PLSqliteRetryPolicy alloc] init];
+    _busyPolicy = [[PLSqliteBusyPolicy alloc] init];
+
+    return self;
+}
+
+- (void) dealloc {
+    [_errorSink release];
+    [_retryPolicy release];
+    [_busyPolicy release];
+    [_tuningProfile release];
+
+    [super dealloc];
+}
+
+// from NSCopying protocol
+- (id) copyWithZone: (NSZone *) zone {
+    PLSqliteDatabaseOptions *copy = [[[self class] allocWithZone: zone] init];
+
+    copy->_statementCacheEnabled = _statementCacheEnabled;
+    copy->_statementCacheCapacity = _statementCacheCapacity;
+    copy->_statementCacheEvictionPolicy = _statementCacheEvictionPolicy;
+    copy->_maxCachedStatementsPerQuery = _maxCachedStatementsPerQuery;
+    copy.errorSink = _errorSink;
+    copy.retryPolicy = _retryPolicy;
+    copy.busyPolicy = _busyPolicy;
+    copy.tuningProfile = _tuningProfile;
+
+    return copy;
+}
+
+@end
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PLSqliteDatabase.h"
+#import "PLSqliteDatabaseOptions.h"
+
+@interface PLSqliteDatabaseOptionsTests : SenTestCase {
+@private
+}
+
+@end
+
+@implementation PLSqliteDatabaseOptionsTests
+
+- (void) testDefaults {
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+
+    STAssertTrue([options isStatementCacheEnabled], @"Statement cache should be enabled by default");
+    STAssertEquals((NSUInteger) 100, [options statementCacheCapacity], @"Incorrect default capacity");
+    STAssertEquals(PLSqliteStatementCacheEvictionPolicyLRU, [options statementCacheEvictionPolicy], @"Incorrect default policy");
+    STAssertEquals((NSUInteger) 0, [options maxCachedStatementsPerQuery], @"Incorrect default per-query limit");
+    STAssertEquals((id) [PLSqliteLogErrorSink defaultSink], (id) [options errorSink], @"Incorrect default error sink");
+}
+
+- (void) testCopy {
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.statementCacheEnabled = NO;
+    options.statementCacheCapacity = 5;
+    options.statementCacheEvictionPolicy = PLSqliteStatementCacheEvictionPolicyFlush;
+    options.maxCachedStatementsPerQuery = 2;
+    options.errorSink = nil;
+
+    PLSqliteDatabaseOptions *copy = [[options copy] autorelease];
+    STAssertFalse([copy isStatementCacheEnabled], @"Cache enabled flag not copied");
+    STAssertEquals((NSUInteger) 5, [copy statementCacheCapacity], @"Capacity not copied");
+    STAssertEquals(PLSqliteStatementCacheEvictionPolicyFlush, [copy statementCacheEvictionPolicy], @"Policy not copied");
+    STAssertEquals((NSUInteger) 2, [copy maxCachedStatementsPerQuery], @"Per-query limit not copied");
+    STAssertNil([copy errorSink], @"Error sink not copied");
+}
+
+/**
+ * Verify that the database copies its options, and that statements are usable with caching disabled.
+ */
+- (void) testDatabaseOptions {
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.statementCacheEnabled = NO;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+    options.statementCacheEnabled = YES;
+    STAssertFalse([[db options] isStatementCacheEnabled], @"Database options were not copied");
+
+    STAssertTrue([db open], @"Could not open the database");
+    for (int i = 0; i < 3; i++) {
+        id<PLResultSet> rs = [db executeQuery: @"SELECT 1"];
+        STAssertTrue([rs next], @"Could not iterate the result set");
+        STAssertEquals(1, [rs intForColumnIndex: 0], @"Incorrect result");
+        [rs close];
+    }
+
+    /* Verify that the database closes cleanly. */
+    [db close];
+}
+
+@end
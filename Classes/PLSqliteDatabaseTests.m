@@ -107,6 +107,59 @@
 }
 
 
+- (void) testPrepareStatementWithHandle {
+    NSError *error;
+
+    /* Create a test table */
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a INTEGER)"], @"Create table failed");
+
+    /* Insert rows via a handle, re-preparing the statement each time */
+    PLSqliteStatementHandle *handle = [_db statementHandleForSQL: @"INSERT INTO test (a) VALUES (?)"];
+    STAssertNotNil(handle, @"Could not create statement handle");
+    STAssertEqualObjects(@"INSERT INTO test (a) VALUES (?)", [handle queryString], @"Incorrect query string");
+
+    for (int i = 0; i < 3; i++) {
+        id<PLPreparedStatement> stmt = [_db prepareStatementWithHandle: handle error: &error];
+        STAssertNotNil(stmt, @"Could not prepare statement: %@", error);
+
+        [stmt bindParameters: [NSArray arrayWithObject: [NSNumber numberWithInt: i]]];
+        STAssertTrue([stmt executeUpdateAndReturnError: &error], @"INSERT failed: %@", error);
+        [stmt close];
+    }
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM test"];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"No rows returned");
+    STAssertEquals(3, [rs intForColumnIndex: 0], @"Incorrect row count");
+    [rs close];
+
+    /* Closing the database evicts all cache entries; verify that the handle remains usable once re-opened */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db open], @"Couldn't open the test database");
+    handle = [db statementHandleForSQL: @"SELECT 42"];
+    [[db prepareStatementWithHandle: handle error: NULL] close];
+
+    [db close];
+    STAssertTrue([db open], @"Couldn't re-open the test database");
+
+    id<PLPreparedStatement> stmt = [db prepareStatementWithHandle: handle error: &error];
+    STAssertNotNil(stmt, @"Could not prepare statement with evicted handle: %@", error);
+    rs = [stmt executeQuery];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"No rows returned");
+    STAssertEquals(42, [rs intForColumnIndex: 0], @"Incorrect result");
+    [rs close];
+    [stmt close];
+
+    /* Syntax errors are reported at preparation */
+    handle = [_db statementHandleForSQL: @"Not a statement"];
+    STAssertNil([_db prepareStatementWithHandle: handle error: &error], @"Invalid statement was prepared");
+    STAssertEquals(PLDatabaseErrorInvalidStatement, (PLDatabaseError) [error code], @"Incorrect error code");
+
+    /* Handles may not be shared between databases */
+    STAssertThrows([db prepareStatementWithHandle: handle error: NULL], @"Foreign statement handle was accepted");
+    [db close];
+}
+
+
 - (void) testExecuteUpdate {
     STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a VARCHAR(10), b VARCHAR(20), c BOOL)"], @"Create table failed");
     STAssertTrue([_db tableExists: @"test"], @"Table 'test' not created");
@@ -336,6 +389,145 @@
     STAssertEquals(1, runCount, @"Transaction block was not run once");
 }
 
+/* Nested transactions must be committed or rolled back independently, and applied only by the outermost commit */
+- (void) testNestedBlockTransactions {
+    NSError *error;
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a int)"], @"Could not create test table");
+
+    BOOL ret = [_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+        STAssertTrue([_db executeUpdate: @"INSERT INTO test (a) VALUES (1)"], @"Insert failed");
+
+        /* Committed into the outer transaction, including its own nested transaction */
+        STAssertTrue([_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+            STAssertTrue([_db executeUpdate: @"INSERT INTO test (a) VALUES (2)"], @"Insert failed");
+
+            STAssertTrue([_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+                STAssertTrue([_db executeUpdate: @"INSERT INTO test (a) VALUES (3)"], @"Insert failed");
+                return PLDatabaseTransactionCommit;
+            } error: NULL], @"Nested transaction failed");
+
+            return PLDatabaseTransactionCommit;
+        } error: NULL], @"Nested transaction failed");
+
+        /* Rolled back, without affecting the outer transaction */
+        STAssertTrue([_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+            STAssertTrue([_db executeUpdate: @"INSERT INTO test (a) VALUES (4)"], @"Insert failed");
+            return PLDatabaseTransactionRollbackDisableRetry;
+        } error: NULL], @"Nested transaction failed");
+
+        /* Nothing has been committed yet */
+        STAssertFalse(sqlite3_get_autocommit([_db sqliteHandle]) != 0, @"Nested transaction committed the outer transaction");
+
+        return PLDatabaseTransactionCommit;
+    } error: &error];
+    STAssertTrue(ret, @"Transaction failed: %@", error);
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT SUM(a), COUNT(*) FROM test"];
+    STAssertTrue([rs next], @"No result returned");
+    STAssertEquals(6, [rs intForColumnIndex: 0], @"Incorrect rows committed");
+    STAssertEquals(3, [rs intForColumnIndex: 1], @"Incorrect rows committed");
+    [rs close];
+
+    /* Rolling back the outer transaction discards committed nested transactions */
+    ret = [_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+        [_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+            [_db executeUpdate: @"INSERT INTO test (a) VALUES (5)"];
+            return PLDatabaseTransactionCommit;
+        } error: NULL];
+        return PLDatabaseTransactionRollbackDisableRetry;
+    } error: &error];
+    STAssertTrue(ret, @"Transaction failed: %@", error);
+
+    rs = [_db executeQuery: @"SELECT COUNT(*) FROM test"];
+    STAssertTrue([rs next], @"No result returned");
+    STAssertEquals(3, [rs intForColumnIndex: 0], @"Nested transaction survived an outer rollback");
+    [rs close];
+}
+
+/* SQLITE_BUSY within a nested transaction must be propagated to, and retried by, the outermost transaction */
+- (void) testNestedBlockTransactionRetry {
+    NSError *error;
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a int)"], @"Could not create test table");
+
+    __block int outerRunCount = 0;
+    __block int innerRunCount = 0;
+    __block NSError *innerError = nil;
+    BOOL ret = [_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+        outerRunCount++;
+
+        NSError *nestedError = nil;
+        BOOL nested = [_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+            innerRunCount++;
+            [_db executeUpdate: @"INSERT INTO test (a) VALUES (1)"];
+
+            /* Trigger a fake SQLITE_BUSY retry. */
+            if (innerRunCount < 2) {
+                [_db setTxBusy];
+                return PLDatabaseTransactionRollback;
+            }
+            return PLDatabaseTransactionCommit;
+        } error: &nestedError];
+
+        /* The documented pattern; the nested failure must be reported, so that the whole transaction is retried */
+        if (!nested) {
+            innerError = [nestedError retain];
+            return PLDatabaseTransactionRollback;
+        }
+        return PLDatabaseTransactionCommit;
+    } error: &error];
+
+    STAssertNotNil(innerError, @"Busy rollback of the nested transaction was not reported");
+    STAssertEqualObjects(PLDatabaseErrorDomain, [innerError domain], @"Incorrect error domain");
+    STAssertEquals(SQLITE_BUSY, [[[innerError userInfo] objectForKey: PLDatabaseErrorVendorErrorKey] intValue], @"Expected SQLITE_BUSY");
+    [innerError release];
+
+    STAssertTrue(ret, @"Transaction failed: %@", error);
+    STAssertEquals(2, outerRunCount, @"Outer transaction was not retried");
+    STAssertEquals(2, innerRunCount, @"Nested transaction was retried independently");
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM test"];
+    STAssertTrue([rs next], @"No result returned");
+    STAssertEquals(1, [rs intForColumnIndex: 0], @"Incorrect rows committed");
+    [rs close];
+}
+
+/* Retries must stop once the retry policy is exhausted, and be counted */
+- (void) testRetryPolicyExhausted {
+    PLSqliteRetryPolicy *policy = [PLSqliteRetryPolicy backoffPolicy];
+    policy.maxAttempts = 3;
+    policy.initialBackoff = 0.0001;
+
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.retryPolicy = policy;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+    STAssertTrue([db open], @"Could not open the database");
+
+    __block int runCount = 0;
+    NSError *error = nil;
+    BOOL ret = [db performTransactionWithIsolationLevel: PLDatabaseIsolationLevelImmediate retryBlock: ^PLDatabaseTransactionResult {
+        runCount++;
+
+        /* Trigger a fake SQLITE_BUSY retry, every time. */
+        [db setTxBusy];
+        return PLDatabaseTransactionRollback;
+    } error: &error];
+
+    STAssertFalse(ret, @"Transaction succeeded after exhausting its retry policy");
+    STAssertEquals(PLDatabaseErrorTimedOut, (PLDatabaseError) [error code], @"Unexpected error code");
+    STAssertEquals(3, runCount, @"Transaction was not attempted the maximum number of times");
+    STAssertEquals((NSUInteger) 2, [db lastTransactionRetryCount], @"Incorrect retry count");
+    STAssertEquals((uint64_t) 2, [db totalTransactionRetryCount], @"Incorrect total retry count");
+    STAssertEquals((uint64_t) 1, [db totalTransactionRetryFailures], @"Incorrect retry failure count");
+
+    /* A subsequent transaction resets the per-transaction count */
+    ret = [db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+        return PLDatabaseTransactionCommit;
+    } error: &error];
+    STAssertTrue(ret, @"Transaction failed: %@", error);
+    STAssertEquals((NSUInteger) 0, [db lastTransactionRetryCount], @"Retry count was not reset");
+}
+
 - (void) testBeginTransactionWithIsolationLevel {
     NSError *error;
     STAssertTrue([_db beginTransactionWithIsolationLevel: PLDatabaseIsolationLevelReadCommitted error: &error], @"Could not start a transaction: %@", error);
@@ -344,6 +536,9 @@
     STAssertTrue([_db beginTransactionWithIsolationLevel: PLDatabaseIsolationLevelReadUncommitted error: &error], @"Could not start a transaction: %@", error);
     STAssertTrue([_db rollbackTransactionAndReturnError: &error], @"Could not roll back transaction: %@", error);
     
+    STAssertTrue([_db beginTransactionWithIsolationLevel: PLDatabaseIsolationLevelImmediate error: &error], @"Could not start a transaction: %@", error);
+    STAssertTrue([_db rollbackTransactionAndReturnError: &error], @"Could not roll back transaction: %@", error);
+
     STAssertTrue([_db beginTransactionWithIsolationLevel: PLDatabaseIsolationLevelSerializable error: &error], @"Could not start a transaction: %@", error);
     STAssertTrue([_db rollbackTransactionAndReturnError: &error], @"Could not roll back transaction: %@", error);
     
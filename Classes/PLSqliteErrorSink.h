@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <dispatch/dispatch.h>
+#import <pthread.h>
+
+#import "PLDatabaseConstants.h"
+
+@class PLSqliteDatabase;
+
+/**
+ * A database error, as reported to a PLSqliteErrorSink.
+ *
+ * The report is only valid for the duration of the PLSqliteErrorSink::database:reportError: call; any values
+ * required after the call returns must be copied.
+ */
+typedef struct PLSqliteErrorReport {
+    /** The PLDatabaseError error code. */
+    PLDatabaseError errorCode;
+
+    /** A localized description of the error. */
+    NSString *localizedDescription;
+
+    /** The SQL query which caused the error, or nil. */
+    NSString *queryString;
+
+    /** The SQLite error code. */
+    int vendorErrorCode;
+
+    /** The SQLite error message. Owned by SQLite. */
+    const char *vendorErrorMessage;
+} PLSqliteErrorReport;
+
+NSError *PLSqliteErrorFromReport (const PLSqliteErrorReport *report);
+
+/**
+ * Receives reports of all errors encountered by a PLSqliteDatabase connection, including errors for which the caller
+ * did not request an NSError.
+ *
+ * @par Thread Safety
+ * Implementations must be thread-safe; a single sink may be shared by any number of connections, and errors are
+ * reported synchronously on the thread on which they occurred. Implementations should return quickly, deferring
+ * any I/O.
+ */
+@protocol PLSqliteErrorSink <NSObject>
+
+/**
+ * Report an error encountered by @a database.
+ *
+ * @param database The database connection on which the error occurred.
+ * @param report The error report. The report is only valid for the duration of this call.
+ */
+- (void) database: (PLSqliteDatabase *) database reportError: (const PLSqliteErrorReport *) report;
+
+@end
+
+
+@interface PLSqliteLogErrorSink : NSObject <PLSqliteErrorSink> {
+@private
+    /** Maximum number of reports logged per interval. */
+    NSUInteger _maxReports;
+
+    /** The rate limiting interval, in seconds. */
+    NSTimeInterval _interval;
+
+    /** Lock that must be held when accessing the rate limiting state. */
+    pthread_mutex_t _lock;
+
+    /** Start of the current rate limiting interval, in seconds since the epoch. */
+    double _intervalStart;
+
+    /** Number of reports logged in the current interval. */
+    NSUInteger _intervalReports;
+
+    /** Number of reports suppressed since the last logged report. */
+    NSUInteger _suppressedReports;
+
+    /** Total number of reports suppressed. */
+    uint64_t _totalSuppressedReports;
+
+    /** Serial queue on which reports are logged. */
+    dispatch_queue_t _queue;
+}
+
++ (PLSqliteLogErrorSink *) defaultSink;
+
+- (id) initWithMaxReports: (NSUInteger) maxReports interval: (NSTimeInterval) interval;
+
+/** The maximum number of reports logged per interval. */
+@property(nonatomic, readonly) NSUInteger maxReports;
+
+/** The rate limiting interval, in seconds. */
+@property(nonatomic, readonly) NSTimeInterval interval;
+
+/** The total number of reports that have been suppressed by rate limiting. */
+@property(nonatomic, readonly) uint64_t totalSuppressedReports;
+
+@end
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteErrorSink.h"
+#import "PLSqliteDatabase.h"
+
+#import <sys/time.h>
+
+/** Default number of reports logged per interval by the default sink. */
+#define PL_SQLITE_DEFAULT_LOG_MAX_REPORTS 10
+
+/** Default rate limiting interval of the default sink, in seconds. */
+#define PL_SQLITE_DEFAULT_LOG_INTERVAL 1.0
+
+/**
+ * Return an NSError in the PLDatabaseErrorDomain describing @a report.
+ *
+ * @param report The error report.
+ * @return An autoreleased NSError that may be returned to the API caller.
+ */
+NSError *PLSqliteErrorFromReport (const PLSqliteErrorReport *report) {
+    NSString *vendorString = nil;
+    if (report->vendorErrorMessage != NULL)
+        vendorString = [NSString stringWithUTF8String: report->vendorErrorMessage];
+
+    return [PlausibleDatabase errorWithCode: report->errorCode
+                       localizedDescription: report->localizedDescription
+                                queryString: report->queryString
+                                vendorError: [NSNumber numberWithInt: report->vendorErrorCode]
+                          vendorErrorString: vendorString];
+}
+
+/**
+ * An error sink that logs reports via NSLog(), subject to a rate limit.
+ *
+ * At most @a maxReports reports are logged within any interval; further reports within the interval are counted
+ * and suppressed, and the count is included with the next logged report. Reports are formatted on the reporting
+ * thread, but written on a background queue, so that the error path never waits on the log.
+ *
+ * @par Thread Safety
+ * Thread-safe. May be used from any thread.
+ */
+@implementation PLSqliteLogErrorSink
+
+@synthesize maxReports = _maxReports;
+@synthesize interval = _interval;
+
+/**
+ * Return the shared sink used by default for all PLSqliteDatabase connections. The default sink logs at most 10
+ * reports per second.
+ */
++ (PLSqliteLogErrorSink *) defaultSink {
+    static PLSqliteLogErrorSink *sink = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sink = [[PLSqliteLogErrorSink alloc] initWithMaxReports: PL_SQLITE_DEFAULT_LOG_MAX_REPORTS
+                                                       interval: PL_SQLITE_DEFAULT_LOG_INTERVAL];
+    });
+
+    return sink;
+}
+
+/**
+ * Initialize a new log sink.
+ *
+ * @param maxReports The maximum number of reports to log within any @a interval. If 0, all reports are suppressed.
+ * @param interval The rate limiting interval, in seconds.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteLogErrorSink class.
+ */
+- (id) initWithMaxReports: (NSUInteger) maxReports interval: (NSTimeInterval) interval {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _maxReports = maxReports;
+    _interval = interval;
+    _queue = dispatch_queue_create("com.plausiblelabs.database.errorlog", NULL);
+
+    pthread_mutex_init(&_lock, NULL);
+
+    return self;
+}
+
+- (void) dealloc {
+    /* Every enqueued block retains its message, but not the receiver; draining the queue is not required. */
+    dispatch_release(_queue);
+    pthread_mutex_destroy(&_lock);
+
+    [super dealloc];
+}
+
+- (uint64_t) totalSuppressedReports {
+    uint64_t count;
+
+    pthread_mutex_lock(&_lock); {
+        count = _totalSuppressedReports;
+    } pthread_mutex_unlock(&_lock);
+
+    return count;
+}
+
+// from PLSqliteErrorSink protocol
+- (void) database: (PLSqliteDatabase *) database reportError: (const PLSqliteErrorReport *) report {
+    NSUInteger suppressed = 0;
+    BOOL shouldLog = NO;
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    double now = (double) tv.tv_sec + (double) tv.tv_usec / 1e6;
+
+    pthread_mutex_lock(&_lock); {
+        /* Start a new interval */
+        if (now - _intervalStart >= _interval || now < _intervalStart) {
+            _intervalStart = now;
+            _intervalReports = 0;
+        }
+
+        if (_intervalReports < _maxReports) {
+            _intervalReports++;
+            suppressed = _suppressedReports;
+            _suppressedReports = 0;
+            shouldLog = YES;
+        } else {
+            _suppressedReports++;
+            _totalSuppressedReports++;
+        }
+    } pthread_mutex_unlock(&_lock);
+
+    if (!shouldLog)
+        return;
+
+    /* Format the message now; the report is only valid for the duration of this call */
+    NSString *message = [NSString stringWithFormat: @"A SQLite database error occurred on database '%@': %@ (SQLite #%d: %s) (query: '%@')",
+                         [database path], report->localizedDescription, report->vendorErrorCode,
+                         report->vendorErrorMessage != NULL ? report->vendorErrorMessage : "<none>",
+                         report->queryString != nil ? report->queryString : @"<none>"];
+
+    if (suppressed > 0)
+        message = [message stringByAppendingFormat: @" (%lu similar reports suppressed)", (unsigned long) suppressed];
+
+    [message retain];
+    dispatch_async(_queue, ^{
+        NSLog(@"%@", message);
+        [message release];
+    });
+}
+
+@end
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PLSqliteDatabase.h"
+#import "PLSqliteErrorSink.h"
+
+/* Records all reported errors */
+@interface PLSqliteRecordingErrorSink : NSObject <PLSqliteErrorSink> {
+@public
+    NSMutableArray *_reports;
+}
+@end
+
+@implementation PLSqliteRecordingErrorSink
+
+- (id) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _reports = [[NSMutableArray alloc] init];
+    return self;
+}
+
+- (void) dealloc {
+    [_reports release];
+    [super dealloc];
+}
+
+- (void) database: (PLSqliteDatabase *) database reportError: (const PLSqliteErrorReport *) report {
+    [_reports addObject: PLSqliteErrorFromReport(report)];
+}
+
+@end
+
+
+@interface PLSqliteErrorSinkTests : SenTestCase {
+@private
+}
+
+@end
+
+@implementation PLSqliteErrorSinkTests
+
+/* Errors must be reported to the sink whether or not the caller requested an NSError */
+- (void) testReportErrors {
+    PLSqliteRecordingErrorSink *sink = [[[PLSqliteRecordingErrorSink alloc] init] autorelease];
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.errorSink = sink;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+    STAssertTrue([db open], @"Could not open the database");
+
+    STAssertFalse([db executeUpdate: @"INSERT INTO missing (a) VALUES (1)"], @"Update of a missing table succeeded");
+    STAssertEquals((NSUInteger) 1, [sink->_reports count], @"Error was not reported");
+
+    NSError *error = nil;
+    STAssertNil([db executeQueryAndReturnError: &error statement: @"SELECT * FROM missing"], @"Query of a missing table succeeded");
+    STAssertEquals((NSUInteger) 2, [sink->_reports count], @"Error was not reported");
+
+    /* The reported and returned errors must match */
+    NSError *reported = [sink->_reports objectAtIndex: 1];
+    STAssertNotNil(error, @"No error was returned");
+    STAssertEquals([error code], [reported code], @"Error codes do not match");
+    STAssertEqualObjects([[error userInfo] objectForKey: PLDatabaseErrorVendorErrorKey], [[reported userInfo] objectForKey: PLDatabaseErrorVendorErrorKey], @"Vendor errors do not match");
+    STAssertEqualObjects(@"SELECT * FROM missing", [[error userInfo] objectForKey: PLDatabaseErrorQueryStringKey], @"Query string was not provided");
+    STAssertNotNil([[error userInfo] objectForKey: PLDatabaseErrorVendorStringKey], @"Vendor string was not provided");
+
+    [db close];
+}
+
+/* A nil sink disables reporting, but errors must still be returned */
+- (void) testNilSink {
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.errorSink = nil;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+    STAssertTrue([db open], @"Could not open the database");
+
+    NSError *error = nil;
+    STAssertFalse([db executeUpdateAndReturnError: &error statement: @"INSERT INTO missing (a) VALUES (1)"], @"Update of a missing table succeeded");
+    STAssertNotNil(error, @"No error was returned");
+
+    [db close];
+}
+
+- (void) testLogSinkRateLimit {
+    PLSqliteLogErrorSink *sink = [[[PLSqliteLogErrorSink alloc] initWithMaxReports: 2 interval: 60.0] autorelease];
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.errorSink = sink;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+    STAssertTrue([db open], @"Could not open the database");
+
+    for (int i = 0; i < 5; i++)
+        [db executeUpdate: @"INSERT INTO missing (a) VALUES (1)"];
+
+    STAssertEquals((uint64_t) 3, [sink totalSuppressedReports], @"Reports beyond the rate limit were not suppressed");
+
+    [db close];
+}
+
+@end
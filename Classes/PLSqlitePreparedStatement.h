@@ -43,12 +43,21 @@
      * statement should simply be finalized. */
     PLSqliteStatementCache *_statementCache;
 
+    /** The statement cache entry for our query string, or nil if statement caching is disabled. */
+    PLSqliteStatementCacheEntry *_statementCacheEntry;
+
     /** The prepared SQLite statement. */
     sqlite3_stmt *_sqlite_stmt;
     
     /** The unprepared query string. */
     NSString *_queryString;
 
+    /** The lazily constructed column name index, if no statement cache entry is available. */
+    PLSqliteColumnNameIndex *_columnNameIndex;
+
+    /** The lazily constructed parameter name table, if no statement cache entry is available. */
+    NSArray *_parameterNames;
+
     /** Number of parameters. */
     int _parameterCount;
     
@@ -57,10 +66,21 @@
     
     /** If YES, the prepared statement is closed when the first result set is checked in. */
     BOOL _closeAtCheckin;
+
+    /** The binding mode for string and blob values. */
+    PLPreparedStatementBindingMode _bindingMode;
+
+    /** If YES, one or more parameters are bound to borrowed buffers, and must be cleared before the statement is
+     * checked back in to the statement cache. */
+    BOOL _hasBorrowedBindings;
+
+    /** Values borrowed by the current parameter bindings, or nil. */
+    NSMutableArray *_borrowedValues;
 }
 
 - (id) initWithDatabase: (PLSqliteDatabase *) db 
          statementCache: (PLSqliteStatementCache *) statementCache 
+    statementCacheEntry: (PLSqliteStatementCacheEntry *) statementCacheEntry
              sqliteStmt: (sqlite3_stmt *) sqlite_stmt 
             queryString: (NSString *) queryString
          closeAtCheckin: (BOOL) closeAtCheckin;
@@ -70,6 +90,8 @@
 // DO NOT CALL. Must only be called from PLSqliteResultSet
 - (void) checkinResultSet: (PLSqliteResultSet *) resultSet;
 
+- (PLSqliteColumnNameIndex *) columnNameIndex;
+
 /** The prepared statement's backing database. */
 @property(nonatomic, readonly) PLSqliteDatabase *database;
 
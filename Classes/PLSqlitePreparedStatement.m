@@ -28,6 +28,7 @@
  */
 
 #import "PLSqlitePreparedStatement.h"
+#import "PLSqliteUnlockNotify.h"
 
 #pragma mark Parameter Strategy
 
@@ -56,6 +57,10 @@
 @private
     NSArray *_values;
 }
+
+/** The parameter values. May be replaced to re-use the strategy for multiple rows. */
+@property(nonatomic, retain) NSArray *values;
+
 @end
 
 /**
@@ -64,6 +69,8 @@
  */
 @implementation PLSqliteArrayParameterStrategy
 
+@synthesize values = _values;
+
 - (id) initWithValues: (NSArray *) values {
     if ((self = [super init]) == nil)
         return nil;
@@ -95,7 +102,14 @@
 @interface PLSqliteDictionaryParameterStrategy : NSObject <PLSqliteParameterStrategy> {
 @private
     NSDictionary *_values;
+
+    /** The statement's parameter names, as returned by pl_sqlite3_parameter_names(). */
+    NSArray *_parameterNames;
 }
+
+/** The parameter values. May be replaced to re-use the strategy for multiple rows. */
+@property(nonatomic, retain) NSDictionary *values;
+
 @end
 
 /**
@@ -104,17 +118,28 @@
  */
 @implementation PLSqliteDictionaryParameterStrategy
 
-- (id) initWithValueDictionary: (NSDictionary *) values {
+@synthesize values = _values;
+
+/**
+ * Initialize the strategy.
+ *
+ * @param values The parameter values, keyed by parameter name.
+ * @param parameterNames The statement's parameter names, as returned by pl_sqlite3_parameter_names(). The names
+ * are computed once per cached query, avoiding a name lookup and string allocation per parameter per binding.
+ */
+- (id) initWithValueDictionary: (NSDictionary *) values parameterNames: (NSArray *) parameterNames {
     if ((self = [super init]) == nil)
         return nil;
 
     _values = [values retain];
+    _parameterNames = [parameterNames retain];
 
     return self;
 }
 
 - (void) dealloc {
     [_values release];
+    [_parameterNames release];
     [super dealloc];
 }
 
@@ -124,18 +149,12 @@
 
 // from PLSqliteParameterStrategy protocol
 - (id) valueForParameter: (int) parameterIndex withStatement: (sqlite3_stmt *) stmt {
-    const char *sqlite_name;
-
-    /* Fetch the parameter name. */
-    sqlite_name = sqlite3_bind_parameter_name(stmt, parameterIndex);
-    
-    /* If there is no name, or if it's blank, we can't retrieve the value. */
-    if (sqlite_name == NULL || *sqlite_name == '\0')
-        return NULL;
+    /* If there is no name, we can't retrieve the value. */
+    id name = [_parameterNames objectAtIndex: parameterIndex - 1];
+    if (name == [NSNull null])
+        return nil;
 
-    /* Fetch the value, stripping the initial ':' characeter. */
-    assert(*sqlite_name != '\0'); // checked above.
-    return [_values objectForKey: [NSString stringWithUTF8String: sqlite_name + 1]];
+    return [_values objectForKey: name];
 }
 
 @end
@@ -147,8 +166,17 @@
 
 - (int) bindValueForParameter: (int) parameterIndex withValue: (id) value;
 
+- (BOOL) stepAndReturnError: (NSError **) outError;
+
+- (NSArray *) parameterNames;
+
 - (void) assertNotClosed;
 - (void) assertNotInUse;
+- (void) assertBindableParameterIndex: (int) parameterIndex;
+- (void) raiseBindError: (int) ret forParameterIndex: (int) parameterIndex;
+- (sqlite3_destructor_type) destructorForBorrowedValue: (id) value;
+- (void) clearBorrowedBindings;
+- (void) rollbackBatchSavepoint;
 
 - (PLSqliteResultSet *) checkoutResultSet;
 
@@ -175,6 +203,7 @@
  *
  * @param db A reference to the managing PLSqliteDatabase instance.
  * @param statementCache The statement cache into which the backing sqlite3_stmt should be checked back in.
+ * @param statementCacheEntry The statement cache entry for @a queryString, or nil if none is available.
  * @param sqliteStmt The prepared sqlite statement. This class will assume ownership of the reference.
  * @param queryString The original SQL query string, used for error reporting.
  * @param closeAtCheckin A flag specifying whether the statement should be closed at first checkin. Used to support returning
@@ -189,6 +218,7 @@
  */
 - (id) initWithDatabase: (PLSqliteDatabase *) db 
          statementCache: (PLSqliteStatementCache *) statementCache 
+    statementCacheEntry: (PLSqliteStatementCacheEntry *) statementCacheEntry
              sqliteStmt: (sqlite3_stmt *) sqlite_stmt 
             queryString: (NSString *) queryString
          closeAtCheckin: (BOOL) closeAtCheckin
@@ -202,9 +232,11 @@
     /* Save our database and statement reference. */
     _database = [db retain];
     _statementCache = [statementCache retain];
+    _statementCacheEntry = [statementCacheEntry retain];
     _sqlite_stmt = sqlite_stmt;
     _queryString = [queryString retain];
     _inUse = NO;
+    _bindingMode = PLPreparedStatementBindingModeCopy;
 
     /* Cache parameter count */
     _parameterCount = sqlite3_bind_parameter_count(_sqlite_stmt);
@@ -221,11 +253,16 @@
     /* Now release the database. */
     [_database release];
     
-    /* Drop the statement cache reference */
+    /* Drop the statement cache references */
+    [_statementCacheEntry release];
     [_statementCache release];
     
     /* Release the query statement */
     [_queryString release];
+
+    [_columnNameIndex release];
+    [_parameterNames release];
+    [_borrowedValues release];
     
     [super dealloc];
 }
@@ -236,8 +273,15 @@
     if (_sqlite_stmt == NULL)
         return;
 
+    /* Reset every binding. The cached statement may be re-used by a caller that binds only some parameters by
+     * index, who must not observe our values; borrowed buffers must also not outlive the statement. */
+    sqlite3_reset(_sqlite_stmt);
+    sqlite3_clear_bindings(_sqlite_stmt);
+    [_borrowedValues removeAllObjects];
+    _hasBorrowedBindings = NO;
+
     /* Check in the statement. */
-    [_statementCache checkinStatement: _sqlite_stmt forQuery: _queryString];
+    [_statementCache checkinStatement: _sqlite_stmt forCacheEntry: _statementCacheEntry];
     _sqlite_stmt = NULL;
 }
 
@@ -272,6 +316,9 @@
 - (void) bindParametersWithStrategy: (id<PLSqliteParameterStrategy>) strategy {
     [self assertNotInUse];
 
+    /* Release any values borrowed by the previous bindings; all parameters are re-bound below */
+    [self clearBorrowedBindings];
+
     /* Verify that a complete parameter list was provided */
     if ([strategy count] < _parameterCount)
         [NSException raise: PLSqliteException 
@@ -311,10 +358,88 @@
 - (void) bindParameterDictionary: (NSDictionary *) parameters {
     PLSqliteDictionaryParameterStrategy *strategy;
     
-    strategy = [[[PLSqliteDictionaryParameterStrategy alloc] initWithValueDictionary: parameters] autorelease];
+    strategy = [[[PLSqliteDictionaryParameterStrategy alloc] initWithValueDictionary: parameters parameterNames: [self parameterNames]] autorelease];
     [self bindParametersWithStrategy: strategy];
 }
 
+/* from PLPreparedStatement */
+- (int) parameterIndexForName: (NSString *) name {
+    [self assertNotClosed];
+
+    NSUInteger index = [[self parameterNames] indexOfObject: name];
+    if (index == NSNotFound)
+        [NSException raise: PLSqliteException format: @"Unknown parameter name '%@' for query %@", name, _queryString];
+
+    return (int) index;
+}
+
+/* from PLPreparedStatement */
+- (void) setBindingMode: (PLPreparedStatementBindingMode) bindingMode {
+    _bindingMode = bindingMode;
+}
+
+/* from PLPreparedStatement */
+- (PLPreparedStatementBindingMode) bindingMode {
+    return _bindingMode;
+}
+
+/* from PLPreparedStatement */
+- (void) bindInt64: (int64_t) value atIndex: (int) parameterIndex {
+    [self assertBindableParameterIndex: parameterIndex];
+
+    int ret = sqlite3_bind_int64(_sqlite_stmt, parameterIndex + 1, value);
+    if (ret != SQLITE_OK)
+        [self raiseBindError: ret forParameterIndex: parameterIndex];
+}
+
+/* from PLPreparedStatement */
+- (void) bindDouble: (double) value atIndex: (int) parameterIndex {
+    [self assertBindableParameterIndex: parameterIndex];
+
+    int ret = sqlite3_bind_double(_sqlite_stmt, parameterIndex + 1, value);
+    if (ret != SQLITE_OK)
+        [self raiseBindError: ret forParameterIndex: parameterIndex];
+}
+
+/* from PLPreparedStatement */
+- (void) bindUTF8: (const char *) text length: (int) length atIndex: (int) parameterIndex {
+    [self assertBindableParameterIndex: parameterIndex];
+
+    sqlite3_destructor_type destructor = SQLITE_TRANSIENT;
+    if (_bindingMode == PLPreparedStatementBindingModeBorrow) {
+        destructor = SQLITE_STATIC;
+        _hasBorrowedBindings = YES;
+    }
+
+    int ret = sqlite3_bind_text(_sqlite_stmt, parameterIndex + 1, text, length, destructor);
+    if (ret != SQLITE_OK)
+        [self raiseBindError: ret forParameterIndex: parameterIndex];
+}
+
+/* from PLPreparedStatement */
+- (void) bindBlob: (const void *) bytes length: (int) length atIndex: (int) parameterIndex {
+    [self assertBindableParameterIndex: parameterIndex];
+
+    sqlite3_destructor_type destructor = SQLITE_TRANSIENT;
+    if (_bindingMode == PLPreparedStatementBindingModeBorrow) {
+        destructor = SQLITE_STATIC;
+        _hasBorrowedBindings = YES;
+    }
+
+    int ret = sqlite3_bind_blob(_sqlite_stmt, parameterIndex + 1, bytes, length, destructor);
+    if (ret != SQLITE_OK)
+        [self raiseBindError: ret forParameterIndex: parameterIndex];
+}
+
+/* from PLPreparedStatement */
+- (void) bindNullAtIndex: (int) parameterIndex {
+    [self assertBindableParameterIndex: parameterIndex];
+
+    int ret = sqlite3_bind_null(_sqlite_stmt, parameterIndex + 1);
+    if (ret != SQLITE_OK)
+        [self raiseBindError: ret forParameterIndex: parameterIndex];
+}
+
 /* from PLPreparedStatement */
 - (BOOL) executeUpdate {
     return [self executeUpdateAndReturnError: NULL];
@@ -325,28 +450,106 @@
 - (BOOL) executeUpdateAndReturnError: (NSError **) outError {
     [self assertNotInUse];
 
-    PLSqliteResultSet *rs;
-    BOOL ret;
+    /* Step the virtual machine once to execute the statement. There's no need to create a result set. */
+    return [self stepAndReturnError: outError];
+}
+
+/* from PLPreparedStatement */
+- (BOOL) executeBatch: (id<NSFastEnumeration>) rows error: (NSError **) outError {
+    return [self executeBatch: rows inTransaction: NO failedRowIndexes: NULL error: outError];
+}
+
+/* from PLPreparedStatement */
+- (BOOL) executeBatch: (id<NSFastEnumeration>) rows
+        inTransaction: (BOOL) inTransaction
+     failedRowIndexes: (NSIndexSet **) failedRowIndexes
+                error: (NSError **) outError
+{
+    [self assertNotInUse];
 
-    /* Execute the query */
-    rs = [self executeQueryAndReturnError: outError];
-    if (rs == nil)
+    NSMutableIndexSet *failed = nil;
+    NSError *firstError = nil;
+    NSUInteger rowIndex = 0;
+    BOOL aborted = NO;
+
+    /* Begin the wrapping transaction. A save point behaves as a BEGIN when no transaction is active, and
+     * nests within the caller's transaction otherwise. */
+    if (inTransaction && ![_database executeUpdateAndReturnError: outError statement: @"SAVEPOINT pl_batch"]) {
+        if (failedRowIndexes != NULL)
+            *failedRowIndexes = [NSIndexSet indexSet];
         return NO;
+    }
 
+    /* The parameter strategies are re-used for all rows, rather than allocating a strategy per row. */
+    PLSqliteArrayParameterStrategy *arrayStrategy = [[PLSqliteArrayParameterStrategy alloc] initWithValues: nil];
+    PLSqliteDictionaryParameterStrategy *dictStrategy = [[PLSqliteDictionaryParameterStrategy alloc] initWithValueDictionary: nil parameterNames: [self parameterNames]];
+
+    @try {
+        for (id row in rows) {
+            /* Bind the row's parameters */
+            if ([row isKindOfClass: [NSArray class]]) {
+                [arrayStrategy setValues: row];
+                [self bindParametersWithStrategy: arrayStrategy];
+            } else if ([row isKindOfClass: [NSDictionary class]]) {
+                [dictStrategy setValues: row];
+                [self bindParametersWithStrategy: dictStrategy];
+            } else {
+                [NSException raise: PLSqliteException format: @"Unsupported batch row type '%@' at index %lu for query %@",
+                    [row class], (unsigned long) rowIndex, _queryString];
+            }
+
+            /* Execute the row. Only the first failure's error is populated, and only if the caller requested it. */
+            if (![self stepAndReturnError: (outError != NULL && firstError == nil) ? &firstError : NULL]) {
+                if (failed == nil)
+                    failed = [NSMutableIndexSet indexSet];
+                [failed addIndex: rowIndex];
+
+                /* Some errors (eg, SQLITE_FULL, or an ON CONFLICT ROLLBACK constraint) cause SQLite to roll back the
+                 * transaction itself. Any further rows would then be committed in autocommit mode. */
+                if (inTransaction && sqlite3_get_autocommit(sqlite3_db_handle(_sqlite_stmt)) != 0) {
+                    aborted = YES;
+                    break;
+                }
+            }
+
+            rowIndex++;
+        }
+    } @catch (NSException *e) {
+        /* Binding failures are programmer errors; roll back our transaction before propagating the exception. */
+        if (inTransaction)
+            [self rollbackBatchSavepoint];
+        @throw;
+    } @finally {
+        /* Don't retain the caller's values beyond the batch */
+        [arrayStrategy release];
+        [dictStrategy release];
+    }
 
-    /* Step the virtual machine once to execute the statement. */
-    if ([rs nextAndReturnError: outError] == PLResultSetStatusError) {
-        /* Error occured. outError has been populated. */
-        ret = NO;
-    } else {
-        ret = YES;
+    /* Complete the wrapping transaction. If SQLite has already rolled back the transaction, there is nothing left
+     * to complete. */
+    if (inTransaction && !aborted) {
+        if (failed == nil) {
+            if (![_database executeUpdateAndReturnError: outError statement: @"RELEASE SAVEPOINT pl_batch"]) {
+                [self rollbackBatchSavepoint];
+                if (failedRowIndexes != NULL)
+                    *failedRowIndexes = [NSIndexSet indexSet];
+                return NO;
+            }
+        } else {
+            [self rollbackBatchSavepoint];
+        }
     }
 
-    /* Clean up the result set */
-    [rs close];
+    if (failedRowIndexes != NULL)
+        *failedRowIndexes = failed != nil ? failed : [NSIndexSet indexSet];
 
-    /* Finished */
-    return ret;
+    if (failed != nil) {
+        if (outError != NULL)
+            *outError = firstError;
+        return NO;
+    }
+
+    return YES;
 }
 
 
@@ -382,6 +585,22 @@
         [self close];
 }
 
+/**
+ * @internal
+ *
+ * Return the column name index for this statement. If the statement was vended by the statement cache, the index
+ * is shared with all other statements prepared for the same query string, and is built only once.
+ */
+- (PLSqliteColumnNameIndex *) columnNameIndex {
+    if (_statementCacheEntry != nil)
+        return [_statementCacheEntry columnNameIndexForStatement: _sqlite_stmt];
+
+    if (_columnNameIndex == nil)
+        _columnNameIndex = [[PLSqliteColumnNameIndex alloc] initWithStatement: _sqlite_stmt];
+
+    return _columnNameIndex;
+}
+
 @end
 
 #pragma mark Private Implementation
@@ -414,6 +633,26 @@
         [NSException raise: PLSqliteException format: @"A PLSqliteResultSet is already active and has not been properly closed for prepared statement '%@'", _queryString];
 }
 
+/**
+ * @internal
+ * Assert that the statement may be bound, and that @a parameterIndex (zero-based) is in range.
+ */
+- (void) assertBindableParameterIndex: (int) parameterIndex {
+    [self assertNotInUse];
+
+    if (parameterIndex < 0 || parameterIndex >= _parameterCount)
+        [NSException raise: PLSqliteException format: @"Attempted to bind out-of-range parameter index %d for query %@", parameterIndex, _queryString];
+}
+
+/**
+ * @internal
+ * Throw an exception (programmer error) for a failed bind of the parameter at @a parameterIndex (zero-based).
+ */
+- (void) raiseBindError: (int) ret forParameterIndex: (int) parameterIndex {
+    [NSException raise: PLSqliteException
+                format: @"SQlite error binding parameter %d for query %@: %@", parameterIndex, _queryString, [_database lastErrorMessage]];
+}
+
 /**
  * @internal
  *
@@ -435,6 +674,37 @@
     return [[[PLSqliteResultSet alloc] initWithPreparedStatement: self sqliteStatemet: _sqlite_stmt] autorelease];
 }
 
+/**
+ * @internal
+ *
+ * Step the statement once, without checking out a result set, and then reset the statement. Returns YES if the
+ * statement executed successfully.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the statement could not be executed.
+ * If no error occurs, this parameter will be left unmodified. You may specify NULL for this
+ * parameter, and no error information will be provided.
+ */
+- (BOOL) stepAndReturnError: (NSError **) outError {
+    int ret = pl_sqlite3_blocking_step(_sqlite_stmt);
+
+    /* Inform the database of deadlock status */
+    if (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+        [_database setTxBusy];
+    } else {
+        [_database resetTxBusy];
+    }
+
+    /* The error must be populated prior to resetting the statement, which would replace the database's
+     * last error message. */
+    BOOL success = (ret == SQLITE_DONE || ret == SQLITE_ROW);
+    if (!success)
+        [self populateError: outError withErrorCode: PLDatabaseErrorQueryFailed description: NSLocalizedString(@"Could not retrieve the next result row", @"Generic result row error")];
+
+    sqlite3_reset(_sqlite_stmt);
+    return success;
+}
+
 /**
  * @internal
  * Bind a value to a statement parameter, returning the SQLite bind result value.
@@ -450,7 +720,7 @@
     
     /* Data */
     else if ([value isKindOfClass: [NSData class]]) {
-        return sqlite3_bind_blob(_sqlite_stmt, parameterIndex, [value bytes], [value length], SQLITE_TRANSIENT);
+        return sqlite3_bind_blob(_sqlite_stmt, parameterIndex, [value bytes], [value length], [self destructorForBorrowedValue: value]);
     }
     
     /* Date */
@@ -460,6 +730,14 @@
     
     /* String */
     else if ([value isKindOfClass: [NSString class]]) {
+        /* Only strings with a directly available UTF-8 representation may be borrowed; -UTF8String may return an
+         * autoreleased buffer. */
+        if (_bindingMode == PLPreparedStatementBindingModeBorrow) {
+            const char *text = CFStringGetCStringPtr((CFStringRef) value, kCFStringEncodingUTF8);
+            if (text != NULL)
+                return sqlite3_bind_text(_sqlite_stmt, parameterIndex, text, -1, [self destructorForBorrowedValue: value]);
+        }
+
         return sqlite3_bind_text(_sqlite_stmt, parameterIndex, [value UTF8String], -1, SQLITE_TRANSIENT);
     }
     
@@ -490,4 +768,71 @@
     abort();
 }
 
+/**
+ * @internal
+ *
+ * Return the SQLite destructor to be used when binding the contents of @a value. If the statement's binding mode is
+ * PLPreparedStatementBindingModeBorrow, @a value is retained until the statement's borrowed bindings are cleared, and
+ * SQLITE_STATIC is returned. Otherwise, SQLITE_TRANSIENT is returned.
+ */
+- (sqlite3_destructor_type) destructorForBorrowedValue: (id) value {
+    if (_bindingMode != PLPreparedStatementBindingModeBorrow)
+        return SQLITE_TRANSIENT;
+
+    if (_borrowedValues == nil)
+        _borrowedValues = [[NSMutableArray alloc] init];
+
+    [_borrowedValues addObject: value];
+    _hasBorrowedBindings = YES;
+
+    return SQLITE_STATIC;
+}
+
+/**
+ * @internal
+ *
+ * If any parameters are bound to borrowed buffers, reset all parameter bindings to NULL and release any
+ * borrowed values.
+ */
+- (void) clearBorrowedBindings {
+    if (!_hasBorrowedBindings)
+        return;
+
+    sqlite3_clear_bindings(_sqlite_stmt);
+    [_borrowedValues removeAllObjects];
+    _hasBorrowedBindings = NO;
+}
+
+/**
+ * @internal
+ *
+ * Roll back and release the save point of a transactional batch, if the transaction has not already been rolled
+ * back by SQLite. Errors are ignored; the batch has already failed.
+ */
+- (void) rollbackBatchSavepoint {
+    if (sqlite3_get_autocommit(sqlite3_db_handle(_sqlite_stmt)) != 0)
+        return;
+
+    /* ROLLBACK TO leaves the save point on the stack; it must also be released */
+    if ([_database executeUpdateAndReturnError: NULL statement: @"ROLLBACK TO SAVEPOINT pl_batch"])
+        [_database executeUpdateAndReturnError: NULL statement: @"RELEASE SAVEPOINT pl_batch"];
+}
+
+/**
+ * @internal
+ *
+ * Return the statement's parameter names, as returned by pl_sqlite3_parameter_names(). If the statement was vended
+ * by the statement cache, the names are shared with all other statements prepared for the same query string, and
+ * are computed only once.
+ */
+- (NSArray *) parameterNames {
+    if (_statementCacheEntry != nil)
+        return [_statementCacheEntry parameterNamesForStatement: _sqlite_stmt];
+
+    if (_parameterNames == nil)
+        _parameterNames = [pl_sqlite3_parameter_names(_sqlite_stmt) retain];
+
+    return _parameterNames;
+}
+
 @end
\ No newline at end of file
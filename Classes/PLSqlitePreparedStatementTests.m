@@ -139,6 +139,120 @@
 }
 
 
+/* Test batch execution with both array and dictionary rows */
+- (void) testExecuteBatch {
+    NSError *error;
+
+    id<PLPreparedStatement> stmt = [_db prepareStatement: @"INSERT INTO test (name, color) VALUES (:name, :color)"];
+    NSArray *rows = [NSArray arrayWithObjects:
+                     [NSArray arrayWithObjects: @"Johnny", @"blue", nil],
+                     [NSDictionary dictionaryWithObjectsAndKeys: @"Sarah", @"name", @"red", @"color", nil],
+                     nil];
+
+    NSIndexSet *failed;
+    STAssertTrue([stmt executeBatch: rows inTransaction: YES failedRowIndexes: &failed error: &error], @"Batch failed: %@", error);
+    STAssertEquals((NSUInteger) 0, [failed count], @"Unexpected failed rows");
+    [stmt close];
+
+    /* Verify the inserted rows */
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT color FROM test ORDER BY name"];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"Missing row");
+    STAssertEqualObjects(@"blue", [rs stringForColumn: @"color"], @"Incorrect value");
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"Missing row");
+    STAssertEqualObjects(@"red", [rs stringForColumn: @"color"], @"Incorrect value");
+    STAssertEquals(PLResultSetStatusDone, [rs nextAndReturnError: NULL], @"Unexpected row");
+    [rs close];
+}
+
+/* Test reporting of failed batch rows, with and without a wrapping transaction */
+- (void) testExecuteBatchFailures {
+    NSError *error = nil;
+    NSIndexSet *failed;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE batch (a INTEGER UNIQUE)"], @"Could not create table");
+
+    NSMutableArray *rows = [NSMutableArray array];
+    for (int i = 0; i < 5; i++)
+        [rows addObject: [NSArray arrayWithObject: [NSNumber numberWithInt: i == 3 ? 1 : i]]];
+
+    /* Without a transaction, the valid rows are inserted */
+    id<PLPreparedStatement> stmt = [_db prepareStatement: @"INSERT INTO batch (a) VALUES (?)"];
+    STAssertFalse([stmt executeBatch: rows inTransaction: NO failedRowIndexes: &failed error: &error], @"Batch did not fail");
+    STAssertNotNil(error, @"No error was returned");
+    STAssertEqualObjects([NSIndexSet indexSetWithIndex: 3], failed, @"Incorrect failed rows");
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM batch"];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"Missing row");
+    STAssertEquals(4, [rs intForColumnIndex: 0], @"Incorrect row count");
+    [rs close];
+
+    /* With a transaction, no rows are inserted */
+    STAssertTrue([_db executeUpdate: @"DELETE FROM batch"], @"Could not delete rows");
+    STAssertFalse([stmt executeBatch: rows inTransaction: YES failedRowIndexes: &failed error: NULL], @"Batch did not fail");
+    STAssertEqualObjects([NSIndexSet indexSetWithIndex: 3], failed, @"Incorrect failed rows");
+
+    rs = [_db executeQuery: @"SELECT COUNT(*) FROM batch"];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"Missing row");
+    STAssertEquals(0, [rs intForColumnIndex: 0], @"Transaction was not rolled back");
+    [rs close];
+
+    /* The statement remains usable */
+    STAssertTrue([stmt executeBatch: rows error: NULL] == NO, @"Batch did not fail");
+    [stmt close];
+}
+
+/* Test that a transactional batch stops once SQLite has rolled back its transaction */
+- (void) testExecuteBatchAutomaticRollback {
+    NSIndexSet *failed;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE batch (a INTEGER UNIQUE ON CONFLICT ROLLBACK)"], @"Could not create table");
+
+    NSMutableArray *rows = [NSMutableArray array];
+    for (int i = 0; i < 5; i++)
+        [rows addObject: [NSArray arrayWithObject: [NSNumber numberWithInt: i == 3 ? 1 : i]]];
+
+    /* Row 4 must not be inserted in autocommit mode after the constraint failure rolls back the transaction */
+    id<PLPreparedStatement> stmt = [_db prepareStatement: @"INSERT INTO batch (a) VALUES (?)"];
+    STAssertFalse([stmt executeBatch: rows inTransaction: YES failedRowIndexes: &failed error: NULL], @"Batch did not fail");
+    STAssertEqualObjects([NSIndexSet indexSetWithIndex: 3], failed, @"Incorrect failed rows");
+    [stmt close];
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM batch"];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"Missing row");
+    STAssertEquals(0, [rs intForColumnIndex: 0], @"Rows were inserted after the transaction was rolled back");
+    [rs close];
+}
+
+/* Test a transactional batch executed within an enclosing transaction */
+- (void) testExecuteBatchNested {
+    __block NSError *error = nil;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE batch (a INTEGER UNIQUE)"], @"Could not create table");
+
+    NSArray *rows = [NSArray arrayWithObjects: [NSArray arrayWithObject: [NSNumber numberWithInt: 1]],
+                     [NSArray arrayWithObject: [NSNumber numberWithInt: 2]], nil];
+    NSArray *badRows = [NSArray arrayWithObjects: [NSArray arrayWithObject: [NSNumber numberWithInt: 3]],
+                        [NSArray arrayWithObject: [NSNumber numberWithInt: 1]], nil];
+
+    id<PLPreparedStatement> stmt = [_db prepareStatement: @"INSERT INTO batch (a) VALUES (?)"];
+    BOOL ret = [_db performTransactionWithRetryBlock: ^PLDatabaseTransactionResult {
+        STAssertTrue([stmt executeBatch: rows inTransaction: YES failedRowIndexes: NULL error: &error], @"Nested batch failed: %@", error);
+
+        /* The failed batch is rolled back, without affecting the enclosing transaction */
+        STAssertFalse([stmt executeBatch: badRows inTransaction: YES failedRowIndexes: NULL error: NULL], @"Batch did not fail");
+        STAssertFalse(sqlite3_get_autocommit([_db sqliteHandle]) != 0, @"Enclosing transaction was ended");
+
+        return PLDatabaseTransactionCommit;
+    } error: &error];
+    STAssertTrue(ret, @"Transaction failed: %@", error);
+    [stmt close];
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM batch"];
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: NULL], @"Missing row");
+    STAssertEquals(2, [rs intForColumnIndex: 0], @"Incorrect row count");
+    [rs close];
+}
+
 /* Test dictionary-based binding */
 - (void) testBindParameterDictionary {
     id<PLPreparedStatement> stmt;
@@ -167,6 +281,28 @@
 }
 
 
+- (void) testParameterIndexForName {
+    id<PLPreparedStatement> stmt;
+
+    /* Resolve the indexes; repeat with the cached statement, which shares the parameter name table */
+    for (int i = 0; i < 2; i++) {
+        stmt = [_db prepareStatement: @"INSERT INTO test (name, color) VALUES (:name, :color)"];
+        STAssertEquals(0, [stmt parameterIndexForName: @"name"], @"Incorrect parameter index");
+        STAssertEquals(1, [stmt parameterIndexForName: @"color"], @"Incorrect parameter index");
+        STAssertThrows([stmt parameterIndexForName: @"extra"], @"Did not throw an exception for unknown parameter");
+
+        [stmt bindUTF8: "Appleseed" length: -1 atIndex: [stmt parameterIndexForName: @"name"]];
+        [stmt bindUTF8: "green" length: -1 atIndex: [stmt parameterIndexForName: @"color"]];
+        STAssertTrue([stmt executeUpdate], @"INSERT failed");
+        [stmt close];
+    }
+
+    id<PLResultSet> rs = [_db executeQuery: @"SELECT COUNT(*) FROM test WHERE name = ? AND color = ?", @"Appleseed", @"green"];
+    STAssertTrue([rs next], @"No data returned");
+    STAssertEquals(2, [rs intForColumnIndex: 0], @"Parameters incorrectly bound");
+    [rs close];
+}
+
 /* Test handling of all supported parameter data types */
 - (void) testBindParameters {
     id<PLPreparedStatement> stmt;
@@ -251,6 +387,117 @@
     [stmt close];
 }
 
+/* Test the typed, unboxed binding methods */
+- (void) testTypedBinders {
+    id<PLPreparedStatement> stmt;
+    id<PLResultSet> rs;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE data (int64val int, doubleval double precision, stringval varchar(30), dataval blob, nilval int)"], @"Could not create table");
+
+    stmt = [_db prepareStatement: @"INSERT INTO data (int64val, doubleval, stringval, dataval, nilval) VALUES (?, ?, ?, ?, ?)"];
+    STAssertNotNil(stmt, @"Could not create statement");
+
+    const char bytes[] = "This is some example test data";
+    const char *text = "test string";
+
+    [stmt bindInt64: INT64_MAX atIndex: 0];
+    [stmt bindDouble: 3.14159 atIndex: 1];
+    [stmt bindUTF8: text length: 4 atIndex: 2];
+    [stmt bindBlob: bytes length: sizeof(bytes) atIndex: 3];
+    [stmt bindNullAtIndex: 4];
+
+    STAssertThrows([stmt bindNullAtIndex: 5], @"Did not throw an exception for out-of-range parameter index");
+    STAssertThrows([stmt bindNullAtIndex: -1], @"Did not throw an exception for out-of-range parameter index");
+
+    STAssertTrue([stmt executeUpdate], @"INSERT failed");
+    [stmt close];
+
+    rs = [_db executeQuery: @"SELECT * FROM data"];
+    STAssertTrue([rs next], @"No rows returned");
+
+    STAssertEquals(INT64_MAX, [rs bigIntForColumn: @"int64val"], @"64-bit integer value incorrect");
+    STAssertEquals(3.14159, [rs doubleForColumn: @"doubleval"], @"Double value incorrect");
+    STAssertEqualObjects(@"test", [rs stringForColumn: @"stringval"], @"String value incorrect");
+    STAssertTrue([[NSData dataWithBytes: bytes length: sizeof(bytes)] isEqualToData: [rs dataForColumn: @"dataval"]], @"Data value incorrect");
+    STAssertTrue([rs isNullForColumn: @"nilval"], @"NULL value not returned");
+
+    [rs close];
+}
+
+/* Typed bindings must not be visible to the next user of a cached statement */
+- (void) testTypedBindingsClearedAtCheckin {
+    id<PLPreparedStatement> stmt;
+    id<PLResultSet> rs;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE data (a int, b double precision, c varchar(30))"], @"Could not create table");
+
+    stmt = [_db prepareStatement: @"INSERT INTO data (a, b, c) VALUES (?, ?, ?)"];
+    [stmt bindInt64: 42 atIndex: 0];
+    [stmt bindDouble: 1.5 atIndex: 1];
+    [stmt bindUTF8: "copied" length: -1 atIndex: 2];
+    STAssertTrue([stmt executeUpdate], @"INSERT failed");
+    [stmt close];
+
+    /* Re-use the cached statement, binding only the first parameter */
+    stmt = [_db prepareStatement: @"INSERT INTO data (a, b, c) VALUES (?, ?, ?)"];
+    [stmt bindInt64: 43 atIndex: 0];
+    STAssertTrue([stmt executeUpdate], @"INSERT failed");
+    [stmt close];
+
+    rs = [_db executeQuery: @"SELECT a, b, c FROM data WHERE a = 43"];
+    STAssertTrue([rs next], @"No rows returned");
+    STAssertFalse([rs isNullForColumnIndex: 0], @"Bound value missing");
+    STAssertTrue([rs isNullForColumnIndex: 1], @"Previous binding was not cleared");
+    STAssertTrue([rs isNullForColumnIndex: 2], @"Previous binding was not cleared");
+    [rs close];
+}
+
+/* Test borrowed (SQLITE_STATIC) string and blob bindings */
+- (void) testBorrowedBindingMode {
+    id<PLPreparedStatement> stmt;
+    id<PLResultSet> rs;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE data (stringval varchar(30), dataval blob)"], @"Could not create table");
+
+    stmt = [_db prepareStatement: @"INSERT INTO data (stringval, dataval) VALUES (?, ?)"];
+    STAssertEquals(PLPreparedStatementBindingModeCopy, [stmt bindingMode], @"Incorrect default binding mode");
+    [stmt setBindingMode: PLPreparedStatementBindingModeBorrow];
+
+    /* Object bindings */
+    const char bytes[] = "This is some example test data";
+    NSData *data = [NSData dataWithBytes: bytes length: sizeof(bytes)];
+    [stmt bindParameters: [NSArray arrayWithObjects: @"object", data, nil]];
+    STAssertTrue([stmt executeUpdate], @"INSERT failed");
+
+    /* Typed bindings */
+    char buffer[] = "typed";
+    [stmt bindUTF8: buffer length: -1 atIndex: 0];
+    [stmt bindBlob: bytes length: sizeof(bytes) atIndex: 1];
+    STAssertTrue([stmt executeUpdate], @"INSERT failed");
+    [stmt close];
+
+    /* Borrowed bindings must not be visible to the next user of the cached statement */
+    stmt = [_db prepareStatement: @"INSERT INTO data (stringval, dataval) VALUES (?, ?)"];
+    STAssertTrue([stmt executeUpdate], @"INSERT failed");
+    [stmt close];
+
+    rs = [_db executeQuery: @"SELECT stringval, dataval FROM data ORDER BY rowid"];
+
+    STAssertTrue([rs next], @"No rows returned");
+    STAssertEqualObjects(@"object", [rs stringForColumnIndex: 0], @"String value incorrect");
+    STAssertTrue([data isEqualToData: [rs dataForColumnIndex: 1]], @"Data value incorrect");
+
+    STAssertTrue([rs next], @"No rows returned");
+    STAssertEqualObjects(@"typed", [rs stringForColumnIndex: 0], @"String value incorrect");
+    STAssertTrue([data isEqualToData: [rs dataForColumnIndex: 1]], @"Data value incorrect");
+
+    STAssertTrue([rs next], @"No rows returned");
+    STAssertTrue([rs isNullForColumnIndex: 0], @"Borrowed binding was not cleared");
+    STAssertTrue([rs isNullForColumnIndex: 1], @"Borrowed binding was not cleared");
+
+    [rs close];
+}
+
 /**
  * Test handling of binding too many parameters. This can occur with a dictionary containing unused keys.
  */
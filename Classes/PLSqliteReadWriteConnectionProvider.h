@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+
+#import "PLDatabaseConnectionProvider.h"
+#import "PLDatabasePoolConnectionProvider.h"
+#import "PLSqliteDatabaseOptions.h"
+
+@interface PLSqliteReadWriteConnectionProvider : NSObject <PLDatabaseConnectionProvider> {
+@private
+    /** Pool of read-write connections. */
+    PLDatabasePoolConnectionProvider *_writerPool;
+
+    /** Pool of read-only connections. */
+    PLDatabasePoolConnectionProvider *_readerPool;
+
+    /** Lock that must be held when enabling WAL journaling. */
+    pthread_mutex_t _journalLock;
+
+    /** YES once the database has been switched to WAL journaling. */
+    volatile BOOL _journalConfigured;
+}
+
+- (id) initWithPath: (NSString *) dbPath readerCapacity: (NSUInteger) readerCapacity;
+
+- (id) initWithPath: (NSString *) dbPath
+     writerCapacity: (NSUInteger) writerCapacity
+     readerCapacity: (NSUInteger) readerCapacity
+            options: (PLSqliteDatabaseOptions *) options;
+
+- (id<PLDatabase>) getReadConnectionAndReturnError: (NSError **) outError;
+- (id<PLDatabase>) getWriteConnectionAndReturnError: (NSError **) outError;
+
+@end
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteReadWriteConnectionProvider.h"
+#import "PLSqliteConnectionProvider.h"
+#import "PLSqliteDatabase.h"
+
+@interface PLSqliteReadWriteConnectionProvider (PrivateMethods)
+- (BOOL) configureJournalModeAndReturnError: (NSError **) outError;
+@end
+
+/**
+ * Provides separate pools of read-write and read-only connections to a single SQLite database, which is
+ * configured for write-ahead logging (WAL).
+ *
+ * In WAL mode, readers do not block the writer, and the writer does not block readers; each reader sees the
+ * database as of the start of its read transaction. Read-only connections are opened with SQLITE_OPEN_READONLY and
+ * pooled independently of the writer connections, so that readers never wait on a connection held by a writer, nor on
+ * SQLite's write lock. As SQLite permits only one writer at a time, a single cached writer connection is generally
+ * sufficient.
+ *
+ * The database is switched to WAL journaling when the first connection is requested. WAL journaling is persistent,
+ * and requires a file-backed database on a local filesystem; in-memory databases are not supported.
+ *
+ * Connections must be returned via closeConnection:, which will return each connection to the pool from which it
+ * was acquired. The PLDatabaseConnectionProvider getConnectionAndReturnError: method returns a writer connection.
+ *
+ * @par Thread Safety
+ * Thread-safe. May be used from any thread, subject to SQLite's documented thread-safety constraints.
+ */
+@implementation PLSqliteReadWriteConnectionProvider
+
+/**
+ * Initialize a new instance with a single cached writer connection.
+ *
+ * @param dbPath Path to the SQLite database file. The database will be created if it does not exist.
+ * @param readerCapacity The maximum number of read-only connections that the pool will cache. If a capacity of 0 is
+ * specified, no capacity limit will be applied.
+ */
+- (id) initWithPath: (NSString *) dbPath readerCapacity: (NSUInteger) readerCapacity {
+    return [self initWithPath: dbPath writerCapacity: 1 readerCapacity: readerCapacity options: nil];
+}
+
+/**
+ * Initialize a new instance.
+ *
+ * @param dbPath Path to the SQLite database file. The database will be created if it does not exist.
+ * @param writerCapacity The maximum number of read-write connections that the pool will cache.
+ * @param readerCapacity The maximum number of read-only connections that the pool will cache.
+ * @param options The options to be used for all new connections, or nil to use the default options. The options
+ * will be copied.
+ *
+ * As with PLDatabasePoolConnectionProvider, each pool will return as many connections as are requested, but will not
+ * cache connections beyond its capacity. If a capacity of 0 is specified, no capacity limit will be applied.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteReadWriteConnectionProvider class.
+ */
+- (id) initWithPath: (NSString *) dbPath
+     writerCapacity: (NSUInteger) writerCapacity
+     readerCapacity: (NSUInteger) readerCapacity
+            options: (PLSqliteDatabaseOptions *) options
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    PLSqliteConnectionProvider *writers = [[[PLSqliteConnectionProvider alloc] initWithPath: dbPath
+                                                                                      flags: SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE
+                                                                                    options: options] autorelease];
+    PLSqliteConnectionProvider *readers = [[[PLSqliteConnectionProvider alloc] initWithPath: dbPath
+                                                                                      flags: SQLITE_OPEN_READONLY
+                                                                                    options: options] autorelease];
+
+    _writerPool = [[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: writers capacity: writerCapacity];
+    _readerPool = [[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: readers capacity: readerCapacity];
+
+    pthread_mutex_init(&_journalLock, NULL);
+
+    return self;
+}
+
+- (void) dealloc {
+    [_writerPool release];
+    [_readerPool release];
+
+    pthread_mutex_destroy(&_journalLock);
+
+    [super dealloc];
+}
+
+/**
+ * Returns a read-only database connection. The connection must be returned via closeConnection:.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the connection could not be
+ * provided.
+ *
+ * @return A read-only database connection, or nil on error.
+ */
+- (id<PLDatabase>) getReadConnectionAndReturnError: (NSError **) outError {
+    if (![self configureJournalModeAndReturnError: outError])
+        return nil;
+
+    return [_readerPool getConnectionAndReturnError: outError];
+}
+
+/**
+ * Returns a read-write database connection. The connection must be returned via closeConnection:.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why the connection could not be
+ * provided.
+ *
+ * @return A read-write database connection, or nil on error.
+ */
+- (id<PLDatabase>) getWriteConnectionAndReturnError: (NSError **) outError {
+    if (![self configureJournalModeAndReturnError: outError])
+        return nil;
+
+    return [_writerPool getConnectionAndReturnError: outError];
+}
+
+// from PLDatabaseConnectionProvider protocol
+- (id<PLDatabase>) getConnectionAndReturnError: (NSError **) outError {
+    return [self getWriteConnectionAndReturnError: outError];
+}
+
+// from PLDatabaseConnectionProvider protocol
+- (void) closeConnection: (id<PLDatabase>) connection {
+    /* Route the connection back to the pool from which it was acquired. A closed connection has no handle; either
+     * pool will simply close it. */
+    sqlite3 *handle = [(PLSqliteDatabase *) connection sqliteHandle];
+    if (handle != NULL && sqlite3_db_readonly(handle, "main") == 1) {
+        [_readerPool closeConnection: connection];
+    } else {
+        [_writerPool closeConnection: connection];
+    }
+}
+
+@end
+
+
+/**
+ * @internal
+ * Private methods.
+ */
+@implementation PLSqliteReadWriteConnectionProvider (PrivateMethods)
+
+/**
+ * Switch the database to WAL journaling, if not already done.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this
+ * pointer will contain an error object indicating why WAL journaling could not be enabled.
+ */
+- (BOOL) configureJournalModeAndReturnError: (NSError **) outError {
+    /* Once configured, the journal mode is persistent; no locking is required */
+    if (_journalConfigured)
+        return YES;
+
+    BOOL result = NO;
+    pthread_mutex_lock(&_journalLock); {
+        if (_journalConfigured) {
+            pthread_mutex_unlock(&_journalLock);
+            return YES;
+        }
+
+        /* A read-only connection can't change the journal mode; this must be done by a writer */
+        id<PLDatabase> db = [_writerPool getConnectionAndReturnError: outError];
+        if (db != nil) {
+            id<PLResultSet> rs = [db executeQueryAndReturnError: outError statement: @"PRAGMA journal_mode = WAL"];
+            if (rs != nil) {
+                /* SQLite returns the resulting journal mode, which will not be WAL if it's unsupported */
+                NSString *mode = nil;
+                if ([rs nextAndReturnError: outError] == PLResultSetStatusRow)
+                    mode = [rs stringForColumnIndex: 0];
+                [rs close];
+
+                if (mode != nil && [mode caseInsensitiveCompare: @"wal"] == NSOrderedSame) {
+                    result = YES;
+                } else if (mode != nil && outError != NULL) {
+                    NSString *desc = [NSString stringWithFormat: NSLocalizedString(@"The database does not support WAL journaling (journal mode is '%@').", @""), mode];
+                    *outError = [PlausibleDatabase errorWithCode: PLDatabaseErrorQueryFailed
+                                            localizedDescription: desc
+                                                     queryString: @"PRAGMA journal_mode = WAL"
+                                                     vendorError: nil
+                                               vendorErrorString: nil];
+                }
+            }
+
+            [_writerPool closeConnection: db];
+        }
+
+        _journalConfigured = result;
+    } pthread_mutex_unlock(&_journalLock);
+
+    return result;
+}
+
+@end
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PLSqliteDatabase.h"
+#import "PLSqliteReadWriteConnectionProvider.h"
+
+@interface PLSqliteReadWriteConnectionProviderTests : SenTestCase {
+@private
+    NSString *_dbPath;
+    PLSqliteReadWriteConnectionProvider *_provider;
+}
+@end
+
+@implementation PLSqliteReadWriteConnectionProviderTests
+
+- (void) setUp {
+    /* Create a temporary file for the database. Secure -- user owns enclosing directory. */
+    _dbPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+    _provider = [[PLSqliteReadWriteConnectionProvider alloc] initWithPath: _dbPath readerCapacity: 4];
+}
+
+- (void) tearDown {
+    /* Closes any cached connections */
+    [_provider release];
+
+    /* Remove the temporary database file, and its WAL and shared memory files */
+    NSFileManager *fm = [NSFileManager defaultManager];
+    for (NSString *suffix in [NSArray arrayWithObjects: @"", @"-wal", @"-shm", nil]) {
+        NSString *path = [_dbPath stringByAppendingString: suffix];
+        if ([fm fileExistsAtPath: path])
+            STAssertTrue([fm removeItemAtPath: path error: NULL], @"Could not clean up database %@", path);
+    }
+
+    [_dbPath release];
+}
+
+- (void) testJournalMode {
+    NSError *error;
+    id<PLDatabase> writer = [_provider getWriteConnectionAndReturnError: &error];
+    STAssertNotNil(writer, @"Failed to fetch connection: %@", error);
+
+    id<PLResultSet> rs = [writer executeQuery: @"PRAGMA journal_mode"];
+    STAssertTrue([rs next], @"No journal mode returned");
+    STAssertEqualObjects(@"wal", [[rs stringForColumnIndex: 0] lowercaseString], @"Database is not in WAL mode");
+    [rs close];
+
+    [_provider closeConnection: writer];
+}
+
+- (void) testReadOnlyConnections {
+    NSError *error;
+
+    id<PLDatabase> writer = [_provider getWriteConnectionAndReturnError: &error];
+    STAssertNotNil(writer, @"Failed to fetch connection: %@", error);
+    STAssertTrue([writer executeUpdate: @"CREATE TABLE test (a integer)"], @"Create table failed");
+    STAssertTrue([writer executeUpdate: @"INSERT INTO test (a) VALUES (1)"], @"Insert failed");
+
+    id<PLDatabase> reader = [_provider getReadConnectionAndReturnError: &error];
+    STAssertNotNil(reader, @"Failed to fetch connection: %@", error);
+    STAssertTrue(reader != writer, @"Writer connection was returned as a reader");
+
+    /* Readers see committed writes, but may not write */
+    id<PLResultSet> rs = [reader executeQuery: @"SELECT COUNT(*) FROM test"];
+    STAssertTrue([rs next], @"No count returned");
+    STAssertEquals(1, [rs intForColumnIndex: 0], @"Reader did not see the committed write");
+    [rs close];
+
+    STAssertFalse([reader executeUpdate: @"INSERT INTO test (a) VALUES (2)"], @"Read-only connection accepted a write");
+
+    [_provider closeConnection: reader];
+    [_provider closeConnection: writer];
+}
+
+/* Readers must not block on an open write transaction */
+- (void) testReadDuringWrite {
+    NSError *error;
+
+    id<PLDatabase> writer = [_provider getWriteConnectionAndReturnError: &error];
+    STAssertTrue([writer executeUpdate: @"CREATE TABLE test (a integer)"], @"Create table failed");
+    STAssertTrue([writer executeUpdate: @"BEGIN IMMEDIATE"], @"Could not begin a write transaction");
+    STAssertTrue([writer executeUpdate: @"INSERT INTO test (a) VALUES (1)"], @"Insert failed");
+
+    id<PLDatabase> reader = [_provider getReadConnectionAndReturnError: &error];
+    STAssertNotNil(reader, @"Failed to fetch connection: %@", error);
+
+    id<PLResultSet> rs = [reader executeQueryAndReturnError: &error statement: @"SELECT COUNT(*) FROM test"];
+    STAssertNotNil(rs, @"Query failed during a write transaction: %@", error);
+    STAssertEquals(PLResultSetStatusRow, [rs nextAndReturnError: &error], @"Read failed during a write transaction: %@", error);
+    STAssertEquals(0, [rs intForColumnIndex: 0], @"Reader saw an uncommitted write");
+    [rs close];
+
+    STAssertTrue([writer executeUpdate: @"COMMIT"], @"Commit failed");
+
+    [_provider closeConnection: reader];
+    [_provider closeConnection: writer];
+}
+
+/* Connections must be returned to the pool from which they were acquired */
+- (void) testPooling {
+    NSError *error;
+
+    id<PLDatabase> reader = [_provider getReadConnectionAndReturnError: &error];
+    id<PLDatabase> writer = [_provider getWriteConnectionAndReturnError: &error];
+    STAssertNotNil(reader, @"Failed to fetch connection: %@", error);
+    STAssertNotNil(writer, @"Failed to fetch connection: %@", error);
+
+    [_provider closeConnection: reader];
+    [_provider closeConnection: writer];
+    STAssertTrue([reader goodConnection], @"Reader was closed rather than cached");
+    STAssertTrue([writer goodConnection], @"Writer was closed rather than cached");
+
+    STAssertEquals(reader, [_provider getReadConnectionAndReturnError: &error], @"Did not return the cached reader");
+    STAssertEquals(writer, [_provider getWriteConnectionAndReturnError: &error], @"Did not return the cached writer");
+}
+
+/* In-memory databases can't be shared between connections, and don't support WAL */
+- (void) testInMemoryDatabase {
+    PLSqliteReadWriteConnectionProvider *provider = [[[PLSqliteReadWriteConnectionProvider alloc] initWithPath: @":memory:" readerCapacity: 1] autorelease];
+    NSError *error = nil;
+
+    STAssertNil([provider getReadConnectionAndReturnError: &error], @"Returned a reader for an in-memory database");
+    STAssertNotNil(error, @"No error was provided");
+}
+
+@end
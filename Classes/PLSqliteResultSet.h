@@ -33,6 +33,8 @@
 #import <sqlite3.h>
 
 #import "PLResultSet.h"
+#import "PLSqliteResultSetFastAccess.h"
+#import "PLSqliteColumnNameIndex.h"
 
 @class PLSqlitePreparedStatement;
 
@@ -47,8 +49,17 @@
     /** The number of columns in the result. */
     uint32_t _columnCount;
 
-    /** Cache of column name to column index. This value is lazy initialized and may be NULL. */
-    NSDictionary *_columnNames;
+    /** The prepared statement's column name index (borrowed reference). This value is lazy initialized and may be nil. */
+    PLSqliteColumnNameIndex *_columnNameIndex;
+
+    /** The row mapping most recently passed to decodeRowsWithMapping:, or nil. */
+    PLRowMapping *_rowMapping;
+
+    /** The resolved column indexes of _rowMapping's fields, or NULL. */
+    int *_rowMappingColumns;
+
+    /** The minimum row stride required by _rowMapping's fields. */
+    size_t _rowMappingExtent;
 }
 
 - (id) initWithPreparedStatement: (PLSqlitePreparedStatement *) stmt sqliteStatemet: (sqlite3_stmt *)sqlite_stmt;
@@ -56,6 +67,8 @@
 /** Return YES if the result set has been closed, NO otherwise. Exposed to support the PLResultSet unit tests. */
 @property(nonatomic, readonly, getter=isClosed) BOOL closed;
 
+- (void) getFastAccess: (PLSqliteResultSetFastAccess *) access requiredColumnCount: (int) requiredColumnCount;
+
 @end
 
 #import "PLSqlitePreparedStatement.h"
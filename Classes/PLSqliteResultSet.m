@@ -72,10 +72,10 @@
     /* 'Check in' our prepared statement reference */
     [self close];
 
-    /* Release the column cache. */
-    if (_columnNames != NULL)
-        [_columnNames release];
-    
+    /* Release the compiled row mapping */
+    [_rowMapping release];
+    free(_rowMappingColumns);
+
     /* Release the statement. */
     [_stmt release];
     
@@ -121,11 +121,12 @@
     return NO;
 }
 
-- (PLResultSetStatus) nextAndReturnError: (NSError **) error {
-    [self assertNotClosed];
-    
-    int ret = pl_sqlite3_blocking_step(_sqlite_stmt);
-    
+/**
+ * @internal
+ * Map the result of stepping our statement to a PLResultSetStatus, updating the database's deadlock status and
+ * populating @a error if the step failed.
+ */
+- (PLResultSetStatus) statusForStepResult: (int) ret error: (NSError **) error {
     /* Inform the database of deadlock status */
     if (ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
         [_stmt.database setTxBusy];
@@ -141,13 +142,17 @@
     if (ret == SQLITE_ROW)
         return PLResultSetStatusRow;
 
-
-
     /* An error has occured */
     [_stmt populateError: error withErrorCode: PLDatabaseErrorQueryFailed description: NSLocalizedString(@"Could not retrieve the next result row", @"Generic result row error")];
     return PLResultSetStatusError;
 }
 
+- (PLResultSetStatus) nextAndReturnError: (NSError **) error {
+    [self assertNotClosed];
+    
+    return [self statusForStepResult: pl_sqlite3_blocking_step(_sqlite_stmt) error: error];
+}
+
 /* From PLResultSet */
 - (BOOL) enumerateWithBlock: (void (^)(id<PLResultSet> rs, BOOL *stop)) block {
     return [self enumerateAndReturnError: NULL block: block];
@@ -183,30 +188,72 @@
 
 
 /* From PLResultSet */
-- (int) columnIndexForName: (NSString *) name {
-    [self assertNotClosed];
-    
-    /* Lazy initialization of the column name mapping. Profiling demonstrates that iPhone code doing a high
-     * volume of queries avoids a significant performance penalty if the column name mapping is not used. */
-    if (_columnNames == nil) {
-        /* Create a column name cache */
-        NSMutableDictionary *columnNames = [[NSMutableDictionary alloc] initWithCapacity: _columnCount];
-        _columnNames = columnNames;
-
-        for (int columnIndex = 0; columnIndex < _columnCount; columnIndex++) {
-            /* Fetch the name */
-            NSString *name = [NSString stringWithUTF8String: sqlite3_column_name(_sqlite_stmt, columnIndex)];
-            
-            /* Set the dictionary value */
-            [columnNames setObject: [NSNumber numberWithInt: columnIndex] forKey: [name lowercaseString]];
-        }
+- (BOOL) enumerateBatchesOfSize: (NSUInteger) batchSize
+                        mapping: (PLRowMapping *) mapping
+                         stride: (size_t) stride
+                          error: (NSError **) outError
+                          block: (void (^)(const void *rows, NSUInteger count, BOOL *stop)) block
+{
+    if (batchSize == 0)
+        [NSException raise: PLSqliteException format: @"Batch size must be greater than zero"];
+
+    if (stride == 0)
+        [NSException raise: PLSqliteException format: @"Row stride must be greater than zero"];
+
+    if (batchSize > SIZE_MAX / stride)
+        [NSException raise: PLSqliteException format: @"Batch of %lu rows of %lu bytes overflows the address space",
+            (unsigned long) batchSize, (unsigned long) stride];
+
+    BOOL stop = NO;
+    PLResultSetStatus rss;
+    void *rows = malloc(batchSize * stride);
+    if (rows == NULL)
+        [NSException raise: NSMallocException format: @"Could not allocate a batch of %lu rows of %lu bytes",
+            (unsigned long) batchSize, (unsigned long) stride];
+
+    /* Decode and deliver each batch. The next batch is not fetched until the consumer has returned. */
+    @try {
+        do {
+            NSUInteger count = 0;
+            rss = [self decodeRowsWithMapping: mapping into: rows stride: stride maxRows: batchSize rowsDecoded: &count error: outError];
+
+            /* Deliver any rows decoded prior to completion; rows decoded prior to an error are discarded. */
+            if (count > 0 && rss != PLResultSetStatusError)
+                block(rows, count, &stop);
+        } while (rss == PLResultSetStatusRow && !stop);
+    } @finally {
+        free(rows);
     }
 
-    NSString *key = [name lowercaseString];
-    NSNumber *idx = [_columnNames objectForKey: key];
-    if (idx != nil) {
-        return [idx intValue];
+    /* Handle completion invariant; the result set is expected to implicitly close when
+     * all rows are iterated and *stop is not set. */
+    if (stop == NO && rss == PLResultSetStatusDone) {
+        [self close];
     }
+
+    /* Handle error completion invariant. If an error occurs, the result set is expected
+     * to implicitly close */
+    if (rss == PLResultSetStatusError) {
+        [self close];
+        return NO;
+    }
+
+    return YES;
+}
+
+
+/* From PLResultSet */
+- (int) columnIndexForName: (NSString *) name {
+    [self assertNotClosed];
+    
+    /* The column name index is built once per prepared query, and shared by all of its result sets. The index
+     * is retained by our prepared statement. */
+    if (_columnNameIndex == nil)
+        _columnNameIndex = [_stmt columnNameIndex];
+
+    int columnIndex = [_columnNameIndex indexOfColumnName: name statement: _sqlite_stmt];
+    if (columnIndex >= 0)
+        return columnIndex;
     
     /* Not found */
     [NSException raise: PLSqliteException format: @"Attempted to access unknown result column %@", name];
@@ -238,7 +285,6 @@
 /* This beauty generates the PLResultSet value accessors for a given data type */
 #define VALUE_ACCESSORS(ReturnType, MethodName, Expression) \
     - (ReturnType) MethodName ## ForColumnIndex: (int) columnIndex { \
-        [self assertNotClosed]; \
         int columnType = [self validateColumnIndex: columnIndex]; \
         \
         /* Quiesce unused variable warning */ \
@@ -279,11 +325,41 @@ VALUE_ACCESSORS(NSData *, data, columnType == SQLITE_NULL ? nil :
                     [NSData dataWithBytes: sqlite3_column_blob(_sqlite_stmt, columnIndex)
                                    length: sqlite3_column_bytes(_sqlite_stmt, columnIndex)])
 
+/* borrowed string */
+VALUE_ACCESSORS(NSString *, borrowedString, columnType == SQLITE_NULL ? nil :
+                    [[[NSString alloc] initWithBytesNoCopy: (void *) sqlite3_column_text(_sqlite_stmt, columnIndex)
+                                                    length: sqlite3_column_bytes(_sqlite_stmt, columnIndex)
+                                                  encoding: NSUTF8StringEncoding
+                                              freeWhenDone: NO] autorelease])
+
+/* borrowed data */
+VALUE_ACCESSORS(NSData *, borrowedData, columnType == SQLITE_NULL ? nil :
+                    [NSData dataWithBytesNoCopy: (void *) sqlite3_column_blob(_sqlite_stmt, columnIndex)
+                                         length: sqlite3_column_bytes(_sqlite_stmt, columnIndex)
+                                   freeWhenDone: NO])
 
 /* From PLResultSet */
-- (id) objectForColumnIndex: (int) columnIndex {
-    [self assertNotClosed];
+- (const char *) UTF8StringForColumnIndex: (int) columnIndex length: (size_t *) length {
+    int columnType = [self validateColumnIndex: columnIndex];
+
+    if (columnType == SQLITE_NULL) {
+        if (length != NULL)
+            *length = 0;
+        return NULL;
+    }
+
+    /* sqlite3_column_text() must be called prior to sqlite3_column_bytes(), or the length may
+     * reflect a different encoding. */
+    const char *text = (const char *) sqlite3_column_text(_sqlite_stmt, columnIndex);
+    if (length != NULL)
+        *length = (size_t) sqlite3_column_bytes(_sqlite_stmt, columnIndex);
 
+    return text;
+}
+
+
+/* From PLResultSet */
+- (id) objectForColumnIndex: (int) columnIndex {
     int columnType = [self validateColumnIndex: columnIndex];
     switch (columnType) {
         case SQLITE_TEXT:
@@ -328,8 +404,6 @@ VALUE_ACCESSORS(NSData *, data, columnType == SQLITE_NULL ? nil :
 
 /* from PLResultSet */
 - (BOOL) isNullForColumnIndex: (int) columnIndex {
-    [self assertNotClosed];
-
     int columnType = [self validateColumnIndex: columnIndex];
     
     /* If the column has a null value, return YES. */
@@ -345,4 +419,223 @@ VALUE_ACCESSORS(NSData *, data, columnType == SQLITE_NULL ? nil :
     return [self isNullForColumnIndex: [self columnIndexForName: columnName]];
 }
 
+/* from PLResultSet */
+- (PLResultSetStatus) fetchColumns: (const int *) columnIndexes
+                       intoBuffers: (PLResultSetColumnBuffer *) buffers
+                       columnCount: (int) columnCount
+                           maxRows: (NSUInteger) maxRows
+                       rowsFetched: (NSUInteger *) rowsFetched
+                             error: (NSError **) outError
+{
+    [self assertNotClosed];
+
+    /* A zero row fetch would never make progress */
+    if (maxRows == 0)
+        [NSException raise: PLSqliteException format: @"Maximum row count must be greater than zero"];
+
+    /* Validate the columns once, rather than per value */
+    for (int i = 0; i < columnCount; i++) {
+        if (columnIndexes[i] > (int) _columnCount - 1 || columnIndexes[i] < 0)
+            [NSException raise: PLSqliteException format: @"Attempted to access out-of-range column index %d", columnIndexes[i]];
+
+        if (buffers[i].type != PLResultSetColumnBufferTypeInt64 && buffers[i].type != PLResultSetColumnBufferTypeDouble)
+            [NSException raise: PLSqliteException format: @"Unsupported column buffer type %d", buffers[i].type];
+    }
+
+    NSUInteger row = 0;
+    int ret = SQLITE_ROW;
+    while (row < maxRows && (ret = pl_sqlite3_blocking_step(_sqlite_stmt)) == SQLITE_ROW) {
+        for (int i = 0; i < columnCount; i++) {
+            int columnIndex = columnIndexes[i];
+            PLResultSetColumnBuffer *buffer = &buffers[i];
+
+            if (buffer->type == PLResultSetColumnBufferTypeInt64)
+                ((int64_t *) buffer->values)[row] = sqlite3_column_int64(_sqlite_stmt, columnIndex);
+            else
+                ((double *) buffer->values)[row] = sqlite3_column_double(_sqlite_stmt, columnIndex);
+
+            if (buffer->nulls != NULL) {
+                uint8_t mask = (uint8_t) (1 << (row % 8));
+                if (sqlite3_column_type(_sqlite_stmt, columnIndex) == SQLITE_NULL)
+                    buffer->nulls[row / 8] |= mask;
+                else
+                    buffer->nulls[row / 8] &= ~mask;
+            }
+        }
+
+        row++;
+    }
+
+    if (rowsFetched != NULL)
+        *rowsFetched = row;
+
+    /* If the buffers were filled, more rows may be available */
+    return [self statusForStepResult: ret error: outError];
+}
+
+/* from PLResultSet */
+- (PLResultSetStatus) decodeRowsWithMapping: (PLRowMapping *) mapping
+                                       into: (void *) rows
+                                     stride: (size_t) stride
+                                    maxRows: (NSUInteger) maxRows
+                                rowsDecoded: (NSUInteger *) rowsDecoded
+                                      error: (NSError **) outError
+{
+    [self assertNotClosed];
+
+    /* A zero row decode would never make progress */
+    if (maxRows == 0)
+        [NSException raise: PLSqliteException format: @"Maximum row count must be greater than zero"];
+
+    const PLRowMappingField *fields = mapping.fields;
+    NSUInteger fieldCount = mapping.fieldCount;
+
+    /* Resolve the mapping's column names and row extent once per result set */
+    if (mapping != _rowMapping) {
+        size_t extent = 0;
+        for (NSUInteger i = 0; i < fieldCount; i++) {
+            const PLRowMappingField *field = &fields[i];
+            size_t size = 0;
+
+            switch (field->type) {
+                case PLRowMappingFieldTypeBool:
+                case PLRowMappingFieldTypeIsNull:
+                    size = sizeof(BOOL);
+                    break;
+                case PLRowMappingFieldTypeInt32:
+                    size = sizeof(int32_t);
+                    break;
+                case PLRowMappingFieldTypeInt64:
+                    size = sizeof(int64_t);
+                    break;
+                case PLRowMappingFieldTypeFloat:
+                    size = sizeof(float);
+                    break;
+                case PLRowMappingFieldTypeDouble:
+                    size = sizeof(double);
+                    break;
+                case PLRowMappingFieldTypeUTF8Buffer:
+                    if (field->size == 0)
+                        [NSException raise: PLSqliteException format: @"UTF-8 buffer field %lu of the row mapping has a zero size", (unsigned long) i];
+                    size = field->size;
+                    break;
+            }
+
+            if (field->offset > SIZE_MAX - size)
+                [NSException raise: PLSqliteException format: @"Field %lu of the row mapping overflows the row", (unsigned long) i];
+
+            if (field->offset + size > extent)
+                extent = field->offset + size;
+        }
+
+        int *columns = malloc(sizeof(int) * (fieldCount > 0 ? fieldCount : 1));
+        @try {
+            NSUInteger i = 0;
+            for (NSString *columnName in mapping.columnNames)
+                columns[i++] = [self columnIndexForName: columnName];
+        } @catch (id e) {
+            free(columns);
+            @throw;
+        }
+
+        free(_rowMappingColumns);
+        [_rowMapping release];
+
+        _rowMappingColumns = columns;
+        _rowMapping = [mapping retain];
+        _rowMappingExtent = extent;
+    }
+
+    /* Every field must lie within the row, or decoding would overwrite the following row */
+    if (stride < _rowMappingExtent)
+        [NSException raise: PLSqliteException format: @"Row stride of %lu bytes is smaller than the %lu bytes required by the row mapping",
+            (unsigned long) stride, (unsigned long) _rowMappingExtent];
+
+    NSUInteger row = 0;
+    int ret = SQLITE_ROW;
+    while (row < maxRows && (ret = pl_sqlite3_blocking_step(_sqlite_stmt)) == SQLITE_ROW) {
+        uint8_t *base = (uint8_t *) rows + (row * stride);
+
+        for (NSUInteger i = 0; i < fieldCount; i++) {
+            const PLRowMappingField *field = &fields[i];
+            int columnIndex = _rowMappingColumns[i];
+            void *dest = base + field->offset;
+
+            switch (field->type) {
+                case PLRowMappingFieldTypeBool:
+                    *(BOOL *) dest = sqlite3_column_int(_sqlite_stmt, columnIndex) != 0;
+                    break;
+
+                case PLRowMappingFieldTypeInt32:
+                    *(int32_t *) dest = sqlite3_column_int(_sqlite_stmt, columnIndex);
+                    break;
+
+                case PLRowMappingFieldTypeInt64:
+                    *(int64_t *) dest = sqlite3_column_int64(_sqlite_stmt, columnIndex);
+                    break;
+
+                case PLRowMappingFieldTypeFloat:
+                    *(float *) dest = (float) sqlite3_column_double(_sqlite_stmt, columnIndex);
+                    break;
+
+                case PLRowMappingFieldTypeDouble:
+                    *(double *) dest = sqlite3_column_double(_sqlite_stmt, columnIndex);
+                    break;
+
+                case PLRowMappingFieldTypeUTF8Buffer: {
+                    const unsigned char *text = sqlite3_column_text(_sqlite_stmt, columnIndex);
+                    size_t length = 0;
+                    if (text != NULL) {
+                        length = (size_t) sqlite3_column_bytes(_sqlite_stmt, columnIndex);
+                        if (length > field->size - 1) {
+                            /* Truncate, without splitting a multi-byte UTF-8 sequence */
+                            length = field->size - 1;
+                            while (length > 0 && (text[length] & 0xC0) == 0x80)
+                                length--;
+                        }
+                        memcpy(dest, text, length);
+                    }
+                    ((char *) dest)[length] = '\0';
+                    break;
+                }
+
+                case PLRowMappingFieldTypeIsNull:
+                    *(BOOL *) dest = sqlite3_column_type(_sqlite_stmt, columnIndex) == SQLITE_NULL;
+                    break;
+            }
+        }
+
+        row++;
+    }
+
+    if (rowsDecoded != NULL)
+        *rowsDecoded = row;
+
+    /* If the array was filled, more rows may be available */
+    return [self statusForStepResult: ret error: outError];
+}
+
+/**
+ * @internal
+ * Populate @a access for unchecked access to the first @a requiredColumnCount columns.
+ */
+- (void) getFastAccess: (PLSqliteResultSetFastAccess *) access requiredColumnCount: (int) requiredColumnCount {
+    [self assertNotClosed];
+
+    if (requiredColumnCount > (int) _columnCount || requiredColumnCount < 0)
+        [NSException raise: PLSqliteException format: @"Attempted to access out-of-range column index %d", requiredColumnCount - 1];
+
+    access->stmt = _sqlite_stmt;
+    access->columnCount = _columnCount;
+}
+
 @end
+
+/* From PLSqliteResultSetFastAccess.h */
+void PLSqliteResultSetFastAccessInit (PLSqliteResultSetFastAccess *access, id<PLResultSet> resultSet, int requiredColumnCount) {
+    if (![(id) resultSet isKindOfClass: [PLSqliteResultSet class]])
+        [NSException raise: PLSqliteException format: @"Fast access is not supported by result set %@", resultSet];
+
+    [(PLSqliteResultSet *) resultSet getFastAccess: access requiredColumnCount: requiredColumnCount];
+}
+
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <sqlite3.h>
+
+#import "PLResultSet.h"
+
+/**
+ * Unchecked, inline column accessors for SQLite result sets.
+ *
+ * The PLResultSet accessors validate the result set state and the column index on every call, and are dispatched
+ * via Objective-C message sends. For tight loops over large result sets, a PLSqliteResultSetFastAccess may be
+ * initialized once per result set with PLSqliteResultSetFastAccessInit(); the PLSqliteFastAccess* functions then
+ * read values directly from the current row with no further validation:
+ *
+ * @code
+ * id<PLResultSet> rs = [db executeQuery: @"SELECT id, price FROM example"];
+ *
+ * PLSqliteResultSetFastAccess fa;
+ * PLSqliteResultSetFastAccessInit(&fa, rs, 2);
+ *
+ * while ([rs nextAndReturnError: &error] == PLResultSetStatusRow)
+ *     total += PLSqliteFastAccessDouble(&fa, 1);
+ *
+ * [rs close];
+ * @endcode
+ *
+ * @warning The accessors perform no validation. Reading a column index outside of the column count validated by
+ * PLSqliteResultSetFastAccessInit(), reading before the first row has been fetched, or reading after the result set
+ * has been closed results in undefined behavior.
+ */
+typedef struct PLSqliteResultSetFastAccess {
+    /** The result set's SQLite statement. Borrowed; valid until the result set is closed. */
+    sqlite3_stmt *stmt;
+
+    /** The number of columns in the result set. */
+    int columnCount;
+} PLSqliteResultSetFastAccess;
+
+/**
+ * Initialize @a access for unchecked access to the columns of @a resultSet.
+ *
+ * Will throw NSException if @a resultSet is not a SQLite result set, if it has been closed, or if it has fewer than
+ * @a requiredColumnCount columns. Columns with indexes less than @a requiredColumnCount may then be read via the
+ * PLSqliteFastAccess* functions until the result set is closed.
+ *
+ * @param access The fast access state to initialize.
+ * @param resultSet An open result set vended by PLSqliteDatabase.
+ * @param requiredColumnCount The number of leading columns that will be accessed.
+ */
+void PLSqliteResultSetFastAccessInit (PLSqliteResultSetFastAccess *access, id<PLResultSet> resultSet, int requiredColumnCount);
+
+/** Return YES if the value of @a columnIndex in the current row is NULL. */
+static inline BOOL PLSqliteFastAccessIsNull (const PLSqliteResultSetFastAccess *access, int columnIndex) {
+    return sqlite3_column_type(access->stmt, columnIndex) == SQLITE_NULL;
+}
+
+/** Return the boolean value of @a columnIndex in the current row. NULL values are returned as NO. */
+static inline BOOL PLSqliteFastAccessBool (const PLSqliteResultSetFastAccess *access, int columnIndex) {
+    return sqlite3_column_int(access->stmt, columnIndex) != 0;
+}
+
+/** Return the 32 bit integer value of @a columnIndex in the current row. NULL values are returned as 0. */
+static inline int32_t PLSqliteFastAccessInt (const PLSqliteResultSetFastAccess *access, int columnIndex) {
+    return sqlite3_column_int(access->stmt, columnIndex);
+}
+
+/** Return the 64 bit integer value of @a columnIndex in the current row. NULL values are returned as 0. */
+static inline int64_t PLSqliteFastAccessBigInt (const PLSqliteResultSetFastAccess *access, int columnIndex) {
+    return sqlite3_column_int64(access->stmt, columnIndex);
+}
+
+/** Return the double value of @a columnIndex in the current row. NULL values are returned as 0.0. */
+static inline double PLSqliteFastAccessDouble (const PLSqliteResultSetFastAccess *access, int columnIndex) {
+    return sqlite3_column_double(access->stmt, columnIndex);
+}
+
+/**
+ * Return a borrowed pointer to the NUL terminated UTF-8 text value of @a columnIndex in the current row, or NULL
+ * if the value is NULL. The bytes remain valid until the result set is advanced or closed.
+ *
+ * @param access Fast access state.
+ * @param columnIndex Column index.
+ * @param length If non-NULL, on return will contain the length of the value in bytes, excluding the NUL terminator.
+ */
+static inline const char *PLSqliteFastAccessUTF8String (const PLSqliteResultSetFastAccess *access, int columnIndex, size_t *length) {
+    const char *text = (const char *) sqlite3_column_text(access->stmt, columnIndex);
+    if (length != NULL)
+        *length = (size_t) sqlite3_column_bytes(access->stmt, columnIndex);
+    return text;
+}
+
+/**
+ * Return a borrowed pointer to the BLOB value of @a columnIndex in the current row. NULL is returned for NULL and
+ * zero-length values. The bytes remain valid until the result set is advanced or closed.
+ *
+ * @param access Fast access state.
+ * @param columnIndex Column index.
+ * @param length If non-NULL, on return will contain the length of the value in bytes.
+ */
+static inline const void *PLSqliteFastAccessBlob (const PLSqliteResultSetFastAccess *access, int columnIndex, size_t *length) {
+    const void *blob = sqlite3_column_blob(access->stmt, columnIndex);
+    if (length != NULL)
+        *length = (size_t) sqlite3_column_bytes(access->stmt, columnIndex);
+    return blob;
+}
@@ -154,10 +154,41 @@
     STAssertEquals(0, [result columnIndexForName: @"USER_VERSION"], @"Column index lookup appears to be case sensitive.");
 
     STAssertThrows([result columnIndexForName: @"not_a_column"], @"Did not throw an exception for bad column");
+    STAssertThrows([result columnIndexForName: nil], @"Did not throw an exception for nil column");
 
     [result close];
 }
 
+/* The column name index is shared across executions of a cached query, and must survive schema changes */
+- (void) testColumnIndexForNameReused {
+    id<PLResultSet> result;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer, b integer)"], @"Create table failed");
+
+    for (int i = 0; i < 2; i++) {
+        result = [_db executeQuery: @"SELECT * FROM test"];
+        STAssertEquals(1, [result columnIndexForName: @"b"], @"Incorrect column index");
+        STAssertEquals(1, [result columnIndexForName: @"B"], @"Column index lookup appears to be case sensitive.");
+        STAssertThrows([result columnIndexForName: @"c"], @"Did not throw an exception for bad column");
+        [result close];
+    }
+
+    /* Alter the table; the cached statement will be re-prepared by SQLite with an additional column */
+    STAssertTrue([_db executeUpdate: @"ALTER TABLE test ADD COLUMN c integer"], @"Alter table failed");
+
+    result = [_db executeQuery: @"SELECT * FROM test"];
+    STAssertEquals(2, [result columnIndexForName: @"C"], @"Column added by schema change was not found");
+    [result close];
+}
+
+/* Duplicate column names resolve to the last such column */
+- (void) testColumnIndexForNameDuplicates {
+    id<PLResultSet> result = [_db executeQuery: @"SELECT 1 AS a, 2 AS A, 3 AS b"];
+    STAssertEquals(1, [result columnIndexForName: @"a"], @"Incorrect column index for duplicate name");
+    STAssertEquals(2, [result columnIndexForName: @"b"], @"Incorrect column index");
+    [result close];
+}
+
 - (void) testDateForColumn {
     id<PLResultSet> result;
     NSDate *now = [NSDate date];
@@ -262,6 +293,185 @@
     [result close];
 }
 
+typedef struct PLSqliteResultSetTestRow {
+    int32_t a;
+    double b;
+    char c[6];
+    BOOL cIsNull;
+} PLSqliteResultSetTestRow;
+
+- (void) testDecodeRows {
+    PLRowMappingField fields[] = {
+        { "A", PLRowMappingFieldTypeInt32, offsetof(PLSqliteResultSetTestRow, a), 0 },
+        { "b", PLRowMappingFieldTypeDouble, offsetof(PLSqliteResultSetTestRow, b), 0 },
+        { "c", PLRowMappingFieldTypeUTF8Buffer, offsetof(PLSqliteResultSetTestRow, c), sizeof(((PLSqliteResultSetTestRow *) 0)->c) },
+        { "c", PLRowMappingFieldTypeIsNull, offsetof(PLSqliteResultSetTestRow, cIsNull), 0 }
+    };
+    PLRowMapping *mapping = [PLRowMapping mappingWithFields: fields count: 4];
+    PLSqliteResultSetTestRow rows[2];
+    id<PLResultSet> result;
+    NSError *error;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer, b double, c varchar(20))"], @"Create table failed");
+    STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a, b, c) VALUES (?, ?, ?)", [NSNumber numberWithInt: 1], [NSNumber numberWithDouble: 1.5], @"abc"]), @"Could not insert row");
+    STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a, b, c) VALUES (?, ?, ?)", [NSNumber numberWithInt: 2], [NSNumber numberWithDouble: 2.5], nil]), @"Could not insert row");
+    STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a, b, c) VALUES (?, ?, ?)", [NSNumber numberWithInt: 3], [NSNumber numberWithDouble: 3.5], @"truncated"]), @"Could not insert row");
+
+    result = [_db executeQuery: @"SELECT a, b, c FROM test ORDER BY a"];
+
+    /* The first two rows */
+    NSUInteger count;
+    STAssertEquals(PLResultSetStatusRow, [result decodeRowsWithMapping: mapping into: rows stride: sizeof(rows[0]) maxRows: 2 rowsDecoded: &count error: &error], @"Decode failed: %@", error);
+    STAssertEquals((NSUInteger) 2, count, @"Incorrect number of rows decoded");
+
+    STAssertEquals(1, rows[0].a, @"Incorrect integer value");
+    STAssertEquals(1.5, rows[0].b, @"Incorrect double value");
+    STAssertTrue(strcmp("abc", rows[0].c) == 0, @"Incorrect string value");
+    STAssertFalse(rows[0].cIsNull, @"Value should not be NULL");
+
+    STAssertEquals(2, rows[1].a, @"Incorrect integer value");
+    STAssertTrue(strcmp("", rows[1].c) == 0, @"NULL string should be decoded as the empty string");
+    STAssertTrue(rows[1].cIsNull, @"Value should be NULL");
+
+    /* The final row; the string value is truncated to fit */
+    STAssertEquals(PLResultSetStatusDone, [result decodeRowsWithMapping: mapping into: rows stride: sizeof(rows[0]) maxRows: 2 rowsDecoded: &count error: &error], @"Decode failed: %@", error);
+    STAssertEquals((NSUInteger) 1, count, @"Incorrect number of rows decoded");
+    STAssertEquals(3, rows[0].a, @"Incorrect integer value");
+    STAssertTrue(strcmp("trunc", rows[0].c) == 0, @"String value was not truncated");
+
+    [result close];
+
+    /* Unknown columns must be rejected */
+    PLRowMappingField badFields[] = {
+        { "d", PLRowMappingFieldTypeInt32, 0, 0 }
+    };
+    result = [_db executeQuery: @"SELECT a, b, c FROM test"];
+    STAssertThrows([result decodeRowsWithMapping: [PLRowMapping mappingWithFields: badFields count: 1] into: rows stride: sizeof(rows[0]) maxRows: 2 rowsDecoded: &count error: NULL], @"Did not throw an exception for bad column");
+
+    /* Fields that extend past the row stride must be rejected */
+    STAssertThrows([result decodeRowsWithMapping: mapping into: rows stride: offsetof(PLSqliteResultSetTestRow, c) maxRows: 2 rowsDecoded: &count error: NULL], @"Did not throw an exception for a short stride");
+
+    /* A zero row decode must be rejected */
+    STAssertThrows([result decodeRowsWithMapping: mapping into: rows stride: sizeof(rows[0]) maxRows: 0 rowsDecoded: &count error: NULL], @"Did not throw an exception for zero maxRows");
+    [result close];
+}
+
+- (void) testEnumerateBatches {
+    PLRowMappingField fields[] = {
+        { "a", PLRowMappingFieldTypeInt64, 0, 0 }
+    };
+    PLRowMapping *mapping = [PLRowMapping mappingWithFields: fields count: 1];
+    id<PLResultSet> result;
+    NSError *error;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer)"], @"Create table failed");
+    for (int i = 0; i < 10; i++)
+        STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a) VALUES (?)", [NSNumber numberWithInt: i]]), @"Could not insert row");
+
+    /* Enumerate all batches */
+    __block int64_t expected = 0;
+    __block int batches = 0;
+    result = [_db executeQuery: @"SELECT a FROM test ORDER BY a"];
+    BOOL success = [result enumerateBatchesOfSize: 4 mapping: mapping stride: sizeof(int64_t) error: &error block: ^(const void *rows, NSUInteger count, BOOL *stop) {
+        const int64_t *values = rows;
+        for (NSUInteger i = 0; i < count; i++)
+            STAssertEquals(expected++, values[i], @"Incorrect value");
+        batches++;
+    }];
+    STAssertTrue(success, @"Enumeration failed: %@", error);
+    STAssertEquals((int64_t) 10, expected, @"Incorrect number of rows enumerated");
+    STAssertEquals(3, batches, @"Incorrect number of batches");
+    STAssertTrue([(PLSqliteResultSet *) result isClosed], @"Result set was not closed on completion");
+
+    /* Stop after the first batch */
+    batches = 0;
+    result = [_db executeQuery: @"SELECT a FROM test ORDER BY a"];
+    success = [result enumerateBatchesOfSize: 4 mapping: mapping stride: sizeof(int64_t) error: &error block: ^(const void *rows, NSUInteger count, BOOL *stop) {
+        batches++;
+        *stop = YES;
+    }];
+    STAssertTrue(success, @"Enumeration failed: %@", error);
+    STAssertEquals(1, batches, @"Enumeration was not stopped");
+    STAssertFalse([(PLSqliteResultSet *) result isClosed], @"Result set was closed after stop");
+    [result close];
+
+    /* Invalid batch geometry must be rejected before allocating the batch buffer */
+    void (^ignore)(const void *, NSUInteger, BOOL *) = ^(const void *rows, NSUInteger count, BOOL *stop) {};
+    result = [_db executeQuery: @"SELECT a FROM test ORDER BY a"];
+    STAssertThrows([result enumerateBatchesOfSize: 4 mapping: mapping stride: 0 error: NULL block: ignore], @"Did not throw an exception for a zero stride");
+    STAssertThrows([result enumerateBatchesOfSize: NSUIntegerMax mapping: mapping stride: sizeof(int64_t) error: NULL block: ignore], @"Did not throw an exception for an overflowing batch size");
+    [result close];
+}
+
+- (void) testBorrowedAccessors {
+    const char bytes[] = "This is some example test data";
+    NSData *data = [NSData dataWithBytes: bytes length: sizeof(bytes)];
+    NSString *string = @"Test string \u00e9";
+    id<PLResultSet> result;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a varchar(20), b blob, c integer)"], @"Create table failed");
+    STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a, b, c) VALUES (?, ?, ?)", string, data, nil]), @"Could not insert row");
+
+    result = [_db executeQuery: @"SELECT a, b, c FROM test"];
+    STAssertTrue([result next], @"No rows returned");
+
+    /* UTF-8 */
+    size_t length;
+    const char *utf8 = [result UTF8StringForColumnIndex: 0 length: &length];
+    STAssertTrue(utf8 != NULL, @"No UTF-8 value returned");
+    STAssertEquals(strlen([string UTF8String]), length, @"Incorrect UTF-8 length");
+    STAssertTrue(memcmp(utf8, [string UTF8String], length) == 0, @"Incorrect UTF-8 value");
+    STAssertTrue([result UTF8StringForColumnIndex: 2 length: &length] == NULL, @"Expected NULL value");
+    STAssertEquals((size_t) 0, length, @"Expected zero length for NULL value");
+
+    /* Objects */
+    STAssertEqualObjects(string, [result borrowedStringForColumn: @"a"], @"Did not return correct string value");
+    STAssertTrue([data isEqualToData: [result borrowedDataForColumn: @"b"]], @"Did not return correct data value");
+    STAssertNil([result borrowedStringForColumnIndex: 2], @"Expected nil value");
+    STAssertNil([result borrowedDataForColumnIndex: 2], @"Expected nil value");
+
+    STAssertThrows([result UTF8StringForColumnIndex: 3 length: NULL], @"Did not throw an exception for bad column");
+
+    [result close];
+}
+
+- (void) testFastAccess {
+    PLSqliteResultSetFastAccess fa;
+    id<PLResultSet> result;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer, b double, c varchar(20), d blob, e integer)"], @"Create table failed");
+    STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a, b, c, d, e) VALUES (?, ?, ?, ?, ?)",
+                   [NSNumber numberWithLongLong: LLONG_MAX], [NSNumber numberWithDouble: 42.42], @"Test string",
+                   [NSData dataWithBytes: "blob" length: 4], nil]), @"Could not insert row");
+
+    result = [_db executeQuery: @"SELECT a, b, c, d, e FROM test"];
+
+    /* Validation occurs once, at initialization */
+    STAssertThrows(PLSqliteResultSetFastAccessInit(&fa, result, 6), @"Did not throw an exception for bad column count");
+    PLSqliteResultSetFastAccessInit(&fa, result, 5);
+    STAssertEquals(5, fa.columnCount, @"Incorrect column count");
+
+    STAssertTrue([result next], @"No rows returned");
+    STAssertEquals((int64_t) LLONG_MAX, PLSqliteFastAccessBigInt(&fa, 0), @"Incorrect integer value");
+    STAssertEquals(42.42, PLSqliteFastAccessDouble(&fa, 1), @"Incorrect double value");
+
+    size_t length;
+    const char *text = PLSqliteFastAccessUTF8String(&fa, 2, &length);
+    STAssertEquals((size_t) 11, length, @"Incorrect text length");
+    STAssertTrue(strcmp("Test string", text) == 0, @"Incorrect text value");
+
+    const void *blob = PLSqliteFastAccessBlob(&fa, 3, &length);
+    STAssertEquals((size_t) 4, length, @"Incorrect blob length");
+    STAssertTrue(memcmp("blob", blob, 4) == 0, @"Incorrect blob value");
+
+    STAssertTrue(PLSqliteFastAccessIsNull(&fa, 4), @"Column value should be NULL");
+    STAssertFalse(PLSqliteFastAccessIsNull(&fa, 0), @"Column value should not be NULL");
+    STAssertEquals(0, PLSqliteFastAccessInt(&fa, 4), @"NULL column should return 0");
+
+    [result close];
+    STAssertThrows(PLSqliteResultSetFastAccessInit(&fa, result, 1), @"Did not throw an exception for closed result set");
+}
+
 - (void) testIsNullForColumn {
     id<PLResultSet> result;
     
@@ -299,6 +509,62 @@
     [result close];
 }
 
+- (void) testFetchColumns {
+    id<PLResultSet> result;
+    NSError *error;
+
+    STAssertTrue([_db executeUpdate: @"CREATE TABLE test (a integer, b double)"], @"Create table failed");
+    for (int i = 0; i < 10; i++) {
+        NSNumber *b = (i % 3 == 0) ? nil : [NSNumber numberWithDouble: i * 0.5];
+        STAssertTrue(([_db executeUpdate: @"INSERT INTO test (a, b) VALUES (?, ?)", [NSNumber numberWithInt: i], b]), @"Could not insert row");
+    }
+
+    int64_t a[4];
+    double b[4];
+    uint8_t bNulls[1];
+    int columns[] = { 0, 1 };
+    PLResultSetColumnBuffer buffers[] = {
+        { PLResultSetColumnBufferTypeInt64, a, NULL },
+        { PLResultSetColumnBufferTypeDouble, b, bNulls }
+    };
+
+    result = [_db executeQuery: @"SELECT a, b FROM test ORDER BY a"];
+
+    /* Fetch in chunks of 4; the last chunk is short */
+    NSUInteger total = 0;
+    NSUInteger count;
+    PLResultSetStatus status;
+    do {
+        status = [result fetchColumns: columns intoBuffers: buffers columnCount: 2 maxRows: 4 rowsFetched: &count error: &error];
+        STAssertTrue(status != PLResultSetStatusError, @"Fetch failed: %@", error);
+
+        for (NSUInteger i = 0; i < count; i++) {
+            int64_t expected = total + i;
+            STAssertEquals(expected, a[i], @"Incorrect integer value");
+            if (expected % 3 == 0) {
+                STAssertTrue(PLResultSetColumnBufferIsNull(bNulls, i), @"Value should be NULL");
+                STAssertEquals(0.0, b[i], @"NULL value should be fetched as 0");
+            } else {
+                STAssertFalse(PLResultSetColumnBufferIsNull(bNulls, i), @"Value should not be NULL");
+                STAssertEquals(expected * 0.5, b[i], @"Incorrect double value");
+            }
+        }
+        total += count;
+    } while (status == PLResultSetStatusRow);
+
+    STAssertEquals(PLResultSetStatusDone, status, @"Result set was not exhausted");
+    STAssertEquals((NSUInteger) 10, total, @"Incorrect number of rows fetched");
+
+    /* Out-of-range columns must be rejected */
+    int badColumns[] = { 0, 2 };
+    STAssertThrows([result fetchColumns: badColumns intoBuffers: buffers columnCount: 2 maxRows: 4 rowsFetched: &count error: NULL], @"Did not throw an exception for bad column");
+
+    /* A zero row fetch must be rejected */
+    STAssertThrows([result fetchColumns: columns intoBuffers: buffers columnCount: 2 maxRows: 0 rowsFetched: &count error: NULL], @"Did not throw an exception for zero maxRows");
+
+    [result close];
+}
+
 /*
  * Test the object variants:
  * - objectForColumn and objectForKeyedSubscript
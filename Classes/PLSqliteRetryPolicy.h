@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@interface PLSqliteRetryPolicy : NSObject <NSCopying> {
+@private
+    /** Maximum number of attempts, including the first, or 0 if unlimited. */
+    NSUInteger _maxAttempts;
+
+    /** Delay before the first retry. */
+    NSTimeInterval _initialBackoff;
+
+    /** Maximum delay before any retry, or 0 if unlimited. */
+    NSTimeInterval _maxBackoff;
+
+    /** Factor by which the delay grows with each retry. */
+    double _backoffMultiplier;
+
+    /** Fraction of each delay that is randomized. */
+    double _jitter;
+
+    /** Maximum total time spent on a transaction, including retries, or 0 if unlimited. */
+    NSTimeInterval _timeBudget;
+}
+
++ (id) defaultPolicy;
++ (id) backoffPolicy;
+
+- (NSTimeInterval) backoffForRetry: (NSUInteger) retry;
+
+/** The maximum number of attempts, including the first, or 0 if unlimited. Defaults to 0. */
+@property(nonatomic, assign) NSUInteger maxAttempts;
+
+/** The delay before the first retry, in seconds. Defaults to 0 (retry immediately). */
+@property(nonatomic, assign) NSTimeInterval initialBackoff;
+
+/** The maximum delay before any retry, in seconds, or 0 if unlimited. Defaults to 0. */
+@property(nonatomic, assign) NSTimeInterval maxBackoff;
+
+/** The factor by which the delay grows with each retry. Defaults to 2.0. */
+@property(nonatomic, assign) double backoffMultiplier;
+
+/** The fraction of each delay, from 0.0 to 1.0, that is randomized to avoid synchronized retries. Defaults to 0.5. */
+@property(nonatomic, assign) double jitter;
+
+/** The maximum total time, in seconds, spent on a transaction including all retries, or 0 if unlimited.
+ * Defaults to 0. */
+@property(nonatomic, assign) NSTimeInterval timeBudget;
+
+@end
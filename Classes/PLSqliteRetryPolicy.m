@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteRetryPolicy.h"
+
+#import <math.h>
+#import <stdlib.h>
+
+/**
+ * Retry policy for PLSqliteDatabase transactions that fail due to lock contention (SQLITE_BUSY).
+ *
+ * A transaction is retried after a delay that starts at initialBackoff and is multiplied by backoffMultiplier with
+ * each retry, up to maxBackoff. A random fraction of up to @a jitter of each delay is subtracted, so that writers that
+ * collided do not retry in lock-step. Retries stop once maxAttempts attempts have been made, or once the next
+ * retry would exceed the time budget; the transaction then fails with #PLDatabaseErrorTimedOut.
+ *
+ * The default policy retries immediately and without limit, as PLSqliteDatabase always has. For contended writers,
+ * backoffPolicy is recommended.
+ *
+ * @par Thread Safety
+ * PLSqliteRetryPolicy instances implement no locking and must not be mutated while shared between threads.
+ */
+@implementation PLSqliteRetryPolicy
+
+@synthesize maxAttempts = _maxAttempts;
+@synthesize initialBackoff = _initialBackoff;
+@synthesize maxBackoff = _maxBackoff;
+@synthesize backoffMultiplier = _backoffMultiplier;
+@synthesize jitter = _jitter;
+@synthesize timeBudget = _timeBudget;
+
+/**
+ * Return a new policy that retries immediately, without limit.
+ */
++ (id) defaultPolicy {
+    return [[[self alloc] init] autorelease];
+}
+
+/**
+ * Return a new policy suited to contended writers: up to 10 attempts within 5 seconds, with exponential backoff
+ * from 1ms to 100ms and 50% jitter.
+ */
++ (id) backoffPolicy {
+    PLSqliteRetryPolicy *policy = [self defaultPolicy];
+    policy.maxAttempts = 10;
+    policy.initialBackoff = 0.001;
+    policy.maxBackoff = 0.1;
+    policy.timeBudget = 5.0;
+
+    return policy;
+}
+
+/**
+ * Initialize a new policy with the default values.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteRetryPolicy class.
+ */
+- (id) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _maxAttempts = 0;
+    _initialBackoff = 0;
+    _maxBackoff = 0;
+    _backoffMultiplier = 2.0;
+    _jitter = 0.5;
+    _timeBudget = 0;
+
+    return self;
+}
+
+/**
+ * Return the delay, in seconds, before the given retry.
+ *
+ * @param retry The retry number, starting at 1 for the first retry.
+ */
+- (NSTimeInterval) backoffForRetry: (NSUInteger) retry {
+    if (_initialBackoff <= 0 || retry == 0)
+        return 0;
+
+    NSTimeInterval delay = _initialBackoff * pow(_backoffMultiplier, (double) (retry - 1));
+    if (_maxBackoff > 0 && delay > _maxBackoff)
+        delay = _maxBackoff;
+
+    /* random() is thread-safe; the quality of its output is of no concern here */
+    double jitter = fmin(fmax(_jitter, 0.0), 1.0);
+    double r = (double) random() / (double) RAND_MAX;
+
+    return delay * (1.0 - jitter * r);
+}
+
+// from NSCopying protocol
+- (id) copyWithZone: (NSZone *) zone {
+    PLSqliteRetryPolicy *copy = [[[self class] allocWithZone: zone] init];
+
+    copy->_maxAttempts = _maxAttempts;
+    copy->_initialBackoff = _initialBackoff;
+    copy->_maxBackoff = _maxBackoff;
+    copy->_backoffMultiplier = _backoffMultiplier;
+    copy->_jitter = _jitter;
+    copy->_timeBudget = _timeBudget;
+
+    return copy;
+}
+
+@end
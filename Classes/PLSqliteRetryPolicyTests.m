@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PLSqliteRetryPolicy.h"
+
+@interface PLSqliteRetryPolicyTests : SenTestCase {
+@private
+}
+
+@end
+
+@implementation PLSqliteRetryPolicyTests
+
+- (void) testDefaults {
+    PLSqliteRetryPolicy *policy = [PLSqliteRetryPolicy defaultPolicy];
+
+    STAssertEquals((NSUInteger) 0, [policy maxAttempts], @"Default policy should not limit attempts");
+    STAssertEquals((NSTimeInterval) 0, [policy timeBudget], @"Default policy should not have a time budget");
+    STAssertEquals((NSTimeInterval) 0, [policy backoffForRetry: 1], @"Default policy should retry immediately");
+    STAssertEquals((NSTimeInterval) 0, [policy backoffForRetry: 10], @"Default policy should retry immediately");
+}
+
+- (void) testExponentialBackoff {
+    PLSqliteRetryPolicy *policy = [PLSqliteRetryPolicy defaultPolicy];
+    policy.initialBackoff = 0.001;
+    policy.maxBackoff = 0.004;
+    policy.jitter = 0;
+
+    STAssertEqualsWithAccuracy(0.001, [policy backoffForRetry: 1], 1e-9, @"Incorrect initial backoff");
+    STAssertEqualsWithAccuracy(0.002, [policy backoffForRetry: 2], 1e-9, @"Backoff did not grow");
+    STAssertEqualsWithAccuracy(0.004, [policy backoffForRetry: 3], 1e-9, @"Backoff did not grow");
+    STAssertEqualsWithAccuracy(0.004, [policy backoffForRetry: 10], 1e-9, @"Backoff exceeded the maximum");
+}
+
+- (void) testJitter {
+    PLSqliteRetryPolicy *policy = [PLSqliteRetryPolicy defaultPolicy];
+    policy.initialBackoff = 0.01;
+    policy.jitter = 0.5;
+
+    /* Jitter may only shorten the delay, by at most the jitter fraction */
+    for (int i = 0; i < 100; i++) {
+        NSTimeInterval delay = [policy backoffForRetry: 1];
+        STAssertTrue(delay >= 0.005 && delay <= 0.01, @"Jittered delay %f out of range", delay);
+    }
+}
+
+- (void) testCopy {
+    PLSqliteRetryPolicy *policy = [PLSqliteRetryPolicy backoffPolicy];
+    policy.backoffMultiplier = 3.0;
+    policy.jitter = 0.25;
+
+    PLSqliteRetryPolicy *copy = [[policy copy] autorelease];
+    STAssertEquals([policy maxAttempts], [copy maxAttempts], @"Max attempts not copied");
+    STAssertEquals([policy initialBackoff], [copy initialBackoff], @"Initial backoff not copied");
+    STAssertEquals([policy maxBackoff], [copy maxBackoff], @"Max backoff not copied");
+    STAssertEquals(3.0, [copy backoffMultiplier], @"Multiplier not copied");
+    STAssertEquals(0.25, [copy jitter], @"Jitter not copied");
+    STAssertEquals([policy timeBudget], [copy timeBudget], @"Time budget not copied");
+}
+
+@end
@@ -28,41 +28,133 @@
  */
 
 #import <Foundation/Foundation.h>
-#import <libkern/OSAtomic.h>
+#import <pthread.h>
+
+#import "PLSqliteDatabaseOptions.h"
 
 #ifndef PL_DB_PRIVATE
 @class PLSqliteStatementCache;
+@class PLSqliteStatementCacheEntry;
 #else
 
 #import <sqlite3.h>
 
+#import "PLSqliteColumnNameIndex.h"
+
+/** Fast slot value marking an evicted PLSqliteStatementCacheEntry. */
+#define PL_SQLITE_CACHE_ENTRY_EVICTED ((sqlite3_stmt *) 1)
+
+/**
+ * @internal
+ *
+ * A single statement cache entry, containing all available sqlite3_stmt instances for a given query string.
+ *
+ * Entries may be retained by the statements checked out for their query string, allowing the statement to be
+ * checked back in without a query string lookup. The entry's fast slot may be accessed without holding the owning
+ * cache's lock; all other state is guarded by the cache's lock, and must only be accessed by PLSqliteStatementCache.
+ */
+@interface PLSqliteStatementCacheEntry : NSObject {
+@public
+    /** The query string corresponding to this entry's statements. */
+    NSString *_query;
+
+    /** An available statement that may be checked out without acquiring the cache's lock, NULL if empty, or
+     * PL_SQLITE_CACHE_ENTRY_EVICTED if this entry has been evicted from its cache. Must only be modified atomically. */
+    sqlite3_stmt * volatile _fastSlot;
+
+    /** Non-zero if the entry has been used since it was last considered for eviction. May be set without
+     * holding the cache's lock. */
+    volatile int32_t _referenced;
+
+    /** Additional available sqlite3_stmt instances, ordered from least to most recently checked in. */
+    CFMutableArrayRef _statements;
+
+    /** The next more recently used entry, or nil (borrowed reference). */
+    PLSqliteStatementCacheEntry *_lruPrev;
+
+    /** The next less recently used entry, or nil (borrowed reference). */
+    PLSqliteStatementCacheEntry *_lruNext;
+
+    /** The lazily constructed column name index shared by all of this entry's statements, or nil. Must only be
+     * set atomically. */
+    PLSqliteColumnNameIndex * volatile _columnNameIndex;
+
+    /** The lazily constructed parameter name table shared by all of this entry's statements, or nil. Must only be
+     * set atomically. */
+    NSArray * volatile _parameterNames;
+}
+
+- (id) initWithQuery: (NSString *) query;
+
+- (BOOL) isEvicted;
+
+- (PLSqliteColumnNameIndex *) columnNameIndexForStatement: (sqlite3_stmt *) stmt;
+
+- (NSArray *) parameterNamesForStatement: (sqlite3_stmt *) stmt;
+
+@end
+
+NSArray *pl_sqlite3_parameter_names (sqlite3_stmt *stmt);
+
 @interface PLSqliteStatementCache : NSObject {
 @private
     /** Maximum size. */
     NSUInteger _capacity;
     
-    /** Current size. */
-    NSUInteger _size;
+    /** Current size. Must only be modified atomically. */
+    volatile NSUInteger _size;
+
+    /** Eviction policy applied when the cache exceeds its capacity. */
+    PLSqliteStatementCacheEvictionPolicy _evictionPolicy;
+
+    /** Maximum number of available statements per query, or 0 if unlimited. */
+    NSUInteger _maxStatementsPerQuery;
 
-    /** Maps the query string to a CFMutableArrayRef containing sqlite3_stmt instances. We claim ownership for these statements. */
+    /** If YES, statements may be checked in to an entry's fast slot without acquiring _lock. */
+    BOOL _fastPathEnabled;
+
+    /** Number of lock-free check-ins currently in progress. */
+    volatile int32_t _activeFastCheckins;
+
+    /** Non-zero while the cache is being closed; lock-free check-ins must not be started. */
+    volatile int32_t _closing;
+
+    /** Maps the query string to a PLSqliteStatementCacheEntry containing available sqlite3_stmt instances. We claim
+     * ownership for these statements. */
     NSMutableDictionary *_availableStatements;
+
+    /** Most recently used cache entry (borrowed reference), or nil if the cache is empty. */
+    PLSqliteStatementCacheEntry *_lruHead;
+
+    /** Least recently used cache entry (borrowed reference), or nil if the cache is empty. This is the next entry
+     * to be evicted. */
+    PLSqliteStatementCacheEntry *_lruTail;
     
     /** All live statements (whether or not they're checked out). */
     __strong CFMutableSetRef _allStatements;
 
-    /** Internal lock. Must be held when mutating state. */
-    OSSpinLock _lock;
+    /** Internal lock. Must be held when mutating state, other than the entries' fast slots. */
+    pthread_mutex_t _lock;
 }
 
 - (id) initWithCapacity: (NSUInteger) capacity;
 
+- (id) initWithCapacity: (NSUInteger) capacity
+         evictionPolicy: (PLSqliteStatementCacheEvictionPolicy) evictionPolicy
+  maxStatementsPerQuery: (NSUInteger) maxStatementsPerQuery;
+
 - (void) close;
 
 - (void) registerStatement: (sqlite3_stmt *) stmt;
 
 - (void) checkinStatement: (sqlite3_stmt *) stmt forQuery: (NSString *) query;
+- (void) checkinStatement: (sqlite3_stmt *) stmt forCacheEntry: (PLSqliteStatementCacheEntry *) entry;
 
 - (sqlite3_stmt *) checkoutStatementForQueryString: (NSString *) query;
+- (sqlite3_stmt *) checkoutStatementForQueryString: (NSString *) query cacheEntry: (PLSqliteStatementCacheEntry **) entry;
+- (sqlite3_stmt *) checkoutStatementForCacheEntry: (PLSqliteStatementCacheEntry *) entry;
+
+- (PLSqliteStatementCacheEntry *) cacheEntryForQueryString: (NSString *) query;
 
 - (void) removeAllStatements;
 
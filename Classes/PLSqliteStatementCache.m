@@ -29,6 +29,8 @@
 
 #import "PLSqliteStatementCache.h"
 
+#import <sched.h>
+
 static const CFArrayCallBacks StatementCacheArrayCallbacks = {
     .version = 0,
     .retain = NULL,
@@ -46,8 +48,169 @@ static const CFSetCallBacks StatementCacheSetCallbacks = {
     .hash = NULL
 };
 
+/* Atomically take the statement from @a entry's fast slot. Returns NULL if the slot is empty, or if the entry
+ * has been evicted. */
+static inline sqlite3_stmt *entry_take_fast_slot (PLSqliteStatementCacheEntry *entry) {
+    sqlite3_stmt *stmt;
+
+    do {
+        stmt = entry->_fastSlot;
+        if (stmt == NULL || stmt == PL_SQLITE_CACHE_ENTRY_EVICTED)
+            return NULL;
+    } while (!__sync_bool_compare_and_swap(&entry->_fastSlot, stmt, NULL));
+
+    return stmt;
+}
+
+/* Atomically place @a stmt in @a entry's fast slot. Returns false if the slot is occupied, or if the entry has
+ * been evicted. */
+static inline bool entry_put_fast_slot (PLSqliteStatementCacheEntry *entry, sqlite3_stmt *stmt) {
+    return __sync_bool_compare_and_swap(&entry->_fastSlot, NULL, stmt);
+}
+
+/* Atomically mark @a entry as evicted, returning the statement previously held in its fast slot, if any. */
+static inline sqlite3_stmt *entry_evict_fast_slot (PLSqliteStatementCacheEntry *entry) {
+    sqlite3_stmt *stmt;
+
+    do {
+        stmt = entry->_fastSlot;
+    } while (!__sync_bool_compare_and_swap(&entry->_fastSlot, stmt, PL_SQLITE_CACHE_ENTRY_EVICTED));
+
+    if (stmt == PL_SQLITE_CACHE_ENTRY_EVICTED)
+        return NULL;
+
+    return stmt;
+}
+
+/* Mark @a entry as referenced, granting it a second chance should it be considered for eviction. The flag is only
+ * written if unset, avoiding needless cache line contention between threads sharing a hot entry. */
+static inline void entry_mark_referenced (PLSqliteStatementCacheEntry *entry) {
+    if (entry->_referenced == 0)
+        entry->_referenced = 1;
+}
+
+/**
+ * @internal
+ *
+ * A single statement cache entry, containing all available sqlite3_stmt instances for a given query string.
+ * Entries are linked into the owning cache's LRU list.
+ */
+@implementation PLSqliteStatementCacheEntry
+
+- (id) initWithQuery: (NSString *) query {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _query = [query copy];
+    _fastSlot = NULL;
+    _statements = CFArrayCreateMutable(NULL, 0, &StatementCacheArrayCallbacks);
+
+    return self;
+}
+
+- (void) dealloc {
+    /* Statements must be finalized by the cache prior to the entry's deallocation */
+    assert(CFArrayGetCount(_statements) == 0);
+    assert(_fastSlot == NULL || _fastSlot == PL_SQLITE_CACHE_ENTRY_EVICTED);
+
+    CFRelease(_statements);
+    [_columnNameIndex release];
+    [_parameterNames release];
+    [_query release];
+
+    [super dealloc];
+}
+
+/**
+ * Returns YES if the entry has been evicted from its cache. An evicted entry will never again hold statements.
+ */
+- (BOOL) isEvicted {
+    return (_fastSlot == PL_SQLITE_CACHE_ENTRY_EVICTED);
+}
+
+/**
+ * Return the column name index for this entry's query, constructing it from @a stmt if it has not yet been
+ * constructed. The index is shared by all statements prepared for the entry's query string, and may safely be
+ * requested concurrently.
+ *
+ * @param stmt A statement prepared from this entry's query string.
+ */
+- (PLSqliteColumnNameIndex *) columnNameIndexForStatement: (sqlite3_stmt *) stmt {
+    PLSqliteColumnNameIndex *index = _columnNameIndex;
+    if (index != nil)
+        return index;
+
+    /* Publish our index, deferring to any index published concurrently */
+    index = [[PLSqliteColumnNameIndex alloc] initWithStatement: stmt];
+    if (!__sync_bool_compare_and_swap(&_columnNameIndex, nil, index)) {
+        [index release];
+        index = _columnNameIndex;
+    }
+
+    return index;
+}
+
+/**
+ * Return the parameter name table for this entry's query, constructing it from @a stmt via
+ * pl_sqlite3_parameter_names() if it has not yet been constructed. The table is shared by all statements prepared
+ * for the entry's query string, and may safely be requested concurrently.
+ *
+ * @param stmt A statement prepared from this entry's query string.
+ */
+- (NSArray *) parameterNamesForStatement: (sqlite3_stmt *) stmt {
+    NSArray *names = _parameterNames;
+    if (names != nil)
+        return names;
+
+    /* Publish our table, deferring to any table published concurrently */
+    names = [pl_sqlite3_parameter_names(stmt) retain];
+    if (!__sync_bool_compare_and_swap(&_parameterNames, nil, names)) {
+        [names release];
+        names = _parameterNames;
+    }
+
+    return names;
+}
+
+@end
+
+/**
+ * @internal
+ *
+ * Return the names of @a stmt's parameters, stripped of their ':', '@' or '$' prefix, in parameter order; the
+ * n-th element corresponds to SQLite parameter n + 1. Unnamed parameters are represented by NSNull.
+ */
+NSArray *pl_sqlite3_parameter_names (sqlite3_stmt *stmt) {
+    int count = sqlite3_bind_parameter_count(stmt);
+    NSMutableArray *names = [NSMutableArray arrayWithCapacity: count];
+
+    for (int parameterIndex = 1; parameterIndex <= count; parameterIndex++) {
+        const char *name = sqlite3_bind_parameter_name(stmt, parameterIndex);
+
+        /* If there is no name, or if it's blank, the parameter can't be bound by name */
+        if (name == NULL || *name == '\0') {
+            [names addObject: [NSNull null]];
+            continue;
+        }
+
+        [names addObject: [NSString stringWithUTF8String: name + 1]];
+    }
+
+    return [[names copy] autorelease];
+}
+
+static void apply_cache_remove_statement (const void *value, void *context);
+
 @interface PLSqliteStatementCache (PrivateMethods)
 - (void) removeAllStatementsHasLock: (BOOL) locked;
+- (BOOL) isRegisteredStatement: (sqlite3_stmt *) stmt;
+- (PLSqliteStatementCacheEntry *) entryForQuery: (NSString *) query;
+- (void) cacheStatement: (sqlite3_stmt *) stmt inEntry: (PLSqliteStatementCacheEntry *) entry;
+- (sqlite3_stmt *) takeStatementFromEntry: (PLSqliteStatementCacheEntry *) entry;
+- (void) touchEntry: (PLSqliteStatementCacheEntry *) entry;
+- (void) unlinkEntry: (PLSqliteStatementCacheEntry *) entry;
+- (void) evictEntry: (PLSqliteStatementCacheEntry *) entry;
+- (void) evictToCapacity;
 @end
 
 /**
@@ -55,34 +218,64 @@ static const CFSetCallBacks StatementCacheSetCallbacks = {
  *
  * Manages a cache of sqlite3_stmt instances, providing a mapping from query string to a sqlite3_stmt.
  *
- * The implementation naively evicts all statements should the cache become full. Future enhancement
- * may include implementing an LRU strategy, but it's not expected that many users will be executing
- * more unique queries than will fit in a reasonably sized cache.
+ * Should the cache exceed its capacity, the statements belonging to the least recently used query strings
+ * are finalized until the cache is once again within capacity. A query string is considered to be used when
+ * one of its statements is either checked out from, or checked in to, the cache.
  *
  * @par Thread Safety
  *
  * Unlike most classes in this library, PLSqliteStatementCache is thread-safe; this is intended to allow the safe
  * finalization/deallocation of SQLite ojects from multiple threads.
  *
- * Note, however, that the implementation is optimized for minimal contention.
+ * The implementation is optimized for minimal contention. Each cache entry provides a single-statement fast slot
+ * that is checked in to and out of via atomic compare-and-swap, without acquiring the cache's lock or performing a
+ * query string lookup; this is the common case for a statement that is repeatedly prepared and closed. Entries
+ * used via the fast slot are marked as referenced rather than being moved within the LRU list, and are granted
+ * a second chance before eviction. Additional statements for the same query, and all operations that mutate the
+ * cache's structure, fall back to the locked path.
  */
 @implementation PLSqliteStatementCache
 
 /**
- * Initialize the cache with the provided query @a capacity. The cache will discard sqlite3_stmt instances to stay
- * within the given capacity.
+ * Initialize the cache with the provided query @a capacity, using the PLSqliteStatementCacheEvictionPolicyLRU
+ * eviction policy. The cache will discard sqlite3_stmt instances to stay within the given capacity.
  *
  * @param capacity Maximum cache capacity.
  */
 - (id) initWithCapacity: (NSUInteger) capacity {
+    return [self initWithCapacity: capacity evictionPolicy: PLSqliteStatementCacheEvictionPolicyLRU maxStatementsPerQuery: 0];
+}
+
+/**
+ * Initialize the cache with the provided query @a capacity and @a evictionPolicy. The cache will discard sqlite3_stmt
+ * instances to stay within the given capacity.
+ *
+ * @param capacity Maximum cache capacity. If 0, statements will be finalized upon check-in.
+ * @param evictionPolicy The policy to be used to evict statements should the cache exceed @a capacity.
+ * @param maxStatementsPerQuery The maximum number of available statements to be cached for any single query string.
+ * Statements checked in beyond this limit will be finalized. If 0, no per-query limit will be applied.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteStatementCache class.
+ */
+- (id) initWithCapacity: (NSUInteger) capacity
+         evictionPolicy: (PLSqliteStatementCacheEvictionPolicy) evictionPolicy
+  maxStatementsPerQuery: (NSUInteger) maxStatementsPerQuery
+{
     if ((self = [super init]) == nil)
         return nil;
     
     _capacity = capacity;
+    _evictionPolicy = evictionPolicy;
+    _maxStatementsPerQuery = maxStatementsPerQuery;
     _availableStatements = [[NSMutableDictionary alloc] init];
     _allStatements = CFSetCreateMutable(NULL, 0, &StatementCacheSetCallbacks);
+
+    /* The legacy flush policy must be applied before a statement is cached, and may not be deferred to
+     * the lock-free check-in path. */
+    _fastPathEnabled = (_capacity > 0 && _evictionPolicy == PLSqliteStatementCacheEvictionPolicyLRU);
     
-    _lock = OS_SPINLOCK_INIT;
+    pthread_mutex_init(&_lock, NULL);
 
     return self;
 }
@@ -98,6 +291,8 @@ static const CFSetCallBacks StatementCacheSetCallbacks = {
         _allStatements = NULL;
     }
 
+    pthread_mutex_destroy(&_lock);
+
     [super dealloc];
 }
 
@@ -111,48 +306,98 @@ static const CFSetCallBacks StatementCacheSetCallbacks = {
  *
  */
 - (void) registerStatement: (sqlite3_stmt *) stmt {
-    OSSpinLockLock(&_lock); {
+    pthread_mutex_lock(&_lock); {
         CFSetAddValue(_allStatements, stmt);
-    }; OSSpinLockUnlock(&_lock);
+    }; pthread_mutex_unlock(&_lock);
 }
 
 /**
  * Check in an sqlite3 prepared statement for the given @a query, making it available for re-use from the cache.
  * The statement will be reset (via sqlite3_reset()).
  *
+ * If the cache exceeds its capacity, the statements of the least recently used queries will be finalized.
+ *
  * @param stmt The statement to check in.
  * @param query The query string corresponding to this statement.
  *
  * @warning MEMORY OWNERSHIP WARNING: The receiver will claim ownership of the statement object.
  */
 - (void) checkinStatement: (sqlite3_stmt *) stmt forQuery: (NSString *) query {
-    OSSpinLockLock(&_lock); {
+    pthread_mutex_lock(&_lock); {
         /* If the statement pointer is not currently registered, there's nothing to do here. This should never occur. */
-        if (!CFSetContainsValue(_allStatements, stmt)) {
-            // TODO - Should this be an assert()?
-            NSLog(@"[PLSqliteStatementCache]: Received an unknown statement %p during check-in.", stmt);
-            OSSpinLockUnlock(&_lock);
+        if (![self isRegisteredStatement: stmt]) {
+            pthread_mutex_unlock(&_lock);
             return;
         }
 
-        /* Bump the count */
-        _size++;
-        if (_size > _capacity) {
-            [self removeAllStatementsHasLock: YES];
+        /* Fetch the cache entry for this query, if caching is enabled */
+        PLSqliteStatementCacheEntry *entry = nil;
+        if (_capacity > 0)
+            entry = [self entryForQuery: query];
+
+        [self cacheStatement: stmt inEntry: entry];
+    }; pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Check in an sqlite3 prepared statement previously checked out via checkoutStatementForQueryString:cacheEntry:
+ * or checkoutStatementForCacheEntry:, making it available for re-use from the cache. The statement will be
+ * reset (via sqlite3_reset()).
+ *
+ * If the entry's fast slot is available, the statement will be checked in without acquiring the cache's lock.
+ * Otherwise, this is equivalent to checkinStatement:forQuery:.
+ *
+ * @param stmt The statement to check in.
+ * @param entry The cache entry returned when the statement was checked out, or nil if none was returned.
+ *
+ * @warning MEMORY OWNERSHIP WARNING: The receiver will claim ownership of the statement object.
+ */
+- (void) checkinStatement: (sqlite3_stmt *) stmt forCacheEntry: (PLSqliteStatementCacheEntry *) entry {
+    /* Try the lock-free path. The statement registration check is skipped; an unregistered statement could only
+     * have been supplied to us by the cache itself, and close waits for any in-progress check-ins to complete. */
+    if (entry != nil && _fastPathEnabled) {
+        BOOL cached = NO;
+
+        __sync_fetch_and_add(&_activeFastCheckins, 1);
+        if (_closing == 0 && entry->_fastSlot == NULL) {
+            sqlite3_reset(stmt);
+
+            /* The size is incremented prior to publishing the statement, so that a concurrent check-out may never
+             * decrement it below zero. */
+            __sync_fetch_and_add(&_size, 1);
+            if (entry_put_fast_slot(entry, stmt)) {
+                entry_mark_referenced(entry);
+                cached = YES;
+            } else {
+                __sync_fetch_and_sub(&_size, 1);
+            }
         }
+        __sync_fetch_and_sub(&_activeFastCheckins, 1);
+
+        if (cached) {
+            /* Evict the coldest entries if we've exceeded our capacity. */
+            if (_size > _capacity) {
+                pthread_mutex_lock(&_lock); {
+                    [self evictToCapacity];
+                }; pthread_mutex_unlock(&_lock);
+            }
+            return;
+        }
+    }
 
-        /* Fetch the statement set for this query */
-        CFMutableArrayRef stmtArray = (CFMutableArrayRef) [_availableStatements objectForKey: query];
-        if (stmtArray == nil) {
-            stmtArray = CFArrayCreateMutable(NULL, 0, &StatementCacheArrayCallbacks);
-            [_availableStatements setObject: (id) stmtArray forKey: query];
-            [(id)stmtArray release];
+    pthread_mutex_lock(&_lock); {
+        /* If the statement pointer is not currently registered, there's nothing to do here. This should never occur. */
+        if (![self isRegisteredStatement: stmt]) {
+            pthread_mutex_unlock(&_lock);
+            return;
         }
 
-        /* Claim ownership of the statement */
-        sqlite3_reset(stmt);
-        CFArrayAppendValue(stmtArray, stmt);
-    }; OSSpinLockUnlock(&_lock);
+        /* If the entry has since been evicted, fetch its replacement */
+        if (entry != nil && _capacity > 0 && [entry isEvicted])
+            entry = [self entryForQuery: entry->_query];
+
+        [self cacheStatement: stmt inEntry: entry];
+    }; pthread_mutex_unlock(&_lock);
 }
 
 /**
@@ -164,27 +409,95 @@ static const CFSetCallBacks StatementCacheSetCallbacks = {
  * that object or provide it to PLSqliteStatementCache::checkinStatement:forQuery: for reclaimation.
  */
 - (sqlite3_stmt *) checkoutStatementForQueryString: (NSString *) query {
-    sqlite3_stmt *stmt;
+    return [self checkoutStatementForQueryString: query cacheEntry: NULL];
+}
 
-    OSSpinLockLock(&_lock); {
-        /* Fetch the statement set for this query */
-        CFMutableArrayRef stmtArray = (CFMutableArrayRef) [_availableStatements objectForKey: query];
-        if (stmtArray == nil || CFArrayGetCount(stmtArray) == 0) {
-            OSSpinLockUnlock(&_lock);
-            return NULL;
+/**
+ * Check out a sqlite3 prepared statement for the given @a query, or NULL if none is cached.
+ *
+ * @param query The query string corresponding to this statement.
+ * @param entry If non-NULL, will be set to the cache entry for @a query, or nil if caching is disabled. The entry
+ * is created if necessary, and should be provided to checkinStatement:forCacheEntry: when the statement (or a newly
+ * prepared statement for @a query) is checked in.
+ *
+ * @warning MEMORY OWNERSHIP WARNING: The caller is given ownership of the statement object, and MUST either deallocate
+ * that object or provide it to PLSqliteStatementCache::checkinStatement:forCacheEntry: for reclaimation. The caller
+ * is also given ownership of the returned entry reference, and must release it.
+ */
+- (sqlite3_stmt *) checkoutStatementForQueryString: (NSString *) query cacheEntry: (PLSqliteStatementCacheEntry **) outEntry {
+    sqlite3_stmt *stmt = NULL;
+
+    pthread_mutex_lock(&_lock); {
+        /* Fetch the cache entry for this query, creating it if the caller has requested it */
+        PLSqliteStatementCacheEntry *entry;
+        if (outEntry != NULL && _capacity > 0)
+            entry = [self entryForQuery: query];
+        else
+            entry = [_availableStatements objectForKey: query];
+
+        /* Fetch a statement and mark the entry as most recently used */
+        if (entry != nil) {
+            stmt = [self takeStatementFromEntry: entry];
+            [self touchEntry: entry];
         }
 
-        /* Pop the statement from the array */
-        stmt = (sqlite3_stmt *) CFArrayGetValueAtIndex(stmtArray, 0);
-        CFArrayRemoveValueAtIndex(stmtArray, 0);
+        if (outEntry != NULL)
+            *outEntry = [entry retain];
+    }; pthread_mutex_unlock(&_lock);
+
+    return stmt;
+}
 
-        /* Decrement the count */
-        _size--;
-    }; OSSpinLockUnlock(&_lock);
+/**
+ * Check out a sqlite3 prepared statement for the given cache @a entry, or NULL if none is cached. If a statement is
+ * available in the entry's fast slot, it will be checked out without acquiring the cache's lock.
+ *
+ * @param entry A cache entry returned by checkoutStatementForQueryString:cacheEntry:.
+ *
+ * @warning MEMORY OWNERSHIP WARNING: The caller is given ownership of the statement object, and MUST either deallocate
+ * that object or provide it to PLSqliteStatementCache::checkinStatement:forCacheEntry: for reclaimation.
+ */
+- (sqlite3_stmt *) checkoutStatementForCacheEntry: (PLSqliteStatementCacheEntry *) entry {
+    sqlite3_stmt *stmt;
+
+    /* Try the lock-free path */
+    stmt = entry_take_fast_slot(entry);
+    if (stmt != NULL) {
+        __sync_fetch_and_sub(&_size, 1);
+        entry_mark_referenced(entry);
+        return stmt;
+    }
+
+    /* An evicted entry holds no statements */
+    if ([entry isEvicted])
+        return NULL;
+
+    pthread_mutex_lock(&_lock); {
+        stmt = [self takeStatementFromEntry: entry];
+        if (stmt != NULL)
+            [self touchEntry: entry];
+    }; pthread_mutex_unlock(&_lock);
 
     return stmt;
 }
 
+/**
+ * Return the cache entry for the given @a query, creating it if necessary, or nil if caching is disabled. The entry
+ * may be used to check statements in and out without a query string lookup.
+ *
+ * @param query The query string.
+ */
+- (PLSqliteStatementCacheEntry *) cacheEntryForQueryString: (NSString *) query {
+    PLSqliteStatementCacheEntry *entry = nil;
+
+    pthread_mutex_lock(&_lock); {
+        if (_capacity > 0)
+            entry = [[self entryForQuery: query] retain];
+    }; pthread_mutex_unlock(&_lock);
+
+    return [entry autorelease];
+}
+
 /**
  * Remove all unused statements from the cache. This will not invalidate active, in-use statements.
  */
@@ -206,7 +519,12 @@ static void apply_cache_statement_finalize (const void *value, void *context) {
  * only be called by the PLSqliteDatabase prior to finalization.
  */
 - (void) close {
-    OSSpinLockLock(&_lock); {
+    pthread_mutex_lock(&_lock); {
+        /* Prevent new lock-free check-ins, and wait for those in progress to complete. */
+        __sync_lock_test_and_set(&_closing, 1);
+        __sync_synchronize();
+        while (_activeFastCheckins != 0)
+            sched_yield();
 
         /* Finalize all registered statements */
         if (_allStatements != NULL) {
@@ -214,9 +532,20 @@ static void apply_cache_statement_finalize (const void *value, void *context) {
             CFSetRemoveAllValues(_allStatements);
         }
 
-        /* Empty the statement cache of the now invalid references. */
+        /* Empty the statement cache of the now invalid references. Entries that remain referenced by checked out
+         * statements are marked as evicted, directing any later check-in to the locked path. */
+        for (PLSqliteStatementCacheEntry *entry in [_availableStatements objectEnumerator]) {
+            entry_evict_fast_slot(entry);
+            CFArrayRemoveAllValues(entry->_statements);
+        }
+
         [_availableStatements removeAllObjects];
-    } OSSpinLockUnlock(&_lock);
+        _lruHead = nil;
+        _lruTail = nil;
+        _size = 0;
+
+        __sync_lock_release(&_closing);
+    } pthread_mutex_unlock(&_lock);
 }
 
 @end
@@ -243,22 +572,231 @@ static void apply_cache_remove_statement (const void *value, void *context) {
  */
 - (void) removeAllStatementsHasLock: (BOOL) locked {
     if (!locked)
-        OSSpinLockLock(&_lock);
+        pthread_mutex_lock(&_lock);
     
-    /* Iterate over all cached queries and finalize their sqlite statements */
-    [_availableStatements enumerateKeysAndObjectsUsingBlock: ^(id key, id obj, BOOL *stop) {
-        CFMutableArrayRef array = (CFMutableArrayRef) obj;
-        CFIndex count = CFArrayGetCount(array);
-        
-        /* Finalize all statements */
-        CFArrayApplyFunction(array, CFRangeMake(0, count), apply_cache_remove_statement, self);
-    }];
-    
-    /* Empty the statement cache of the now invalid references. */
-    [_availableStatements removeAllObjects];
+    /* Finalize the statements of all cached queries */
+    while (_lruTail != nil)
+        [self evictEntry: _lruTail];
+
+    assert([_availableStatements count] == 0);
 
     if (!locked)
-        OSSpinLockUnlock(&_lock);
+        pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Return YES if @a stmt has been registered with the cache. An unknown statement is logged.
+ *
+ * Must be called with _lock held.
+ */
+- (BOOL) isRegisteredStatement: (sqlite3_stmt *) stmt {
+    if (CFSetContainsValue(_allStatements, stmt))
+        return YES;
+
+    // TODO - Should this be an assert()?
+    NSLog(@"[PLSqliteStatementCache]: Received an unknown statement %p during check-in.", stmt);
+    return NO;
+}
+
+/**
+ * Return the entry for @a query, creating and inserting it at the head of the LRU list if necessary.
+ *
+ * Must be called with _lock held.
+ */
+- (PLSqliteStatementCacheEntry *) entryForQuery: (NSString *) query {
+    PLSqliteStatementCacheEntry *entry = [_availableStatements objectForKey: query];
+    if (entry != nil)
+        return entry;
+
+    entry = [[PLSqliteStatementCacheEntry alloc] initWithQuery: query];
+    [_availableStatements setObject: entry forKey: entry->_query];
+    [self touchEntry: entry];
+    [entry release];
+
+    return entry;
+}
+
+/**
+ * Claim ownership of @a stmt, caching it in @a entry. If @a entry is nil or the cache is disabled, the statement
+ * is finalized.
+ *
+ * Must be called with _lock held.
+ */
+- (void) cacheStatement: (sqlite3_stmt *) stmt inEntry: (PLSqliteStatementCacheEntry *) entry {
+    /* If caching is disabled, simply finalize the statement */
+    if (entry == nil || _capacity == 0) {
+        apply_cache_remove_statement(stmt, self);
+        return;
+    }
+
+    /* Mark the entry as most recently used. */
+    [self touchEntry: entry];
+
+    /* If the query already has its maximum number of statements available, there's no need to cache another. The
+     * fast slot accounts for one of the query's statements. */
+    if (_maxStatementsPerQuery > 0 && entry->_fastSlot != NULL &&
+        (NSUInteger) CFArrayGetCount(entry->_statements) >= _maxStatementsPerQuery - 1)
+    {
+        apply_cache_remove_statement(stmt, self);
+        return;
+    }
+
+    /* Flush the cache if the statement would exceed our capacity, as per the legacy eviction policy */
+    if (_evictionPolicy == PLSqliteStatementCacheEvictionPolicyFlush && _size + 1 > _capacity) {
+        /* The flush removes our entry */
+        NSString *query = [entry->_query retain];
+        [self removeAllStatementsHasLock: YES];
+        entry = [self entryForQuery: query];
+        [query release];
+    }
+
+    /* Claim ownership of the statement, preferring the fast slot. */
+    sqlite3_reset(stmt);
+    __sync_fetch_and_add(&_size, 1);
+    if (!entry_put_fast_slot(entry, stmt))
+        CFArrayAppendValue(entry->_statements, stmt);
+
+    /* Evict the coldest entries if we've exceeded our capacity. */
+    [self evictToCapacity];
+}
+
+/**
+ * Remove and return an available statement from @a entry, or NULL if none is available.
+ *
+ * Must be called with _lock held.
+ */
+- (sqlite3_stmt *) takeStatementFromEntry: (PLSqliteStatementCacheEntry *) entry {
+    sqlite3_stmt *stmt = entry_take_fast_slot(entry);
+
+    /* Pop the most recently checked in statement from the array */
+    if (stmt == NULL && CFArrayGetCount(entry->_statements) > 0) {
+        CFIndex idx = CFArrayGetCount(entry->_statements) - 1;
+        stmt = (sqlite3_stmt *) CFArrayGetValueAtIndex(entry->_statements, idx);
+        CFArrayRemoveValueAtIndex(entry->_statements, idx);
+    }
+
+    if (stmt != NULL)
+        __sync_fetch_and_sub(&_size, 1);
+
+    return stmt;
+}
+
+/**
+ * Move @a entry to the head of the LRU list, marking it as the most recently used entry. If the entry is not
+ * yet linked into the LRU list, it will be inserted.
+ *
+ * Must be called with _lock held.
+ */
+- (void) touchEntry: (PLSqliteStatementCacheEntry *) entry {
+    if (_lruHead == entry)
+        return;
+
+    [self unlinkEntry: entry];
+
+    entry->_lruNext = _lruHead;
+    if (_lruHead != nil)
+        _lruHead->_lruPrev = entry;
+    _lruHead = entry;
+
+    if (_lruTail == nil)
+        _lruTail = entry;
+}
+
+/**
+ * Remove @a entry from the LRU list, if linked.
+ *
+ * Must be called with _lock held.
+ */
+- (void) unlinkEntry: (PLSqliteStatementCacheEntry *) entry {
+    if (entry->_lruPrev != nil)
+        entry->_lruPrev->_lruNext = entry->_lruNext;
+    else if (_lruHead == entry)
+        _lruHead = entry->_lruNext;
+
+    if (entry->_lruNext != nil)
+        entry->_lruNext->_lruPrev = entry->_lruPrev;
+    else if (_lruTail == entry)
+        _lruTail = entry->_lruPrev;
+
+    entry->_lruPrev = nil;
+    entry->_lruNext = nil;
 }
 
-@end
\ No newline at end of file
+/**
+ * Finalize all available statements for @a entry, and remove the entry from the cache. The entry is marked as
+ * evicted; statements later checked in for the entry are cached in its replacement.
+ *
+ * Must be called with _lock held.
+ */
+- (void) evictEntry: (PLSqliteStatementCacheEntry *) entry {
+    CFIndex count = CFArrayGetCount(entry->_statements);
+
+    /* Finalize all statements */
+    sqlite3_stmt *stmt = entry_evict_fast_slot(entry);
+    if (stmt != NULL) {
+        apply_cache_remove_statement(stmt, self);
+        __sync_fetch_and_sub(&_size, 1);
+    }
+
+    CFArrayApplyFunction(entry->_statements, CFRangeMake(0, count), apply_cache_remove_statement, self);
+    CFArrayRemoveAllValues(entry->_statements);
+    __sync_fetch_and_sub(&_size, count);
+
+    /* Drop the entry. The dictionary may hold the final reference, and the entry's query is used as the key, so
+     * we must keep the entry alive until removal has completed. */
+    [entry retain];
+    [self unlinkEntry: entry];
+    [_availableStatements removeObjectForKey: entry->_query];
+    [entry release];
+}
+
+/**
+ * Evict the least recently used entries until the cache is within capacity. Entries that have been referenced via
+ * the lock-free path since they were last considered are given a second chance, and moved to the head of the list.
+ * The most recently used entry is only evicted if it alone exceeds the cache's capacity, in which case its oldest
+ * statements are finalized.
+ *
+ * Must be called with _lock held.
+ */
+- (void) evictToCapacity {
+    /* Bound the number of second chances, as the referenced flags may be concurrently set. */
+    NSUInteger secondChances = [_availableStatements count];
+
+    /* Evict cold entries */
+    while (_size > _capacity && _lruTail != nil && _lruTail != _lruHead) {
+        PLSqliteStatementCacheEntry *entry = _lruTail;
+        if (secondChances > 0 && entry->_referenced != 0) {
+            entry->_referenced = 0;
+            secondChances--;
+            [self touchEntry: entry];
+            continue;
+        }
+
+        [self evictEntry: entry];
+    }
+
+    /* Trim the remaining entry, if necessary */
+    PLSqliteStatementCacheEntry *entry = _lruHead;
+    BOOL trimmed = NO;
+    while (_size > _capacity && entry != nil && CFArrayGetCount(entry->_statements) > 0) {
+        apply_cache_remove_statement(CFArrayGetValueAtIndex(entry->_statements, 0), self);
+        CFArrayRemoveValueAtIndex(entry->_statements, 0);
+        __sync_fetch_and_sub(&_size, 1);
+        trimmed = YES;
+    }
+
+    if (_size > _capacity && entry != nil) {
+        sqlite3_stmt *stmt = entry_take_fast_slot(entry);
+        if (stmt != NULL) {
+            apply_cache_remove_statement(stmt, self);
+            __sync_fetch_and_sub(&_size, 1);
+            trimmed = YES;
+        }
+    }
+
+    /* Drop the remaining entry if it has been emptied */
+    if (trimmed && entry->_fastSlot == NULL && CFArrayGetCount(entry->_statements) == 0)
+        [self evictEntry: entry];
+}
+
+@end
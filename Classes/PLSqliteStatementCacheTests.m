@@ -118,4 +118,293 @@
     [cache close];
 }
 
+/**
+ * Verify that exceeding the cache capacity only evicts the statements of the least recently used query.
+ */
+- (void) testLRUEviction {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    /* Prepare a statement for each query */
+    NSArray *queries = [NSArray arrayWithObjects: @"SELECT 1", @"SELECT 2", @"SELECT 3", nil];
+    sqlite3_stmt *stmts[3];
+    const char *unused;
+
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 2] autorelease];
+    for (int i = 0; i < 3; i++) {
+        int ret = sqlite3_prepare_v2(sqlite, [[queries objectAtIndex: i] UTF8String], -1, &stmts[i], &unused);
+        STAssertEquals(ret, SQLITE_OK, @"Failed to prepare the statement");
+        [cache registerStatement: stmts[i]];
+    }
+
+    /* Fill the cache, and then use the first (oldest) query, making the second query the coldest. */
+    [cache checkinStatement: stmts[0] forQuery: [queries objectAtIndex: 0]];
+    [cache checkinStatement: stmts[1] forQuery: [queries objectAtIndex: 1]];
+
+    sqlite3_stmt *hot = [cache checkoutStatementForQueryString: [queries objectAtIndex: 0]];
+    STAssertEquals(stmts[0], hot, @"Statement was not cached");
+    [cache checkinStatement: hot forQuery: [queries objectAtIndex: 0]];
+
+    /* Exceed the capacity; only the cold statement should be evicted */
+    [cache checkinStatement: stmts[2] forQuery: [queries objectAtIndex: 2]];
+
+    STAssertEquals(stmts[0], [cache checkoutStatementForQueryString: [queries objectAtIndex: 0]], @"Hot statement was evicted");
+    STAssertEquals(stmts[2], [cache checkoutStatementForQueryString: [queries objectAtIndex: 2]], @"New statement was evicted");
+    STAssertTrue([cache checkoutStatementForQueryString: [queries objectAtIndex: 1]] == NULL, @"Cold statement was not evicted");
+
+    /* Return the checked out statements so that the cache will finalize them */
+    [cache checkinStatement: stmts[0] forQuery: [queries objectAtIndex: 0]];
+    [cache checkinStatement: stmts[2] forQuery: [queries objectAtIndex: 2]];
+    [cache close];
+
+    /* Verify that the database closes cleanly; the evicted statement must have been finalized. */
+    [db close];
+}
+
+/**
+ * Verify that hot statements survive when cycling through more distinct queries than the cache can hold.
+ */
+- (void) testHotStatementsSurviveThrashing {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 10] autorelease];
+    const char *unused;
+
+    /* Prepare the hot statement */
+    NSString *hotQuery = @"SELECT 'hot'";
+    sqlite3_stmt *hot;
+    STAssertEquals(sqlite3_prepare_v2(sqlite, [hotQuery UTF8String], -1, &hot, &unused), SQLITE_OK, @"Failed to prepare the statement");
+    [cache registerStatement: hot];
+    [cache checkinStatement: hot forQuery: hotQuery];
+
+    /* Cycle through 50 cold queries, using the hot query between each */
+    for (int i = 0; i < 50; i++) {
+        NSString *query = [NSString stringWithFormat: @"SELECT %d", i];
+        sqlite3_stmt *stmt;
+
+        STAssertEquals(sqlite3_prepare_v2(sqlite, [query UTF8String], -1, &stmt, &unused), SQLITE_OK, @"Failed to prepare the statement");
+        [cache registerStatement: stmt];
+        [cache checkinStatement: stmt forQuery: query];
+
+        sqlite3_stmt *cached = [cache checkoutStatementForQueryString: hotQuery];
+        STAssertEquals(hot, cached, @"Hot statement was evicted after %d cold queries", i);
+        [cache checkinStatement: cached forQuery: hotQuery];
+    }
+
+    /* Verify that the cache and database close cleanly. */
+    [cache close];
+    [db close];
+}
+
+/**
+ * Verify that no more than the configured number of statements are cached per query.
+ */
+- (void) testMaxStatementsPerQuery {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 10
+                                                                       evictionPolicy: PLSqliteStatementCacheEvictionPolicyLRU
+                                                                maxStatementsPerQuery: 1] autorelease];
+
+    /* Check in two statements for the same query */
+    NSString *queryString = @"SELECT 1";
+    sqlite3_stmt *stmts[2];
+    const char *unused;
+    for (int i = 0; i < 2; i++) {
+        STAssertEquals(sqlite3_prepare_v2(sqlite, [queryString UTF8String], -1, &stmts[i], &unused), SQLITE_OK, @"Failed to prepare the statement");
+        [cache registerStatement: stmts[i]];
+    }
+    [cache checkinStatement: stmts[0] forQuery: queryString];
+    [cache checkinStatement: stmts[1] forQuery: queryString];
+
+    /* Only the first should have been retained */
+    STAssertEquals(stmts[0], [cache checkoutStatementForQueryString: queryString], @"Statement was not cached");
+    STAssertTrue([cache checkoutStatementForQueryString: queryString] == NULL, @"Per-query limit was not applied");
+
+    /* Verify that the cache and database close cleanly; the second statement must have been finalized. */
+    [cache checkinStatement: stmts[0] forQuery: queryString];
+    [cache close];
+    [db close];
+}
+
+/**
+ * Verify that a zero capacity cache finalizes statements at check-in.
+ */
+- (void) testZeroCapacity {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    NSString *queryString = @"SELECT 1";
+    sqlite3_stmt *stmt;
+    const char *unused;
+    STAssertEquals(sqlite3_prepare_v2(sqlite, [queryString UTF8String], -1, &stmt, &unused), SQLITE_OK, @"Failed to prepare the statement");
+
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 0] autorelease];
+    [cache registerStatement: stmt];
+    [cache checkinStatement: stmt forQuery: queryString];
+    STAssertTrue([cache checkoutStatementForQueryString: queryString] == NULL, @"Statement was cached");
+
+    /* Verify that the database closes cleanly without closing the cache; the statement must have been finalized. */
+    [db close];
+}
+
+/**
+ * Verify the legacy flush eviction policy.
+ */
+- (void) testFlushEvictionPolicy {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 2
+                                                                       evictionPolicy: PLSqliteStatementCacheEvictionPolicyFlush
+                                                                maxStatementsPerQuery: 0] autorelease];
+
+    NSArray *queries = [NSArray arrayWithObjects: @"SELECT 1", @"SELECT 2", @"SELECT 3", nil];
+    sqlite3_stmt *stmts[3];
+    const char *unused;
+    for (int i = 0; i < 3; i++) {
+        STAssertEquals(sqlite3_prepare_v2(sqlite, [[queries objectAtIndex: i] UTF8String], -1, &stmts[i], &unused), SQLITE_OK, @"Failed to prepare the statement");
+        [cache registerStatement: stmts[i]];
+        [cache checkinStatement: stmts[i] forQuery: [queries objectAtIndex: i]];
+    }
+
+    /* Exceeding the capacity should have flushed the first two statements */
+    STAssertTrue([cache checkoutStatementForQueryString: [queries objectAtIndex: 0]] == NULL, @"Cache was not flushed");
+    STAssertTrue([cache checkoutStatementForQueryString: [queries objectAtIndex: 1]] == NULL, @"Cache was not flushed");
+    STAssertEquals(stmts[2], [cache checkoutStatementForQueryString: [queries objectAtIndex: 2]], @"Statement was not cached");
+
+    [cache checkinStatement: stmts[2] forQuery: [queries objectAtIndex: 2]];
+    [cache close];
+    [db close];
+}
+
+/**
+ * Test check-in and check-out via a cache entry.
+ */
+- (void) testCacheEntryCheckin {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 1] autorelease];
+    NSString *queryString = @"SELECT 1";
+    const char *unused;
+
+    /* Fetch the entry; no statement is available */
+    PLSqliteStatementCacheEntry *entry;
+    STAssertTrue([cache checkoutStatementForQueryString: queryString cacheEntry: &entry] == NULL, @"Unexpected statement");
+    STAssertNotNil(entry, @"No entry was returned");
+    [entry autorelease];
+
+    /* Check in a new statement, and then fetch it via the entry. */
+    sqlite3_stmt *stmt;
+    STAssertEquals(sqlite3_prepare_v2(sqlite, [queryString UTF8String], -1, &stmt, &unused), SQLITE_OK, @"Failed to prepare the statement");
+    [cache registerStatement: stmt];
+    [cache checkinStatement: stmt forCacheEntry: entry];
+
+    STAssertEquals(stmt, [cache checkoutStatementForCacheEntry: entry], @"Statement was not cached");
+    STAssertTrue([cache checkoutStatementForCacheEntry: entry] == NULL, @"Statement was checked out twice");
+
+    /* The statement must also be available via the query string */
+    [cache checkinStatement: stmt forCacheEntry: entry];
+    STAssertEquals(stmt, [cache checkoutStatementForQueryString: queryString], @"Statement was not cached");
+
+    /* Evict the entry while the statement is checked out, and verify that check-in of the statement is directed
+     * to a replacement entry. */
+    [cache removeAllStatements];
+    [cache checkinStatement: stmt forCacheEntry: entry];
+
+    STAssertTrue([cache checkoutStatementForCacheEntry: entry] == NULL, @"Evicted entry returned a statement");
+    STAssertEquals(stmt, [cache checkoutStatementForQueryString: queryString], @"Statement was not cached in the replacement entry");
+
+    /* Verify that the cache and database close cleanly. */
+    [cache checkinStatement: stmt forCacheEntry: entry];
+    [cache close];
+    [db close];
+}
+
+/**
+ * Test concurrent check-in and check-out of statements from multiple threads.
+ */
+- (void) testConcurrentCacheEntryCheckin {
+    NSError *error;
+
+    /* Create a testing database */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    STAssertTrue([db openAndReturnError: &error], @"Database could not be opened: %@", error);
+    sqlite3 *sqlite = [db sqliteHandle];
+
+    /* Use a capacity smaller than the number of queries, to exercise eviction concurrently with the lock-free path. */
+    PLSqliteStatementCache *cache = [[[PLSqliteStatementCache alloc] initWithCapacity: 4] autorelease];
+    const size_t threads = 8;
+    const int iterations = 10000;
+
+    __block int32_t failures = 0;
+
+    dispatch_apply(threads, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        NSString *query = [NSString stringWithFormat: @"SELECT %zu", i];
+        PLSqliteStatementCacheEntry *entry;
+        const char *unused;
+
+        sqlite3_stmt *stmt = [cache checkoutStatementForQueryString: query cacheEntry: &entry];
+        if (stmt != NULL || sqlite3_prepare_v2(sqlite, [query UTF8String], -1, &stmt, &unused) != SQLITE_OK) {
+            __sync_fetch_and_add(&failures, 1);
+            [entry release];
+            return;
+        }
+        [cache registerStatement: stmt];
+
+        for (int n = 0; n < iterations; n++) {
+            [cache checkinStatement: stmt forCacheEntry: entry];
+
+            /* If our statement was evicted, prepare a new one */
+            stmt = [cache checkoutStatementForCacheEntry: entry];
+            if (stmt == NULL)
+                stmt = [cache checkoutStatementForQueryString: query];
+            if (stmt == NULL) {
+                if (sqlite3_prepare_v2(sqlite, [query UTF8String], -1, &stmt, &unused) != SQLITE_OK) {
+                    __sync_fetch_and_add(&failures, 1);
+                    break;
+                }
+                [cache registerStatement: stmt];
+            }
+        }
+
+        if (stmt != NULL)
+            [cache checkinStatement: stmt forCacheEntry: entry];
+        [entry release];
+    });
+
+    STAssertEquals(failures, (int32_t) 0, @"Failed to prepare statements");
+
+    /* Verify that the cache and database close cleanly; all evicted statements must have been finalized. */
+    [cache close];
+    [db close];
+}
+
 @end
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "PLSqliteStatementCache.h"
+
+@interface PLSqliteStatementHandle : NSObject {
+@private
+    /** The SQL query string. */
+    NSString *_queryString;
+
+    /** The statement cache of the database that vended this handle. */
+    PLSqliteStatementCache *_statementCache;
+
+    /** The statement cache entry for our query string, or nil if statement caching is disabled. */
+    PLSqliteStatementCacheEntry *_cacheEntry;
+}
+
+/** The SQL query string. */
+@property(nonatomic, readonly) NSString *queryString;
+
+@end
+
+#ifdef PL_DB_PRIVATE
+
+@interface PLSqliteStatementHandle (PLSqliteStatementHandleLibraryPrivate)
+
+- (id) initWithQueryString: (NSString *) queryString
+            statementCache: (PLSqliteStatementCache *) statementCache
+                cacheEntry: (PLSqliteStatementCacheEntry *) cacheEntry;
+
+/** The statement cache of the database that vended this handle. */
+@property(nonatomic, readonly) PLSqliteStatementCache *statementCache;
+
+/** The statement cache entry for the handle's query string, or nil if statement caching is disabled. */
+@property(nonatomic, retain) PLSqliteStatementCacheEntry *cacheEntry;
+
+@end
+
+#endif /* PL_DB_PRIVATE */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteStatementHandle.h"
+
+/**
+ * A pre-resolved SQL statement, vended by PLSqliteDatabase::statementHandleForSQL:.
+ *
+ * Preparing a statement via PLSqliteDatabase::prepareStatementWithHandle: re-uses the statement cache lookup
+ * performed when the handle was created, avoiding the cost of hashing and comparing the query string each time
+ * the statement is prepared. Handles are intended to be created once, and then used for the lifetime of
+ * the database connection.
+ *
+ * @par Thread Safety
+ * A handle may only be used with the database that vended it, and is subject to the same thread safety
+ * constraints as that database.
+ */
+@implementation PLSqliteStatementHandle
+
+@synthesize queryString = _queryString;
+
+- (void) dealloc {
+    [_queryString release];
+    [_statementCache release];
+    [_cacheEntry release];
+
+    [super dealloc];
+}
+
+@end
+
+/**
+ * @internal
+ *
+ * Library-private PLSqliteStatementHandle methods.
+ */
+@implementation PLSqliteStatementHandle (PLSqliteStatementHandleLibraryPrivate)
+
+/**
+ * @internal
+ *
+ * Initialize a new statement handle.
+ *
+ * @param queryString The SQL query string.
+ * @param statementCache The statement cache of the database vending this handle.
+ * @param cacheEntry The statement cache entry for @a queryString, or nil if statement caching is disabled.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteStatementHandle class.
+ */
+- (id) initWithQueryString: (NSString *) queryString
+            statementCache: (PLSqliteStatementCache *) statementCache
+                cacheEntry: (PLSqliteStatementCacheEntry *) cacheEntry
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _queryString = [queryString copy];
+    _statementCache = [statementCache retain];
+    _cacheEntry = [cacheEntry retain];
+
+    return self;
+}
+
+- (PLSqliteStatementCache *) statementCache {
+    return _statementCache;
+}
+
+- (PLSqliteStatementCacheEntry *) cacheEntry {
+    return _cacheEntry;
+}
+
+- (void) setCacheEntry: (PLSqliteStatementCacheEntry *) cacheEntry {
+    [cacheEntry retain];
+    [_cacheEntry release];
+    _cacheEntry = cacheEntry;
+}
+
+@end
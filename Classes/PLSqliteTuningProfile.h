@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * SQLite journal modes.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** Leave the journal mode unchanged. */
+    PLSqliteJournalModeDefault = 0,
+
+    /** The rollback journal is deleted at the end of each transaction. */
+    PLSqliteJournalModeDelete = 1,
+
+    /** The rollback journal is truncated at the end of each transaction. */
+    PLSqliteJournalModeTruncate = 2,
+
+    /** The rollback journal header is zeroed at the end of each transaction. */
+    PLSqliteJournalModePersist = 3,
+
+    /** The rollback journal is stored in memory. */
+    PLSqliteJournalModeMemory = 4,
+
+    /** Write-ahead logging. */
+    PLSqliteJournalModeWAL = 5,
+
+    /** No rollback journal. */
+    PLSqliteJournalModeOff = 6
+} PLSqliteJournalMode;
+
+/**
+ * SQLite synchronous modes. The values match those of the SQLite synchronous pragma.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** Leave the synchronous mode unchanged. */
+    PLSqliteSynchronousModeDefault = -1,
+
+    /** Data is handed to the operating system without syncing. */
+    PLSqliteSynchronousModeOff = 0,
+
+    /** Sync at critical moments. In WAL mode, committed transactions may roll back after a power loss. */
+    PLSqliteSynchronousModeNormal = 1,
+
+    /** Sync on every commit. */
+    PLSqliteSynchronousModeFull = 2,
+
+    /** As PLSqliteSynchronousModeFull, additionally syncing the directory after unlinking a rollback journal. */
+    PLSqliteSynchronousModeExtra = 3
+} PLSqliteSynchronousMode;
+
+/**
+ * SQLite temporary storage locations. The values match those of the SQLite temp_store pragma.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** Use the compile-time default. */
+    PLSqliteTempStoreDefault = 0,
+
+    /** Temporary tables and indices are stored in files. */
+    PLSqliteTempStoreFile = 1,
+
+    /** Temporary tables and indices are stored in memory. */
+    PLSqliteTempStoreMemory = 2
+} PLSqliteTempStore;
+
+/**
+ * SQLite locking modes.
+ *
+ * @ingroup enums
+ */
+typedef enum {
+    /** Leave the locking mode unchanged. */
+    PLSqliteLockingModeDefault = 0,
+
+    /** Locks are released at the end of each transaction. */
+    PLSqliteLockingModeNormal = 1,
+
+    /** Locks are never released; no other connection may access the database. */
+    PLSqliteLockingModeExclusive = 2
+} PLSqliteLockingMode;
+
+@interface PLSqliteTuningProfile : NSObject <NSCopying> {
+@private
+    /** Journal mode. */
+    PLSqliteJournalMode _journalMode;
+
+    /** Synchronous mode. */
+    PLSqliteSynchronousMode _synchronousMode;
+
+    /** Maximum memory-mapped I/O size, or nil. */
+    NSNumber *_mmapSize;
+
+    /** Page cache size, or nil. */
+    NSNumber *_cacheSize;
+
+    /** Temporary storage location. */
+    PLSqliteTempStore _tempStore;
+
+    /** Page size, or nil. */
+    NSNumber *_pageSize;
+
+    /** WAL auto-checkpoint threshold, or nil. */
+    NSNumber *_walAutocheckpoint;
+
+    /** Locking mode. */
+    PLSqliteLockingMode _lockingMode;
+}
+
++ (id) profile;
++ (id) throughputProfile;
++ (id) durableProfile;
+
+/** The journal mode. Defaults to PLSqliteJournalModeDefault. */
+@property(nonatomic, assign) PLSqliteJournalMode journalMode;
+
+/** The synchronous mode. Defaults to PLSqliteSynchronousModeDefault. */
+@property(nonatomic, assign) PLSqliteSynchronousMode synchronousMode;
+
+/** The maximum number of bytes of the database that will be accessed using memory-mapped I/O, or nil to leave
+ * the setting unchanged. 0 disables memory-mapped I/O. SQLite may silently clamp this value to its compile-time
+ * maximum. Memory-mapped I/O requires SQLite 3.7.17 or later; on earlier versions this setting is ignored, and is
+ * read back as nil. */
+@property(nonatomic, retain) NSNumber *mmapSize;
+
+/** The page cache size; a positive value is a number of pages, and a negative value a number of KiB. nil leaves
+ * the setting unchanged. */
+@property(nonatomic, retain) NSNumber *cacheSize;
+
+/** The temporary storage location. Defaults to PLSqliteTempStoreDefault. */
+@property(nonatomic, assign) PLSqliteTempStore tempStore;
+
+/** The page size, a power of two between 512 and 65536, or nil to leave the setting unchanged. The page size only
+ * applies to a newly created database. */
+@property(nonatomic, retain) NSNumber *pageSize;
+
+/** The number of WAL pages after which an automatic checkpoint is run, 0 to disable automatic checkpoints, or nil
+ * to leave the setting unchanged. */
+@property(nonatomic, retain) NSNumber *walAutocheckpoint;
+
+/** The locking mode. Defaults to PLSqliteLockingModeDefault. */
+@property(nonatomic, assign) PLSqliteLockingMode lockingMode;
+
+@end
+
+#ifdef PL_DB_PRIVATE
+
+NSString *PLSqliteJournalModeName (PLSqliteJournalMode mode);
+PLSqliteJournalMode PLSqliteJournalModeForName (NSString *name);
+
+NSString *PLSqliteLockingModeName (PLSqliteLockingMode mode);
+PLSqliteLockingMode PLSqliteLockingModeForName (NSString *name);
+
+#endif /* PL_DB_PRIVATE */
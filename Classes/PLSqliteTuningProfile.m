@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "PLSqliteTuningProfile.h"
+
+#import "PLDatabaseConstants.h"
+
+/** SQLite journal mode names, indexed by PLSqliteJournalMode. */
+static NSString *PLSqliteJournalModeNames[] = { nil, @"delete", @"truncate", @"persist", @"memory", @"wal", @"off" };
+
+/** SQLite locking mode names, indexed by PLSqliteLockingMode. */
+static NSString *PLSqliteLockingModeNames[] = { nil, @"normal", @"exclusive" };
+
+/**
+ * @internal
+ * Return the SQLite name of @a mode, or nil for PLSqliteJournalModeDefault.
+ */
+NSString *PLSqliteJournalModeName (PLSqliteJournalMode mode) {
+    return PLSqliteJournalModeNames[mode];
+}
+
+/**
+ * @internal
+ * Return the journal mode with the given SQLite name, or PLSqliteJournalModeDefault if the name is unknown.
+ */
+PLSqliteJournalMode PLSqliteJournalModeForName (NSString *name) {
+    for (int i = PLSqliteJournalModeDelete; i <= PLSqliteJournalModeOff; i++) {
+        if ([PLSqliteJournalModeNames[i] caseInsensitiveCompare: name] == NSOrderedSame)
+            return (PLSqliteJournalMode) i;
+    }
+    return PLSqliteJournalModeDefault;
+}
+
+/**
+ * @internal
+ * Return the SQLite name of @a mode, or nil for PLSqliteLockingModeDefault.
+ */
+NSString *PLSqliteLockingModeName (PLSqliteLockingMode mode) {
+    return PLSqliteLockingModeNames[mode];
+}
+
+/**
+ * @internal
+ * Return the locking mode with the given SQLite name, or PLSqliteLockingModeDefault if the name is unknown.
+ */
+PLSqliteLockingMode PLSqliteLockingModeForName (NSString *name) {
+    for (int i = PLSqliteLockingModeNormal; i <= PLSqliteLockingModeExclusive; i++) {
+        if ([PLSqliteLockingModeNames[i] caseInsensitiveCompare: name] == NSOrderedSame)
+            return (PLSqliteLockingMode) i;
+    }
+    return PLSqliteLockingModeDefault;
+}
+
+
+/**
+ * A typed set of SQLite connection tuning settings, applied when a PLSqliteDatabase is opened.
+ *
+ * Each setting defaults to leaving SQLite's own default in place. A profile is assigned via
+ * PLSqliteDatabaseOptions::tuningProfile; when the database is opened, the settings are applied and read back, and
+ * if any setting is not honored by SQLite -- for example, WAL journaling requested for an in-memory database -- the
+ * open fails and the connection is closed. The journal mode and page size, which are written to the database file,
+ * are applied after all other settings, so that a failed open leaves the database file unchanged. The settings in
+ * effect on an open connection may be read back with PLSqliteDatabase::tuningProfileAndReturnError:.
+ *
+ * Invalid values are programmer error, and are rejected by the property setters with a PLDatabaseException.
+ *
+ * @par Presets
+ * - throughputProfile: WAL journaling, NORMAL synchronous mode, 256 MiB of memory-mapped I/O (where supported by
+ *   SQLite), a 64 MiB page cache, in-memory temporary storage, and infrequent WAL checkpoints. Transactions
+ *   committed shortly before a power loss may be rolled back.
+ * - durableProfile: WAL journaling, FULL synchronous mode, and no memory-mapped I/O. Committed transactions survive a
+ *   power loss.
+ *
+ * @par Thread Safety
+ * PLSqliteTuningProfile instances implement no locking and must not be mutated while shared between threads.
+ */
+@implementation PLSqliteTuningProfile
+
+@synthesize journalMode = _journalMode;
+@synthesize synchronousMode = _synchronousMode;
+@synthesize mmapSize = _mmapSize;
+@synthesize cacheSize = _cacheSize;
+@synthesize tempStore = _tempStore;
+@synthesize pageSize = _pageSize;
+@synthesize walAutocheckpoint = _walAutocheckpoint;
+@synthesize lockingMode = _lockingMode;
+
+/**
+ * Return a new, empty profile, which leaves all settings unchanged.
+ */
++ (id) profile {
+    return [[[self alloc] init] autorelease];
+}
+
+/**
+ * Return a new profile tuned for write throughput, at the cost of durability on power loss.
+ */
++ (id) throughputProfile {
+    PLSqliteTuningProfile *profile = [self profile];
+    profile.journalMode = PLSqliteJournalModeWAL;
+    profile.synchronousMode = PLSqliteSynchronousModeNormal;
+    profile.mmapSize = [NSNumber numberWithLongLong: 256 * 1024 * 1024];
+    profile.cacheSize = [NSNumber numberWithInt: -64 * 1024];
+    profile.tempStore = PLSqliteTempStoreMemory;
+    profile.walAutocheckpoint = [NSNumber numberWithInt: 10000];
+    return profile;
+}
+
+/**
+ * Return a new profile tuned for durability.
+ */
++ (id) durableProfile {
+    PLSqliteTuningProfile *profile = [self profile];
+    profile.journalMode = PLSqliteJournalModeWAL;
+    profile.synchronousMode = PLSqliteSynchronousModeFull;
+    profile.mmapSize = [NSNumber numberWithLongLong: 0];
+    profile.walAutocheckpoint = [NSNumber numberWithInt: 1000];
+    return profile;
+}
+
+/**
+ * Initialize a new, empty profile.
+ *
+ * @par Designated Initializer
+ * This method is the designated initializer for the PLSqliteTuningProfile class.
+ */
+- (id) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _journalMode = PLSqliteJournalModeDefault;
+    _synchronousMode = PLSqliteSynchronousModeDefault;
+    _tempStore = PLSqliteTempStoreDefault;
+    _lockingMode = PLSqliteLockingModeDefault;
+
+    return self;
+}
+
+- (void) dealloc {
+    [_mmapSize release];
+    [_cacheSize release];
+    [_pageSize release];
+    [_walAutocheckpoint release];
+
+    [super dealloc];
+}
+
+- (void) setJournalMode: (PLSqliteJournalMode) journalMode {
+    if (journalMode < PLSqliteJournalModeDefault || journalMode > PLSqliteJournalModeOff)
+        [NSException raise: PLDatabaseException format: @"Invalid journal mode %d", (int) journalMode];
+
+    _journalMode = journalMode;
+}
+
+- (void) setSynchronousMode: (PLSqliteSynchronousMode) synchronousMode {
+    if (synchronousMode < PLSqliteSynchronousModeDefault || synchronousMode > PLSqliteSynchronousModeExtra)
+        [NSException raise: PLDatabaseException format: @"Invalid synchronous mode %d", (int) synchronousMode];
+
+    _synchronousMode = synchronousMode;
+}
+
+- (void) setMmapSize: (NSNumber *) mmapSize {
+    if (mmapSize != nil && [mmapSize longLongValue] < 0)
+        [NSException raise: PLDatabaseException format: @"Invalid mmap size %@", mmapSize];
+
+    [mmapSize retain];
+    [_mmapSize release];
+    _mmapSize = mmapSize;
+}
+
+- (void) setTempStore: (PLSqliteTempStore) tempStore {
+    if (tempStore < PLSqliteTempStoreDefault || tempStore > PLSqliteTempStoreMemory)
+        [NSException raise: PLDatabaseException format: @"Invalid temp store %d", (int) tempStore];
+
+    _tempStore = tempStore;
+}
+
+- (void) setPageSize: (NSNumber *) pageSize {
+    if (pageSize != nil) {
+        long long size = [pageSize longLongValue];
+        if (size < 512 || size > 65536 || (size & (size - 1)) != 0)
+            [NSException raise: PLDatabaseException
+                        format: @"Invalid page size %@; must be a power of two between 512 and 65536", pageSize];
+    }
+
+    [pageSize retain];
+    [_pageSize release];
+    _pageSize = pageSize;
+}
+
+- (void) setWalAutocheckpoint: (NSNumber *) walAutocheckpoint {
+    if (walAutocheckpoint != nil && [walAutocheckpoint intValue] < 0)
+        [NSException raise: PLDatabaseException format: @"Invalid WAL auto-checkpoint threshold %@", walAutocheckpoint];
+
+    [walAutocheckpoint retain];
+    [_walAutocheckpoint release];
+    _walAutocheckpoint = walAutocheckpoint;
+}
+
+- (void) setLockingMode: (PLSqliteLockingMode) lockingMode {
+    if (lockingMode < PLSqliteLockingModeDefault || lockingMode > PLSqliteLockingModeExclusive)
+        [NSException raise: PLDatabaseException format: @"Invalid locking mode %d", (int) lockingMode];
+
+    _lockingMode = lockingMode;
+}
+
+// from NSObject
+- (BOOL) isEqual: (id) object {
+    if (![object isKindOfClass: [PLSqliteTuningProfile class]])
+        return NO;
+
+    PLSqliteTuningProfile *other = object;
+    return _journalMode == other->_journalMode &&
+        _synchronousMode == other->_synchronousMode &&
+        (_mmapSize == other->_mmapSize || [_mmapSize isEqual: other->_mmapSize]) &&
+        (_cacheSize == other->_cacheSize || [_cacheSize isEqual: other->_cacheSize]) &&
+        _tempStore == other->_tempStore &&
+        (_pageSize == other->_pageSize || [_pageSize isEqual: other->_pageSize]) &&
+        (_walAutocheckpoint == other->_walAutocheckpoint || [_walAutocheckpoint isEqual: other->_walAutocheckpoint]) &&
+        _lockingMode == other->_lockingMode;
+}
+
+// from NSObject
+- (NSUInteger) hash {
+    return (NSUInteger) _journalMode ^ ((NSUInteger) _synchronousMode << 4) ^ [_cacheSize hash] ^ [_mmapSize hash];
+}
+
+// from NSObject
+- (NSString *) description {
+    return [NSString stringWithFormat: @"<%@: journal_mode=%@ synchronous=%d mmap_size=%@ cache_size=%@ temp_store=%d "
+            "page_size=%@ wal_autocheckpoint=%@ locking_mode=%@>", [self class], PLSqliteJournalModeName(_journalMode),
+            (int) _synchronousMode, _mmapSize, _cacheSize, (int) _tempStore, _pageSize, _walAutocheckpoint,
+            PLSqliteLockingModeName(_lockingMode)];
+}
+
+// from NSCopying protocol
+- (id) copyWithZone: (NSZone *) zone {
+    PLSqliteTuningProfile *copy = [[[self class] allocWithZone: zone] init];
+
+    copy->_journalMode = _journalMode;
+    copy->_synchronousMode = _synchronousMode;
+    copy->_mmapSize = [_mmapSize retain];
+    copy->_cacheSize = [_cacheSize retain];
+    copy->_tempStore = _tempStore;
+    copy->_pageSize = [_pageSize retain];
+    copy->_walAutocheckpoint = [_walAutocheckpoint retain];
+    copy->_lockingMode = _lockingMode;
+
+    return copy;
+}
+
+@end
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "PlausibleDatabase.h"
+
+@interface PLSqliteTuningProfileTests : SenTestCase {
+@private
+    NSString *_dbPath;
+}
+@end
+
+@implementation PLSqliteTuningProfileTests
+
+- (void) setUp {
+    /* Create a temporary file for the database. Secure -- user owns enclosing directory. */
+    _dbPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+}
+
+- (void) tearDown {
+    /* Remove the temporary database files */
+    NSFileManager *fm = [NSFileManager defaultManager];
+    for (NSString *suffix in [NSArray arrayWithObjects: @"", @"-wal", @"-shm", nil]) {
+        NSString *path = [_dbPath stringByAppendingString: suffix];
+        if ([fm fileExistsAtPath: path])
+            STAssertTrue([fm removeItemAtPath: path error: NULL], @"Could not clean up database %@", path);
+    }
+
+    [_dbPath release];
+}
+
+- (void) testDefaults {
+    PLSqliteTuningProfile *profile = [PLSqliteTuningProfile profile];
+
+    STAssertEquals(PLSqliteJournalModeDefault, [profile journalMode], @"Journal mode should be unset");
+    STAssertEquals(PLSqliteSynchronousModeDefault, [profile synchronousMode], @"Synchronous mode should be unset");
+    STAssertNil([profile mmapSize], @"mmap size should be unset");
+    STAssertNil([profile cacheSize], @"Cache size should be unset");
+    STAssertEquals(PLSqliteTempStoreDefault, [profile tempStore], @"Temp store should be unset");
+    STAssertNil([profile pageSize], @"Page size should be unset");
+    STAssertNil([profile walAutocheckpoint], @"WAL auto-checkpoint should be unset");
+    STAssertEquals(PLSqliteLockingModeDefault, [profile lockingMode], @"Locking mode should be unset");
+
+    STAssertNil([[PLSqliteDatabaseOptions defaultOptions] tuningProfile], @"Options should not have a default profile");
+}
+
+- (void) testPresets {
+    PLSqliteTuningProfile *throughput = [PLSqliteTuningProfile throughputProfile];
+    STAssertEquals(PLSqliteJournalModeWAL, [throughput journalMode], @"Incorrect journal mode");
+    STAssertEquals(PLSqliteSynchronousModeNormal, [throughput synchronousMode], @"Incorrect synchronous mode");
+
+    PLSqliteTuningProfile *durable = [PLSqliteTuningProfile durableProfile];
+    STAssertEquals(PLSqliteJournalModeWAL, [durable journalMode], @"Incorrect journal mode");
+    STAssertEquals(PLSqliteSynchronousModeFull, [durable synchronousMode], @"Incorrect synchronous mode");
+
+    STAssertFalse([throughput isEqual: durable], @"Presets should differ");
+}
+
+- (void) testCopy {
+    PLSqliteTuningProfile *profile = [PLSqliteTuningProfile throughputProfile];
+    profile.pageSize = [NSNumber numberWithInt: 8192];
+    profile.lockingMode = PLSqliteLockingModeExclusive;
+
+    PLSqliteTuningProfile *copy = [[profile copy] autorelease];
+    STAssertEqualObjects(profile, copy, @"Copy is not equal");
+    STAssertEqualObjects([NSNumber numberWithInt: 8192], [copy pageSize], @"Page size not copied");
+    STAssertEquals(PLSqliteLockingModeExclusive, [copy lockingMode], @"Locking mode not copied");
+}
+
+- (void) testValidation {
+    PLSqliteTuningProfile *profile = [PLSqliteTuningProfile profile];
+
+    STAssertThrows(profile.pageSize = [NSNumber numberWithInt: 1000], @"Page size must be a power of two");
+    STAssertThrows(profile.pageSize = [NSNumber numberWithInt: 256], @"Page size must be at least 512");
+    STAssertThrows(profile.mmapSize = [NSNumber numberWithInt: -1], @"mmap size must not be negative");
+    STAssertThrows(profile.walAutocheckpoint = [NSNumber numberWithInt: -1], @"WAL auto-checkpoint must not be negative");
+    STAssertThrows(profile.synchronousMode = (PLSqliteSynchronousMode) 7, @"Synchronous mode must be valid");
+
+    STAssertNoThrow(profile.pageSize = [NSNumber numberWithInt: 4096], @"Valid page size rejected");
+    STAssertNoThrow(profile.pageSize = nil, @"Page size could not be unset");
+}
+
+- (void) testApplyAtOpen {
+    PLSqliteTuningProfile *profile = [PLSqliteTuningProfile throughputProfile];
+    profile.pageSize = [NSNumber numberWithInt: 8192];
+
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.tuningProfile = profile;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: _dbPath options: options];
+    NSError *error;
+    STAssertTrue([db openAndReturnError: &error], @"Could not open database: %@", error);
+
+    /* Read back the settings */
+    PLSqliteTuningProfile *current = [db tuningProfileAndReturnError: &error];
+    STAssertNotNil(current, @"Could not read back settings: %@", error);
+    STAssertEquals(PLSqliteJournalModeWAL, [current journalMode], @"Journal mode not applied");
+    STAssertEquals(PLSqliteSynchronousModeNormal, [current synchronousMode], @"Synchronous mode not applied");
+    STAssertEqualObjects([profile cacheSize], [current cacheSize], @"Cache size not applied");
+    STAssertEquals(PLSqliteTempStoreMemory, [current tempStore], @"Temp store not applied");
+    STAssertEqualObjects([NSNumber numberWithLongLong: 8192], [current pageSize], @"Page size not applied");
+    STAssertEqualObjects([NSNumber numberWithInt: 10000], [current walAutocheckpoint], @"WAL auto-checkpoint not applied");
+    STAssertEquals(PLSqliteLockingModeNormal, [current lockingMode], @"Unexpected locking mode");
+    if (sqlite3_libversion_number() >= 3007017)
+        STAssertEqualObjects([profile mmapSize], [current mmapSize], @"mmap size not applied");
+    else
+        STAssertNil([current mmapSize], @"mmap size is unsupported, and should not be read back");
+
+    [db close];
+}
+
+- (void) testRejectedSetting {
+    PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+    options.tuningProfile = [PLSqliteTuningProfile durableProfile];
+
+    /* In-memory databases can not use WAL journaling; the open must fail, rather than return a connection with a different journal mode */
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+    NSError *error = nil;
+    STAssertFalse([db openAndReturnError: &error], @"Open should fail when a setting is not honored");
+    STAssertNotNil(error, @"No error returned");
+    STAssertEquals(PLDatabaseErrorQueryFailed, (PLDatabaseError) [error code], @"Unexpected error code");
+    STAssertFalse([db goodConnection], @"Connection should be closed");
+}
+
+@end
@@ -52,14 +52,24 @@
 
 /* Library Includes */
 #import "PLDatabaseConstants.h"
+#import "PLRowMapping.h"
 #import "PLResultSet.h"
 #import "PLPreparedStatement.h"
 #import "PLDatabase.h"
+#import "PLAsyncDatabase.h"
 
+#import "PLSqliteErrorSink.h"
+#import "PLSqliteRetryPolicy.h"
+#import "PLSqliteBusyPolicy.h"
+#import "PLSqliteTuningProfile.h"
+#import "PLSqliteDatabaseOptions.h"
+#import "PLSqliteStatementHandle.h"
 #import "PLSqliteDatabase.h"
+#import "PLGroupCommitWriter.h"
 #import "PLSqliteStatementCache.h"
 #import "PLSqlitePreparedStatement.h"
 #import "PLSqliteResultSet.h"
+#import "PLSqliteResultSetFastAccess.h"
 
 #import "PLDatabaseConnectionProvider.h"
 
@@ -68,6 +78,7 @@
 #import "PLDatabaseMigrationConnectionProvider.h"
 
 #import "PLSqliteConnectionProvider.h"
+#import "PLSqliteReadWriteConnectionProvider.h"
 
 #import "PLDatabaseMigrationVersionManager.h"
 #import "PLDatabaseMigrationTransactionManager.h"
@@ -0,0 +1,916 @@
+/*
+ * Copyright (c) 2012 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+#import <time.h>
+
+#import "PlausibleDatabase.h"
+#import "PLSqliteStatementCache.h"
+
+/**
+ * @internal
+ *
+ * Micro-benchmarks for the core PLSqliteDatabase query path.
+ *
+ * Each benchmark is run PL_BENCH_RUNS times; each run repeatedly invokes the benchmark body until at least
+ * PL_BENCH_MIN_RUN_NS has elapsed. The fastest run is reported, which is considerably more repeatable than the
+ * mean on a shared machine. Results are printed one per line so that two runs may be compared with diff(1).
+ *
+ * Usage: PLDatabaseBenchmark [name-filter]
+ */
+
+/** Number of timed runs per benchmark. */
+#define PL_BENCH_RUNS 5
+
+/** Minimum duration of a single timed run, in nanoseconds. */
+#define PL_BENCH_MIN_RUN_NS (200ULL * 1000ULL * 1000ULL)
+
+/** Number of rows inserted per invocation of the update benchmark. */
+#define PL_BENCH_UPDATE_BATCH 1000
+
+/** Rows fetched per call by the columnar fetch benchmark. */
+#define PL_BENCH_FETCH_CHUNK 256
+
+/** Statement check-ins performed by each thread per run of the statement cache contention benchmarks. */
+#define PL_BENCH_CONTENTION_OPS 100000
+
+/** Number of durable (file-backed) writes issued per thread by the group commit benchmarks. */
+#define PL_BENCH_WRITE_OPS 100
+
+/** Number of point reads issued per thread by the read pool benchmarks. */
+#define PL_BENCH_READ_OPS 20000
+
+/** Number of failing statements executed per thread by the error path benchmarks. */
+#define PL_BENCH_ERROR_OPS 10000
+
+/** Result row counts to benchmark. */
+static const int PLBenchRowCounts[] = { 100, 10000 };
+
+/** TEXT/BLOB column widths (in bytes) to benchmark. */
+static const int PLBenchColumnWidths[] = { 16, 1024 };
+
+/** Thread counts for the statement cache contention benchmarks. */
+static const int PLBenchThreadCounts[] = { 1, 2, 4, 8 };
+
+/** Optional benchmark name filter. */
+static const char *pl_bench_filter = NULL;
+
+/* Return the current monotonic time, in nanoseconds. */
+static uint64_t pl_bench_now_ns (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Time @a block, reporting the best observed cost per operation.
+ *
+ * @param name Benchmark name.
+ * @param rows Fixture row count.
+ * @param width Fixture TEXT/BLOB column width.
+ * @param opsPerInvocation The number of operations performed by a single invocation of @a block.
+ * @param block The benchmark body.
+ */
+static void pl_bench_run (const char *name, int rows, int width, uint64_t opsPerInvocation, void (^block)(void)) {
+    if (pl_bench_filter != NULL && strstr(name, pl_bench_filter) == NULL)
+        return;
+
+    double best = 0;
+    for (int run = 0; run < PL_BENCH_RUNS; run++) {
+        uint64_t invocations = 0;
+        uint64_t start = pl_bench_now_ns();
+        uint64_t elapsed;
+
+        do {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            block();
+            [pool drain];
+
+            invocations++;
+            elapsed = pl_bench_now_ns() - start;
+        } while (elapsed < PL_BENCH_MIN_RUN_NS);
+
+        double nsPerOp = (double) elapsed / (double) (invocations * opsPerInvocation);
+        if (run == 0 || nsPerOp < best)
+            best = nsPerOp;
+    }
+
+    printf("%-36s rows=%-6d width=%-5d %10.1f ns/op %12.0f ops/sec\n", name, rows, width, best, 1e9 / best);
+    fflush(stdout);
+}
+
+/* pthread entry point for pl_bench_run_threads(); invokes the block with its thread index. */
+struct pl_bench_thread {
+    void (^block)(int thread);
+    int index;
+};
+
+static void *pl_bench_thread_main (void *arg) {
+    struct pl_bench_thread *ctx = arg;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    ctx->block(ctx->index);
+    [pool drain];
+    return NULL;
+}
+
+/*
+ * Time @a block running concurrently on @a threads threads, reporting the best observed aggregate cost per operation.
+ *
+ * @param name Benchmark name.
+ * @param threads Number of threads.
+ * @param opsPerThread The number of operations performed by a single invocation of @a block.
+ * @param block The benchmark body, invoked once on each thread with the thread's index.
+ */
+static void pl_bench_run_threads (const char *name, int threads, uint64_t opsPerThread, void (^block)(int thread)) {
+    if (pl_bench_filter != NULL && strstr(name, pl_bench_filter) == NULL)
+        return;
+
+    pthread_t tids[threads];
+    struct pl_bench_thread ctx[threads];
+
+    double best = 0;
+    for (int run = 0; run < PL_BENCH_RUNS; run++) {
+        uint64_t start = pl_bench_now_ns();
+        for (int i = 0; i < threads; i++) {
+            ctx[i].block = block;
+            ctx[i].index = i;
+            if (pthread_create(&tids[i], NULL, pl_bench_thread_main, &ctx[i]) != 0) {
+                fprintf(stderr, "Could not create benchmark thread\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        for (int i = 0; i < threads; i++)
+            pthread_join(tids[i], NULL);
+
+        double nsPerOp = (double) (pl_bench_now_ns() - start) / (double) (opsPerThread * threads);
+        if (run == 0 || nsPerOp < best)
+            best = nsPerOp;
+    }
+
+    printf("%-36s threads=%-3d %22.1f ns/op %12.0f ops/sec\n", name, threads, best, 1e9 / best);
+    fflush(stdout);
+}
+
+/* Return a string of exactly @a width ASCII characters. */
+static NSString *pl_bench_string (int width) {
+    NSMutableString *str = [NSMutableString stringWithCapacity: width];
+    for (int i = 0; i < width; i++)
+        [str appendFormat: @"%c", 'a' + (i % 26)];
+    return str;
+}
+
+/* Return @a width bytes of data. */
+static NSData *pl_bench_data (int width) {
+    NSMutableData *data = [NSMutableData dataWithLength: width];
+    uint8_t *bytes = [data mutableBytes];
+    for (int i = 0; i < width; i++)
+        bytes[i] = (uint8_t) i;
+    return data;
+}
+
+/*
+ * Create an in-memory database containing a 'bench' table populated with @a rows rows, each with INTEGER, REAL, TEXT
+ * and BLOB columns (the latter two @a width bytes wide), and a NULL column. An empty 'bench_insert' table with the same
+ * layout is also created for the update benchmarks.
+ */
+static PLSqliteDatabase *pl_bench_fixture (int rows, int width) {
+    NSError *error;
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    if (![db openAndReturnError: &error]) {
+        fprintf(stderr, "Could not open benchmark database: %s\n", [[error description] UTF8String]);
+        exit(EXIT_FAILURE);
+    }
+
+    NSString *schema = @"(id INTEGER PRIMARY KEY, i INTEGER, d REAL, t TEXT, b BLOB, n INTEGER)";
+    if (![db executeUpdateAndReturnError: &error statement: [@"CREATE TABLE bench " stringByAppendingString: schema]] ||
+        ![db executeUpdateAndReturnError: &error statement: [@"CREATE TABLE bench_insert " stringByAppendingString: schema]])
+    {
+        fprintf(stderr, "Could not create benchmark tables: %s\n", [[error description] UTF8String]);
+        exit(EXIT_FAILURE);
+    }
+
+    NSString *text = pl_bench_string(width);
+    NSData *blob = pl_bench_data(width);
+
+    [db beginTransaction];
+    id<PLPreparedStatement> stmt = [db prepareStatement: @"INSERT INTO bench (i, d, t, b, n) VALUES (?, ?, ?, ?, ?)"];
+    for (int i = 0; i < rows; i++) {
+        [stmt bindParameters: [NSArray arrayWithObjects: [NSNumber numberWithInt: i], [NSNumber numberWithDouble: i * 1.5],
+                               text, blob, [NSNull null], nil]];
+        if (![stmt executeUpdateAndReturnError: &error]) {
+            fprintf(stderr, "Could not populate benchmark table: %s\n", [[error description] UTF8String]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    [stmt close];
+    [db commitTransaction];
+
+    return db;
+}
+
+/* -[PLSqliteDatabase executeQuery:], fetching and closing a single row by primary key. */
+static void pl_bench_execute_query (PLSqliteDatabase *db, int rows, int width) {
+    __block int key = 0;
+    pl_bench_run("executeQuery (point lookup)", rows, width, 1, ^{
+        id<PLResultSet> rs = [db executeQuery: @"SELECT i, d, t, b FROM bench WHERE id = ?", [NSNumber numberWithInt: (key++ % rows) + 1]];
+        [rs nextAndReturnError: NULL];
+        [rs close];
+    });
+}
+
+/* -[PLSqlitePreparedStatement executeUpdateAndReturnError:], inserting PL_BENCH_UPDATE_BATCH rows per transaction. */
+static void pl_bench_execute_update (PLSqliteDatabase *db, int rows, int width) {
+    NSArray *params = [NSArray arrayWithObjects: [NSNumber numberWithInt: 42], [NSNumber numberWithDouble: 42.5],
+                       pl_bench_string(width), pl_bench_data(width), [NSNull null], nil];
+
+    pl_bench_run("executeUpdateAndReturnError", rows, width, PL_BENCH_UPDATE_BATCH, ^{
+        id<PLPreparedStatement> stmt = [db prepareStatement: @"INSERT INTO bench_insert (i, d, t, b, n) VALUES (?, ?, ?, ?, ?)"];
+        [db beginTransaction];
+        for (int i = 0; i < PL_BENCH_UPDATE_BATCH; i++) {
+            [stmt bindParameters: params];
+            [stmt executeUpdateAndReturnError: NULL];
+        }
+        [db commitTransaction];
+        [stmt close];
+
+        [db executeUpdate: @"DELETE FROM bench_insert"];
+    });
+}
+
+/* As pl_bench_execute_update(), binding each row by name with -bindParameterDictionary:. */
+static void pl_bench_execute_update_named (PLSqliteDatabase *db, int rows, int width) {
+    NSDictionary *params = [NSDictionary dictionaryWithObjectsAndKeys: [NSNumber numberWithInt: 42], @"i", [NSNumber numberWithDouble: 42.5], @"d",
+                            pl_bench_string(width), @"t", pl_bench_data(width), @"b", [NSNull null], @"n", nil];
+
+    pl_bench_run("executeUpdate (named)", rows, width, PL_BENCH_UPDATE_BATCH, ^{
+        id<PLPreparedStatement> stmt = [db prepareStatement: @"INSERT INTO bench_insert (i, d, t, b, n) VALUES (:i, :d, :t, :b, :n)"];
+        [db beginTransaction];
+        for (int i = 0; i < PL_BENCH_UPDATE_BATCH; i++) {
+            [stmt bindParameterDictionary: params];
+            [stmt executeUpdateAndReturnError: NULL];
+        }
+        [db commitTransaction];
+        [stmt close];
+
+        [db executeUpdate: @"DELETE FROM bench_insert"];
+    });
+}
+
+/* As pl_bench_execute_update(), binding each row with the typed, unboxed binding methods in the given binding mode. */
+static void pl_bench_execute_update_typed (PLSqliteDatabase *db, const char *name, int rows, int width, PLPreparedStatementBindingMode bindingMode) {
+    NSString *string = pl_bench_string(width);
+    NSData *data = pl_bench_data(width);
+    const char *text = [string UTF8String];
+    int textLength = (int) strlen(text);
+
+    pl_bench_run(name, rows, width, PL_BENCH_UPDATE_BATCH, ^{
+        id<PLPreparedStatement> stmt = [db prepareStatement: @"INSERT INTO bench_insert (i, d, t, b, n) VALUES (?, ?, ?, ?, ?)"];
+        [stmt setBindingMode: bindingMode];
+        [db beginTransaction];
+        for (int i = 0; i < PL_BENCH_UPDATE_BATCH; i++) {
+            [stmt bindInt64: 42 atIndex: 0];
+            [stmt bindDouble: 42.5 atIndex: 1];
+            [stmt bindUTF8: text length: textLength atIndex: 2];
+            [stmt bindBlob: [data bytes] length: (int) [data length] atIndex: 3];
+            [stmt bindNullAtIndex: 4];
+            [stmt executeUpdateAndReturnError: NULL];
+        }
+        [db commitTransaction];
+        [stmt close];
+
+        [db executeUpdate: @"DELETE FROM bench_insert"];
+    });
+}
+
+/* -[PLSqlitePreparedStatement executeBatch:inTransaction:failedRowIndexes:error:], inserting PL_BENCH_UPDATE_BATCH rows per batch. */
+static void pl_bench_execute_batch (PLSqliteDatabase *db, int rows, int width) {
+    NSArray *params = [NSArray arrayWithObjects: [NSNumber numberWithInt: 42], [NSNumber numberWithDouble: 42.5],
+                       pl_bench_string(width), pl_bench_data(width), [NSNull null], nil];
+    NSMutableArray *batch = [NSMutableArray arrayWithCapacity: PL_BENCH_UPDATE_BATCH];
+    for (int i = 0; i < PL_BENCH_UPDATE_BATCH; i++)
+        [batch addObject: params];
+
+    pl_bench_run("executeBatch", rows, width, PL_BENCH_UPDATE_BATCH, ^{
+        id<PLPreparedStatement> stmt = [db prepareStatement: @"INSERT INTO bench_insert (i, d, t, b, n) VALUES (?, ?, ?, ?, ?)"];
+        [stmt executeBatch: batch inTransaction: YES failedRowIndexes: NULL error: NULL];
+        [stmt close];
+
+        [db executeUpdate: @"DELETE FROM bench_insert"];
+    });
+}
+
+/* Iterate every row of the 'bench' table, calling @a accessor for each row. Reports the per-row cost. */
+static void pl_bench_scan (PLSqliteDatabase *db, const char *name, int rows, int width, void (^accessor)(id<PLResultSet> rs)) {
+    pl_bench_run(name, rows, width, rows, ^{
+        id<PLResultSet> rs = [db executeQuery: @"SELECT id, i, d, t, b, n FROM bench"];
+        while ([rs nextAndReturnError: NULL] == PLResultSetStatusRow)
+            accessor(rs);
+        [rs close];
+    });
+}
+
+/* As pl_bench_scan(), initializing a PLSqliteResultSetFastAccess once per result set for use by @a accessor. */
+static void pl_bench_fast_scan (PLSqliteDatabase *db, const char *name, int rows, int width, void (^accessor)(PLSqliteResultSetFastAccess *fa)) {
+    pl_bench_run(name, rows, width, rows, ^{
+        PLSqliteResultSetFastAccess fa;
+        id<PLResultSet> rs = [db executeQuery: @"SELECT id, i, d, t, b, n FROM bench"];
+        PLSqliteResultSetFastAccessInit(&fa, rs, 6);
+        while ([rs nextAndReturnError: NULL] == PLResultSetStatusRow)
+            accessor(&fa);
+        [rs close];
+    });
+}
+
+/* -[PLSqliteResultSet nextAndReturnError:] and the typed value accessors. */
+static void pl_bench_result_set (PLSqliteDatabase *db, int rows, int width) {
+    /* Baseline; subtract from the accessor results below to determine the per-cell accessor cost. */
+    pl_bench_scan(db, "nextAndReturnError", rows, width, ^(id<PLResultSet> rs) {});
+
+    pl_bench_scan(db, "intForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs intForColumnIndex: 1]; });
+    pl_bench_scan(db, "bigIntForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs bigIntForColumnIndex: 1]; });
+    pl_bench_scan(db, "boolForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs boolForColumnIndex: 1]; });
+    pl_bench_scan(db, "floatForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs floatForColumnIndex: 2]; });
+    pl_bench_scan(db, "doubleForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs doubleForColumnIndex: 2]; });
+    pl_bench_scan(db, "dateForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs dateForColumnIndex: 2]; });
+    pl_bench_scan(db, "stringForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs stringForColumnIndex: 3]; });
+    pl_bench_scan(db, "dataForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs dataForColumnIndex: 4]; });
+    pl_bench_scan(db, "UTF8StringForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs UTF8StringForColumnIndex: 3 length: NULL]; });
+    pl_bench_scan(db, "borrowedStringForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs borrowedStringForColumnIndex: 3]; });
+    pl_bench_scan(db, "borrowedDataForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs borrowedDataForColumnIndex: 4]; });
+    pl_bench_scan(db, "isNullForColumnIndex", rows, width, ^(id<PLResultSet> rs) { [rs isNullForColumnIndex: 5]; });
+    pl_bench_scan(db, "objectForColumnIndex (integer)", rows, width, ^(id<PLResultSet> rs) { [rs objectForColumnIndex: 1]; });
+    pl_bench_scan(db, "objectForColumnIndex (text)", rows, width, ^(id<PLResultSet> rs) { [rs objectForColumnIndex: 3]; });
+    pl_bench_scan(db, "intForColumn (by name)", rows, width, ^(id<PLResultSet> rs) { [rs intForColumn: @"i"]; });
+
+    /* Unchecked accessors; validation occurs once per result set */
+    pl_bench_fast_scan(db, "PLSqliteFastAccessBigInt", rows, width, ^(PLSqliteResultSetFastAccess *fa) { PLSqliteFastAccessBigInt(fa, 1); });
+    pl_bench_fast_scan(db, "PLSqliteFastAccessDouble", rows, width, ^(PLSqliteResultSetFastAccess *fa) { PLSqliteFastAccessDouble(fa, 2); });
+    pl_bench_fast_scan(db, "PLSqliteFastAccessUTF8String", rows, width, ^(PLSqliteResultSetFastAccess *fa) { PLSqliteFastAccessUTF8String(fa, 3, NULL); });
+    pl_bench_fast_scan(db, "PLSqliteFastAccessBlob", rows, width, ^(PLSqliteResultSetFastAccess *fa) { PLSqliteFastAccessBlob(fa, 4, NULL); });
+    pl_bench_fast_scan(db, "PLSqliteFastAccessIsNull", rows, width, ^(PLSqliteResultSetFastAccess *fa) { PLSqliteFastAccessIsNull(fa, 5); });
+    pl_bench_fast_scan(db, "sqlite3_column_int64 (raw)", rows, width, ^(PLSqliteResultSetFastAccess *fa) { sqlite3_column_int64(fa->stmt, 1); });
+}
+
+/*
+ * SUM(i), SUM(d) aggregation over the 'bench' table, via the per-row accessors and via
+ * -[PLSqliteResultSet fetchColumns:intoBuffers:columnCount:maxRows:rowsFetched:error:].
+ */
+static void pl_bench_aggregate (PLSqliteDatabase *db, int rows, int width) {
+    __block volatile double sink = 0;
+
+    pl_bench_run("aggregate (row accessors)", rows, width, rows, ^{
+        id<PLResultSet> rs = [db executeQuery: @"SELECT i, d FROM bench"];
+        int64_t isum = 0;
+        double dsum = 0;
+        while ([rs nextAndReturnError: NULL] == PLResultSetStatusRow) {
+            isum += [rs bigIntForColumnIndex: 0];
+            dsum += [rs doubleForColumnIndex: 1];
+        }
+        [rs close];
+        sink = isum + dsum;
+    });
+
+    pl_bench_run("aggregate (fetchColumns)", rows, width, rows, ^{
+        int64_t ivalues[PL_BENCH_FETCH_CHUNK];
+        double dvalues[PL_BENCH_FETCH_CHUNK];
+        int columns[] = { 0, 1 };
+        PLResultSetColumnBuffer buffers[] = {
+            { PLResultSetColumnBufferTypeInt64, ivalues, NULL },
+            { PLResultSetColumnBufferTypeDouble, dvalues, NULL }
+        };
+
+        id<PLResultSet> rs = [db executeQuery: @"SELECT i, d FROM bench"];
+        int64_t isum = 0;
+        double dsum = 0;
+        NSUInteger count;
+        PLResultSetStatus status;
+        do {
+            status = [rs fetchColumns: columns intoBuffers: buffers columnCount: 2 maxRows: PL_BENCH_FETCH_CHUNK rowsFetched: &count error: NULL];
+            for (NSUInteger i = 0; i < count; i++) {
+                isum += ivalues[i];
+                dsum += dvalues[i];
+            }
+        } while (status == PLResultSetStatusRow);
+        [rs close];
+        sink = isum + dsum;
+    });
+}
+
+/* Destination struct for the row decoding benchmark. */
+typedef struct PLBenchRow {
+    int64_t id;
+    int64_t i;
+    double d;
+    char t[32];
+    BOOL nIsNull;
+} PLBenchRow;
+
+/* Materialization of the 'bench' table into PLBenchRow structs, via objectForColumnIndex: and via a PLRowMapping. */
+static void pl_bench_decode_rows (PLSqliteDatabase *db, int rows, int width) {
+    static const PLRowMappingField fields[] = {
+        { "id", PLRowMappingFieldTypeInt64, offsetof(PLBenchRow, id), 0 },
+        { "i", PLRowMappingFieldTypeInt64, offsetof(PLBenchRow, i), 0 },
+        { "d", PLRowMappingFieldTypeDouble, offsetof(PLBenchRow, d), 0 },
+        { "t", PLRowMappingFieldTypeUTF8Buffer, offsetof(PLBenchRow, t), sizeof(((PLBenchRow *) 0)->t) },
+        { "n", PLRowMappingFieldTypeIsNull, offsetof(PLBenchRow, nIsNull), 0 }
+    };
+    PLRowMapping *mapping = [PLRowMapping mappingWithFields: fields count: sizeof(fields) / sizeof(fields[0])];
+    PLBenchRow *output = malloc(sizeof(PLBenchRow) * PL_BENCH_FETCH_CHUNK);
+
+    pl_bench_run("decode rows (objectForColumnIndex)", rows, width, rows, ^{
+        id<PLResultSet> rs = [db executeQuery: @"SELECT id, i, d, t, n FROM bench"];
+        NSUInteger row = 0;
+        while ([rs nextAndReturnError: NULL] == PLResultSetStatusRow) {
+            PLBenchRow *r = &output[row++ % PL_BENCH_FETCH_CHUNK];
+            r->id = [[rs objectForColumnIndex: 0] longLongValue];
+            r->i = [[rs objectForColumnIndex: 1] longLongValue];
+            r->d = [[rs objectForColumnIndex: 2] doubleValue];
+            [[rs objectForColumnIndex: 3] getCString: r->t maxLength: sizeof(r->t) encoding: NSUTF8StringEncoding];
+            r->nIsNull = [rs objectForColumnIndex: 4] == nil;
+        }
+        [rs close];
+    });
+
+    pl_bench_run("decode rows (PLRowMapping)", rows, width, rows, ^{
+        id<PLResultSet> rs = [db executeQuery: @"SELECT id, i, d, t, n FROM bench"];
+        while ([rs decodeRowsWithMapping: mapping into: output stride: sizeof(PLBenchRow) maxRows: PL_BENCH_FETCH_CHUNK rowsDecoded: NULL error: NULL] == PLResultSetStatusRow)
+            ;
+        [rs close];
+    });
+
+    pl_bench_run("enumerateBatchesOfSize", rows, width, rows, ^{
+        __block int64_t sum = 0;
+        id<PLResultSet> rs = [db executeQuery: @"SELECT id, i, d, t, n FROM bench"];
+        [rs enumerateBatchesOfSize: PL_BENCH_FETCH_CHUNK mapping: mapping stride: sizeof(PLBenchRow) error: NULL block: ^(const void *batch, NSUInteger count, BOOL *stop) {
+            const PLBenchRow *r = batch;
+            for (NSUInteger n = 0; n < count; n++)
+                sum += r[n].i;
+        }];
+        [rs close];
+    });
+
+    free(output);
+}
+
+/*
+ * PLSqliteStatementCache check-in and check-out, with each of @a threads threads repeatedly closing (and re-fetching)
+ * a statement for its own query against a single shared cache. If @a useEntry is YES, statements are checked in via their
+ * cache entry, as is done by PLSqlitePreparedStatement; otherwise, they are checked in by query string.
+ */
+static void pl_bench_statement_cache (PLSqliteDatabase *db, const char *name, int threads, BOOL useEntry) {
+    sqlite3 *sqlite = [db sqliteHandle];
+    PLSqliteStatementCache *cache = [[PLSqliteStatementCache alloc] initWithCapacity: [[PLSqliteDatabaseOptions defaultOptions] statementCacheCapacity]];
+
+    pl_bench_run_threads(name, threads, PL_BENCH_CONTENTION_OPS, ^(int thread) {
+        NSString *query = [NSString stringWithFormat: @"SELECT %d", thread];
+        PLSqliteStatementCacheEntry *entry;
+        sqlite3_stmt *stmt;
+        const char *unused;
+
+        stmt = [cache checkoutStatementForQueryString: query cacheEntry: &entry];
+        if (stmt == NULL) {
+            if (sqlite3_prepare_v2(sqlite, [query UTF8String], -1, &stmt, &unused) != SQLITE_OK) {
+                fprintf(stderr, "Could not prepare benchmark statement\n");
+                exit(EXIT_FAILURE);
+            }
+            [cache registerStatement: stmt];
+        }
+
+        for (int i = 0; i < PL_BENCH_CONTENTION_OPS; i++) {
+            if (useEntry) {
+                [cache checkinStatement: stmt forCacheEntry: entry];
+                stmt = [cache checkoutStatementForCacheEntry: entry];
+            } else {
+                [cache checkinStatement: stmt forQuery: query];
+                stmt = [cache checkoutStatementForQueryString: query];
+            }
+        }
+
+        [cache checkinStatement: stmt forCacheEntry: entry];
+        [entry release];
+    });
+
+    [cache close];
+    [cache release];
+}
+
+/* Statement cache contention, as a function of the number of threads closing statements. */
+static void pl_bench_statement_cache_contention (void) {
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:"];
+    if (![db open]) {
+        fprintf(stderr, "Could not open benchmark database\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+        pl_bench_statement_cache(db, "statement cache (query string)", PLBenchThreadCounts[t], NO);
+        pl_bench_statement_cache(db, "statement cache (cache entry)", PLBenchThreadCounts[t], YES);
+    }
+
+    [db close];
+}
+
+/* Concurrent durable inserts, each committed in its own transaction on a per-thread connection, or grouped by a
+ * PLGroupCommitWriter */
+static void pl_bench_group_commit_contention (void) {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"PLDatabaseBenchmark-writes.db"];
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+
+    PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: path];
+    if (![db open] || ![db executeUpdate: @"CREATE TABLE writes (a integer, t text)"]) {
+        fprintf(stderr, "Could not open benchmark database\n");
+        exit(EXIT_FAILURE);
+    }
+
+    NSString *text = pl_bench_string(16);
+    for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+        int threads = PLBenchThreadCounts[t];
+
+        pl_bench_run_threads("durable insert (autocommit)", threads, PL_BENCH_WRITE_OPS, ^(int thread) {
+            PLSqliteDatabase *conn = [PLSqliteDatabase databaseWithPath: path];
+            if (![conn open])
+                abort();
+
+            for (int i = 0; i < PL_BENCH_WRITE_OPS; i++) {
+                NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+                if (![conn executeUpdate: @"INSERT INTO writes (a, t) VALUES (?, ?)", [NSNumber numberWithInt: i], text])
+                    abort();
+                [pool drain];
+            }
+
+            [conn close];
+        });
+
+        PLGroupCommitWriter *writer = [[PLGroupCommitWriter alloc] initWithDatabase: db maxBatchSize: 64 maxLatency: 0.001];
+        pl_bench_run_threads("durable insert (group commit)", threads, PL_BENCH_WRITE_OPS, ^(int thread) {
+            for (int i = 0; i < PL_BENCH_WRITE_OPS; i++) {
+                NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+                NSArray *params = [NSArray arrayWithObjects: [NSNumber numberWithInt: i], text, nil];
+                if (![writer executeUpdate: @"INSERT INTO writes (a, t) VALUES (?, ?)" parameters: params error: NULL])
+                    abort();
+                [pool drain];
+            }
+        });
+        [writer close];
+        [writer release];
+    }
+
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+/* Concurrent failing updates without an NSError, as issued by contended retry loops, on per-thread connections sharing
+ * each error sink */
+static void pl_bench_error_path (void) {
+    PLSqliteLogErrorSink *logAll = [[[PLSqliteLogErrorSink alloc] initWithMaxReports: NSUIntegerMax interval: 1.0] autorelease];
+    id<PLSqliteErrorSink> sinks[] = { logAll, [PLSqliteLogErrorSink defaultSink], nil };
+    const char *names[] = { "failed update (log every error)", "failed update (rate-limited log)", "failed update (no error sink)" };
+
+    for (size_t s = 0; s < sizeof(sinks) / sizeof(sinks[0]); s++) {
+        PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+        options.errorSink = sinks[s];
+
+        for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+            pl_bench_run_threads(names[s], PLBenchThreadCounts[t], PL_BENCH_ERROR_OPS, ^(int thread) {
+                PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: @":memory:" options: options];
+                if (![db open])
+                    abort();
+
+                for (int i = 0; i < PL_BENCH_ERROR_OPS; i++) {
+                    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+                    if ([db executeUpdate: @"INSERT INTO missing (a) VALUES (1)"])
+                        abort();
+                    [pool drain];
+                }
+
+                [db close];
+            });
+        }
+    }
+}
+
+/* Pool acquire/release round trips, with an unbounded pool and with a pool bounded below the thread count */
+static void pl_bench_pool_contention (void) {
+    PLSqliteConnectionProvider *provider = [[[PLSqliteConnectionProvider alloc] initWithPath: @":memory:"] autorelease];
+
+    for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+        int threads = PLBenchThreadCounts[t];
+        PLDatabasePoolConnectionProvider *unbounded = [[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: provider capacity: 0];
+        PLDatabasePoolConnectionProvider *bounded = [[PLDatabasePoolConnectionProvider alloc] initWithConnectionProvider: provider
+                                                                                                                capacity: 0
+                                                                                                          maxConnections: 2
+                                                                                                          acquireTimeout: -1];
+
+        for (int b = 0; b < 2; b++) {
+            PLDatabasePoolConnectionProvider *connections = (b == 0) ? unbounded : bounded;
+            pl_bench_run_threads(b == 0 ? "pool acquire/release (unbounded)" : "pool acquire/release (max 2)", threads, PL_BENCH_CONTENTION_OPS, ^(int thread) {
+                for (int i = 0; i < PL_BENCH_CONTENTION_OPS; i++) {
+                    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+                    id<PLDatabase> db = [connections getConnectionAndReturnError: NULL];
+                    if (db == nil)
+                        abort();
+                    [connections closeConnection: db];
+                    [pool drain];
+                }
+            });
+        }
+
+        [unbounded release];
+        [bounded release];
+    }
+}
+
+/* Concurrent read-modify-write transactions on separate connections: deferred transactions with immediate retry, which
+ * deadlock on lock upgrade, versus BEGIN IMMEDIATE with exponential backoff */
+static void pl_bench_transaction_contention (void) {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"PLDatabaseBenchmark-tx.db"];
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+
+    PLSqliteDatabase *setup = [PLSqliteDatabase databaseWithPath: path];
+    if (![setup open] || ![setup executeUpdate: @"CREATE TABLE counters (id integer PRIMARY KEY, n integer)"] ||
+        ![setup executeUpdate: @"INSERT INTO counters (id, n) VALUES (1, 0)"])
+    {
+        fprintf(stderr, "Could not open benchmark database\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int variant = 0; variant < 2; variant++) {
+        PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+        options.errorSink = nil;
+        options.retryPolicy = (variant == 0) ? [PLSqliteRetryPolicy defaultPolicy] : [PLSqliteRetryPolicy backoffPolicy];
+        PLDatabaseIsolationLevel level = (variant == 0) ? PLDatabaseIsolationLevelReadCommitted : PLDatabaseIsolationLevelImmediate;
+
+        for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+            pl_bench_run_threads(variant == 0 ? "transaction (deferred, retry)" : "transaction (immediate, backoff)", PLBenchThreadCounts[t], PL_BENCH_WRITE_OPS, ^(int thread) {
+                PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: path options: options];
+                if (![db open])
+                    abort();
+
+                for (int i = 0; i < PL_BENCH_WRITE_OPS; i++) {
+                    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+                    [db performTransactionWithIsolationLevel: level retryBlock: ^PLDatabaseTransactionResult {
+                        id<PLResultSet> rs = [db executeQuery: @"SELECT n FROM counters WHERE id = 1"];
+                        if (rs == nil || ![rs next])
+                            return PLDatabaseTransactionRollback;
+                        int n = [rs intForColumnIndex: 0];
+                        [rs close];
+
+                        if (![db executeUpdate: @"UPDATE counters SET n = ? WHERE id = 1", [NSNumber numberWithInt: n + 1]])
+                            return PLDatabaseTransactionRollback;
+                        return PLDatabaseTransactionCommit;
+                    } error: NULL];
+                    [pool drain];
+                }
+
+                [db close];
+            });
+        }
+    }
+
+    [setup close];
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+/* Concurrent autocommit inserts from per-thread connections, comparing the default busy policy sleep curve against a
+ * finer-grained curve, and reporting the worst busy wait observed by any connection */
+static void pl_bench_busy_contention (void) {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"PLDatabaseBenchmark-busy.db"];
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+
+    PLSqliteDatabase *setup = [PLSqliteDatabase databaseWithPath: path];
+    if (![setup open] || ![setup executeUpdate: @"CREATE TABLE busy (id integer PRIMARY KEY, n integer)"]) {
+        fprintf(stderr, "Could not open benchmark database\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int variant = 0; variant < 2; variant++) {
+        const char *name = (variant == 0) ? "busy wait (default curve)" : "busy wait (fine curve)";
+        PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+        options.errorSink = nil;
+        if (variant == 1) {
+            PLSqliteBusyPolicy *policy = [PLSqliteBusyPolicy defaultPolicy];
+            policy.initialSleep = 0.0001;
+            policy.maxSleep = 0.002;
+            options.busyPolicy = policy;
+        }
+
+        for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+            __block uint64_t waits = 0;
+            __block uint64_t maxWaitUsec = 0;
+
+            pl_bench_run_threads(name, PLBenchThreadCounts[t], PL_BENCH_WRITE_OPS, ^(int thread) {
+                PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: path options: options];
+                if (![db open])
+                    abort();
+
+                for (int i = 0; i < PL_BENCH_WRITE_OPS; i++) {
+                    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+                    if (![db executeUpdate: @"INSERT INTO busy (n) VALUES (?)", [NSNumber numberWithInt: i]])
+                        abort();
+                    [pool drain];
+                }
+
+                PLSqliteBusyMetrics metrics = [db busyMetrics];
+                uint64_t maxUsec = (uint64_t) (metrics.maxWaitTime * 1e6);
+                uint64_t current;
+                __sync_fetch_and_add(&waits, metrics.waitCount);
+                do {
+                    current = maxWaitUsec;
+                } while (maxUsec > current && !__sync_bool_compare_and_swap(&maxWaitUsec, current, maxUsec));
+
+                [db close];
+            });
+
+            if (pl_bench_filter == NULL || strstr(name, pl_bench_filter) != NULL) {
+                printf("%-36s threads=%-3d %14llu waits %12.3f ms max wait\n", name, PLBenchThreadCounts[t],
+                       (unsigned long long) waits, (double) maxWaitUsec / 1e3);
+                fflush(stdout);
+            }
+        }
+    }
+
+    [setup close];
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+/* Autocommit inserts and point reads on a file database, comparing SQLite's defaults against the tuning presets */
+static void pl_bench_tuning_profiles (void) {
+    const char *insertNames[] = { "tuning insert (defaults)", "tuning insert (durable)", "tuning insert (throughput)" };
+    const char *queryNames[] = { "tuning query (defaults)", "tuning query (durable)", "tuning query (throughput)" };
+    PLSqliteTuningProfile *profiles[] = { nil, [PLSqliteTuningProfile durableProfile], [PLSqliteTuningProfile throughputProfile] };
+    NSString *text = pl_bench_string(16);
+
+    for (int variant = 0; variant < 3; variant++) {
+        NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"PLDatabaseBenchmark-tuning.db"];
+        for (NSString *suffix in [NSArray arrayWithObjects: @"", @"-wal", @"-shm", nil])
+            [[NSFileManager defaultManager] removeItemAtPath: [path stringByAppendingString: suffix] error: NULL];
+
+        PLSqliteDatabaseOptions *options = [PLSqliteDatabaseOptions defaultOptions];
+        options.tuningProfile = profiles[variant];
+
+        PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: path options: options];
+        if (![db open] || ![db executeUpdate: @"CREATE TABLE tuning (id integer PRIMARY KEY, t text)"]) {
+            fprintf(stderr, "Could not open benchmark database\n");
+            exit(EXIT_FAILURE);
+        }
+
+        /* Seed the rows read by the query benchmark */
+        [db beginTransaction];
+        for (int i = 0; i < 1000; i++)
+            [db executeUpdate: @"INSERT INTO tuning (id, t) VALUES (?, ?)", [NSNumber numberWithInt: i], text];
+        [db commitTransaction];
+
+        __block int next = 1000;
+        pl_bench_run(insertNames[variant], PL_BENCH_WRITE_OPS, 16, PL_BENCH_WRITE_OPS, ^{
+            for (int i = 0; i < PL_BENCH_WRITE_OPS; i++) {
+                if (![db executeUpdate: @"INSERT INTO tuning (id, t) VALUES (?, ?)", [NSNumber numberWithInt: next++], text])
+                    abort();
+            }
+        });
+
+        pl_bench_run(queryNames[variant], 1000, 16, PL_BENCH_WRITE_OPS, ^{
+            for (int i = 0; i < PL_BENCH_WRITE_OPS; i++) {
+                id<PLResultSet> rs = [db executeQuery: @"SELECT t FROM tuning WHERE id = ?", [NSNumber numberWithInt: (i * 7919) % 1000]];
+                if (rs == nil || ![rs next])
+                    abort();
+                [rs close];
+            }
+        });
+
+        [db close];
+        for (NSString *suffix in [NSArray arrayWithObjects: @"", @"-wal", @"-shm", nil])
+            [[NSFileManager defaultManager] removeItemAtPath: [path stringByAppendingString: suffix] error: NULL];
+    }
+}
+
+/* Concurrent point reads, via per-thread connections, or via the read-only connections of a WAL reader pool */
+static void pl_bench_read_pool_contention (void) {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"PLDatabaseBenchmark-reads.db"];
+    for (NSString *suffix in [NSArray arrayWithObjects: @"", @"-wal", @"-shm", nil])
+        [[NSFileManager defaultManager] removeItemAtPath: [path stringByAppendingString: suffix] error: NULL];
+
+    PLSqliteReadWriteConnectionProvider *provider = [[PLSqliteReadWriteConnectionProvider alloc] initWithPath: path readerCapacity: 0];
+    id<PLDatabase> writer = [provider getWriteConnectionAndReturnError: NULL];
+    if (writer == nil || ![writer executeUpdate: @"CREATE TABLE reads (id integer PRIMARY KEY, t text)"]) {
+        fprintf(stderr, "Could not open benchmark database\n");
+        exit(EXIT_FAILURE);
+    }
+
+    NSString *text = pl_bench_string(16);
+    [writer beginTransaction];
+    for (int i = 0; i < 1000; i++)
+        [writer executeUpdate: @"INSERT INTO reads (id, t) VALUES (?, ?)", [NSNumber numberWithInt: i], text];
+    [writer commitTransaction];
+
+    void (^read)(id<PLDatabase>, int) = ^(id<PLDatabase> db, int i) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        id<PLResultSet> rs = [db executeQuery: @"SELECT t FROM reads WHERE id = ?", [NSNumber numberWithInt: i % 1000]];
+        if (rs == nil || ![rs next])
+            abort();
+        [rs close];
+        [pool drain];
+    };
+
+    for (size_t t = 0; t < sizeof(PLBenchThreadCounts) / sizeof(PLBenchThreadCounts[0]); t++) {
+        int threads = PLBenchThreadCounts[t];
+
+        pl_bench_run_threads("point read (per-thread connection)", threads, PL_BENCH_READ_OPS, ^(int thread) {
+            PLSqliteDatabase *db = [PLSqliteDatabase databaseWithPath: path];
+            if (![db open])
+                abort();
+
+            for (int i = 0; i < PL_BENCH_READ_OPS; i++)
+                read(db, i);
+
+            [db close];
+        });
+
+        pl_bench_run_threads("point read (reader pool)", threads, PL_BENCH_READ_OPS, ^(int thread) {
+            id<PLDatabase> reader = [provider getReadConnectionAndReturnError: NULL];
+            if (reader == nil)
+                abort();
+
+            for (int i = 0; i < PL_BENCH_READ_OPS; i++)
+                read(reader, i);
+
+            [provider closeConnection: reader];
+        });
+    }
+
+    [provider closeConnection: writer];
+    [provider release];
+    for (NSString *suffix in [NSArray arrayWithObjects: @"", @"-wal", @"-shm", nil])
+        [[NSFileManager defaultManager] removeItemAtPath: [path stringByAppendingString: suffix] error: NULL];
+}
+
+int main (int argc, const char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+    if (argc > 1)
+        pl_bench_filter = argv[1];
+
+    printf("# PLDatabaseBenchmark (SQLite %s)\n", sqlite3_libversion());
+
+    for (size_t r = 0; r < sizeof(PLBenchRowCounts) / sizeof(PLBenchRowCounts[0]); r++) {
+        for (size_t w = 0; w < sizeof(PLBenchColumnWidths) / sizeof(PLBenchColumnWidths[0]); w++) {
+            NSAutoreleasePool *fixturePool = [[NSAutoreleasePool alloc] init];
+            int rows = PLBenchRowCounts[r];
+            int width = PLBenchColumnWidths[w];
+
+            PLSqliteDatabase *db = pl_bench_fixture(rows, width);
+            pl_bench_execute_query(db, rows, width);
+            pl_bench_execute_update(db, rows, width);
+            pl_bench_execute_update_named(db, rows, width);
+            pl_bench_execute_update_typed(db, "executeUpdate (typed binders)", rows, width, PLPreparedStatementBindingModeCopy);
+            pl_bench_execute_update_typed(db, "executeUpdate (typed, borrowed)", rows, width, PLPreparedStatementBindingModeBorrow);
+            pl_bench_execute_batch(db, rows, width);
+            pl_bench_result_set(db, rows, width);
+            pl_bench_aggregate(db, rows, width);
+            pl_bench_decode_rows(db, rows, width);
+            [db close];
+
+            [fixturePool drain];
+        }
+    }
+
+    pl_bench_statement_cache_contention();
+    pl_bench_error_path();
+    pl_bench_pool_contention();
+    pl_bench_group_commit_contention();
+    pl_bench_transaction_contention();
+    pl_bench_busy_contention();
+    pl_bench_tuning_profiles();
+    pl_bench_read_pool_contention();
+
+    [pool drain];
+    return EXIT_SUCCESS;
+}